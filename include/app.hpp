@@ -2,16 +2,29 @@
 #define APP_HPP
 
 #include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include "dictionary.hpp"
+#include "dictionary_set.hpp"
+#include "language_model.hpp"
+#include "reloader.hpp"
 
 class App {
    private:
-    std::unique_ptr<Dictionary> dict;
+    std::unique_ptr<Reloader> reloader;
+    std::unique_ptr<DictionarySet> set;  // Several files queried together, replaces `reloader`
     bool loaded = false;
     bool running = false;
     bool silent = false;
+    bool audit = false;  // Cross-check the statistics with a full walk on every `stats`
+
+    // Applied again to every reloaded dictionary, read by the watcher thread under the mutex
+    mutable std::mutex settings_mutex;
+    Config settings;
+    size_t cache_capacity = 0;
+    std::shared_ptr<const Language::Model> model;
 
    public:
     App(bool silent = false);
@@ -19,7 +32,14 @@ class App {
     ~App() = default;
 
     bool load(const std::string &filepath);
+    bool load(const std::vector<std::string> &filepaths);
+    bool open_journal(const std::string &journal_path, const std::string &base_path);
+    bool watch();
+    void set_cache_capacity(size_t capacity);
+    void set_audit(bool audit);
+    bool set_language_model(const std::string &model_path);
     void run();
+    bool serve(const std::string &socket_path, int port = 0, size_t worker_count = 0);
 
    private:
     bool terminate(const std::string &input) const;
@@ -28,6 +48,10 @@ class App {
     bool parse_command(const std::string &command);
     void show_docs() const;
     void show_stats() const;
+    void check(const std::string &text) const;
+    void reload();
+    bool prepare(Dictionary &dict) const;
+    bool single(const std::string &feature) const;
     void clear() const;
     void config();
 };
@@ -1,29 +1,44 @@
 #ifndef BK_NODE_HPP
 #define BK_NODE_HPP
 
+#include <cstdint>
 #include <memory>
-#include <unordered_map>
 
 #include "word.hpp"
 
 namespace BK {
 
+// Node of a flattened BK-tree. Nodes live in one vector and refer to each other by index;
+// the children of a node form a sibling list sorted by edge distance
 class Node {
    private:
-    std::unordered_map<int, std::unique_ptr<Node>> children;
     std::shared_ptr<Word> word;
+    int distance;           // Edge distance from the parent
+    uint32_t first_child;   // Child with the smallest edge distance
+    uint32_t next_sibling;  // Next child of the same parent, larger edge distance
+    uint16_t min_length;    // Shortest word in this subtree, in the units of the tree's metric
+    uint16_t max_length;    // Longest word in this subtree
 
    public:
-    Node(std::shared_ptr<Word> word);
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    Node(std::shared_ptr<Word> word, int distance = 0);
+    Node(std::shared_ptr<Word> word, int distance, uint16_t length);  // Length in other units
     ~Node() = default;
 
     std::shared_ptr<Word> get_word() const;
-
-    Node *set_child(int distance, std::shared_ptr<Word> new_word);
-    Node *get_child(int distance) const;
-    bool has_child(int distance) const;
-
-    const std::unordered_map<int, std::unique_ptr<Node>> &get_children() const;
+    void set_word(std::shared_ptr<Word> word);  // Same text only, the edges depend on it
+    int get_distance() const;
+
+    uint32_t get_first_child() const;
+    uint32_t get_next_sibling() const;
+    void set_first_child(uint32_t index);
+    void set_next_sibling(uint32_t index);
+    bool is_leaf() const;
+
+    uint16_t get_min_length() const;
+    uint16_t get_max_length() const;
+    void extend_length(uint16_t min_length, uint16_t max_length);
 
    private:
 };
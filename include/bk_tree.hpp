@@ -1,44 +1,96 @@
 #ifndef BK_TREE_HPP
 #define BK_TREE_HPP
 
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <memory>
+#include <random>
 #include <string>
 #include <vector>
 
 #include "bk_node.hpp"
+#include "distance.hpp"
+#include "generator.hpp"
 
 namespace BK {
 
-class Tree {
+// Character counts of a word, used as a cheap edit distance lower bound
+using Histogram = std::array<int, 32>;
+
+// BK-tree over any edit distance policy from distance.hpp. Distances passed in and stored are in
+// ordinary edits, scaled by Metric::unit internally. Policies that are not metrics still work
+// but lose the triangle inequality pruning, searches then fall back to length filtered scans
+template <typename Metric = Distance::Levenshtein>
+class BasicTree {
    private:
-    std::unique_ptr<Node> root;
-    size_t memory_usage = 0;
-    bool stable = true;
-    int height = 0;
+    std::vector<Node> nodes;  // nodes[0] is the root
+    Metric metric;
+    int height = 0;  // Maintained by insert and build
+
+    // Removed words keep their node so the edges below stay valid, they are only skipped when
+    // reporting results. Rebuilding the tree is the only way to reclaim them
+    std::vector<bool> tombstones;
+    size_t tombstone_count = 0;
+
+    // Search effort, shared by concurrent readers
+    mutable std::atomic<uint64_t> visited_nodes = 0;
+    mutable std::atomic<uint64_t> query_count = 0;
 
    public:
-    Tree() : root(nullptr) {}
-    ~Tree() = default;
+    BasicTree() = default;
+    ~BasicTree() = default;
 
     void insert(std::shared_ptr<Word> word);
+    void build(std::vector<std::shared_ptr<Word>> words);
+
+    // Tombstone every live word with this text, returns how many were found
+    size_t remove(const std::string &text);
 
+    // The `max_searches` closest words within `max_distance`, nearest first then alphabetical.
+    // When more words tie at the cut-off distance than fit, which of them are kept depends on
+    // the tree shape
     std::vector<std::shared_ptr<Word>> search(const std::string &query, int max_distance,
                                               int max_searches) const;
 
-    void set_stable(bool stable);
-    size_t get_memory_usage();
-    int get_height();
+    // Lazy version yielding matches in traversal order, the tree must outlive the generator
+    Generator<std::shared_ptr<Word>> search_stream(std::string query, int max_distance) const;
+
+    size_t get_memory_usage() const;
+    int get_height() const;
+    size_t get_node_count() const;
+    size_t get_tombstone_count() const;
+    double get_average_visits() const;
+    void reset_visits();
+
+    // Check the height, tombstones, edge distances, sibling order and length ranges against a
+    // full walk
+    bool audit() const;
 
    private:
-    void search_core(const Node *node, const std::string &query, int max_distance,
+    uint32_t add_node(std::shared_ptr<Word> word, int distance, uint32_t parent);
+    size_t select_pivot(const std::vector<std::shared_ptr<Word>> &words, size_t begin, size_t end,
+                        std::mt19937_64 &rng) const;
+    void search_core(const std::string &query, int max_distance,
                      std::vector<std::pair<std::shared_ptr<Word>, int>> &results,
-                     int max_searches) const;
+                     int max_searches, size_t &visited) const;
+    bool can_skip(const Node &node, const std::string &query, const Histogram &histogram,
+                  int max_distance) const;
+    void push_children(const Node &node, int distance, size_t query_length, int max_distance,
+                       std::vector<uint32_t> &stack) const;
 
-    int calculate_distance(const std::string &s1, const std::string &s2) const;
-    size_t calculate_memory_usage(const Node *node) const;
-    int calculate_height(const Node *node) const;
+    int calculate_height() const;
 };
 
+// Explicitly instantiated in bk_tree.cpp for the policies of distance.hpp
+extern template class BasicTree<Distance::Levenshtein>;
+extern template class BasicTree<Distance::Unicode>;
+extern template class BasicTree<Distance::Damerau>;
+extern template class BasicTree<Distance::Keyboard>;
+
+using Tree = BasicTree<Distance::Levenshtein>;
+using UnicodeTree = BasicTree<Distance::Unicode>;
+
 };  // namespace BK
 
 #endif
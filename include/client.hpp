@@ -0,0 +1,30 @@
+#ifndef CLIENT_HPP
+#define CLIENT_HPP
+
+#include <string>
+#include <vector>
+
+// Blocking client for the server line protocol
+class Client {
+   private:
+    int fd = -1;
+    std::string buffer;
+
+   public:
+    Client() = default;
+    ~Client();
+
+    Client(const Client &) = delete;
+    Client &operator=(const Client &) = delete;
+
+    bool connect_unix(const std::string &path);
+    bool connect_tcp(int port);
+    bool is_connected() const;
+    void disconnect();
+
+    bool send_query(const std::string &query);
+    bool receive(std::vector<std::string> &words);
+    bool query(const std::string &query, std::vector<std::string> &words);
+};
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef COMPRESSION_HPP
+#define COMPRESSION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// LZ77 block compression with a shared dictionary, for many small texts of the same kind
+namespace Compression {
+
+// Up to `size` bytes of the content that recurs most across `samples`, meant as the dictionary
+// of a Codec. Segments are picked greedily, one per stretch of the samples, by how frequent
+// their 8 byte substrings are, and substrings already covered stop counting (COVER, as zstd
+// trains its dictionaries)
+std::string train(const std::vector<std::string_view> &samples, size_t size);
+
+// LZ4 style sequences: a token with the literal and match lengths, the literals, a two byte
+// offset. The dictionary is history in front of every block, so a block can refer to it as if
+// it had seen it already, which is what makes blocks of a few kilobytes compress well
+class Codec {
+   private:
+    std::string dictionary;
+    std::vector<uint32_t> dictionary_table;  // Hash of four bytes to their last position + 1
+
+   public:
+    Codec(std::string dictionary = "");
+    ~Codec() = default;
+
+    void compress(std::string_view input, std::string &output) const;
+
+    // `size` is the decompressed size, false when the input does not decode to exactly that
+    bool decompress(std::string_view input, size_t size, std::string &output) const;
+
+    const std::string &get_dictionary() const;
+    size_t get_memory_usage() const;  // The dictionary and the hash table over it
+};
+
+};  // namespace Compression
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef CSV_HPP
+#define CSV_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// RFC 4180 tokenizer for the dictionary files
+namespace Csv {
+
+// Bitmasks of one 64 byte block, bit i for byte i
+struct Block {
+    uint64_t quotes;
+    uint64_t commas;
+    uint64_t newlines;
+};
+
+// SSE2 compares when available, a byte loop otherwise
+Block scan(const char *block);
+
+// Splits a buffer into records of fields. Quotes are tracked across whole blocks with a prefix
+// XOR of the quote mask, so commas and newlines inside quoted fields never need a byte by byte
+// look. Fields are views into the buffer: quoted ones are unescaped in place, which is why the
+// buffer is taken by non-const reference and must outlive the views
+class Parser {
+   private:
+    char *data;
+    size_t size;
+    size_t offset = 0;        // Start of the next field
+    size_t block_start = 0;   // Position of bit 0 of `separators`
+    uint64_t separators = 0;  // Commas and newlines outside quotes not consumed yet
+    bool in_quotes = false;   // Quote state carried into the next block
+    bool scanned = false;     // The block at `block_start` has been scanned
+
+   public:
+    Parser(std::string &buffer);
+    ~Parser() = default;
+
+    // False once the buffer is exhausted. A final line without '\n' still counts, "\r\n" works
+    bool next(std::vector<std::string_view> &fields);
+    size_t get_offset() const;
+
+   private:
+    size_t next_separator();
+};
+
+// Strips the quotes of a field and turns doubled quotes inside them into one, moving bytes within
+// the field. Stray quotes in the middle of a field toggle quoting like the block scan assumes
+std::string_view unquote(char *begin, char *end);
+
+};  // namespace Csv
+
+#endif
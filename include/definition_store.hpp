@@ -0,0 +1,65 @@
+#ifndef DEFINITION_STORE_HPP
+#define DEFINITION_STORE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "compression.hpp"
+
+// Definitions of many words packed into compressed blocks of consecutive entries. The blocks
+// share one dictionary trained on their content, so a block of a few kilobytes compresses
+// nearly as well as the whole text would. Reading an entry decompresses its block, the last
+// few blocks read stay decompressed
+class DefinitionStore {
+   private:
+    // Raw bytes per block, a fetch decompresses this much
+    static constexpr size_t BLOCK_SIZE = 16 * 1024;
+    static constexpr size_t DICTIONARY_SIZE = 32 * 1024;
+    static constexpr size_t CACHED_BLOCKS = 8;
+
+    struct Block {
+        uint32_t first_entry;
+        uint32_t size;  // Decompressed
+        std::string data;
+    };
+
+    std::vector<Block> blocks;
+    std::string pending;  // Raw block being filled until `seal`
+    uint32_t entry_count = 0;
+    size_t raw_size = 0;
+    bool sealed = false;
+    std::unique_ptr<Compression::Codec> codec;
+
+    // Most recently used first
+    mutable std::mutex cache_mutex;
+    mutable std::vector<std::pair<size_t, std::shared_ptr<const std::string>>> cache;
+
+   public:
+    DefinitionStore() = default;
+    ~DefinitionStore() = default;
+
+    // Entries are numbered in the order they are added, all of them before `seal`
+    uint32_t add(const std::vector<std::string> &definitions);
+
+    // Trains the dictionary and compresses every block, read only afterwards
+    void seal();
+
+    // Safe to call concurrently once sealed
+    std::vector<std::string> get(uint32_t entry) const;
+
+    size_t get_entry_count() const;
+    size_t get_raw_size() const;
+    size_t get_compressed_size() const;  // Blocks and dictionary
+    size_t get_memory_usage() const;     // Including the cached blocks
+
+   private:
+    void close_block();
+    std::shared_ptr<const std::string> load_block(size_t index) const;
+};
+
+#endif
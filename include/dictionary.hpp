@@ -1,13 +1,30 @@
 #ifndef DICTIONARY_HPP
 #define DICTIONARY_HPP
 
+#include <atomic>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "bk_tree.hpp"
+#include "definition_store.hpp"
+#include "generator.hpp"
+#include "interner.hpp"
+#include "journal.hpp"
+#include "language_model.hpp"
+#include "memory.hpp"
+#include "perfect_hash.hpp"
+#include "phonetic.hpp"
+#include "query_cache.hpp"
 #include "trie_tree.hpp"
 #include "word.hpp"
+#include "xor_filter.hpp"
 
 enum class Mode { Search, Suggest, Match, None };
 
@@ -25,36 +42,173 @@ struct Config {
 
 class Dictionary {
    private:
-    std::unique_ptr<Trie::Tree> trie;
-    std::unique_ptr<BK::Tree> bktree;
+    std::unique_ptr<Trie::LowercaseTree> trie;
+    std::atomic<std::shared_ptr<BK::Tree>> bktree;  // Swapped whole by compaction
+
+    // Words with letters beyond a-z, in the UTF-8 key form of utf8.hpp. Kept apart so ASCII
+    // words stay on the bitmap trie and byte distances. The BK-tree is rebuilt under the write
+    // lock and swapped whole, streams keep the one they started on
+    std::unique_ptr<Trie::Tree> wide_trie;
+    std::shared_ptr<BK::UnicodeTree> wide_bktree;
+    std::unique_ptr<Phonetic::Index> phonetic;
+    std::vector<std::shared_ptr<Word>> words;  // Indexed by word ID, nullptr once removed
+    size_t live_count = 0;
+    mutable size_t word_bytes = 0;  // Heap of the live words, see `get_memory_usage`
+
+    // Compressed definitions of loaded words, see `compress_definitions`
+    std::vector<std::shared_ptr<const DefinitionStore>> stores;
+
     std::unique_ptr<Config> config;
-    size_t memory_usage = 0;
-    bool stable = true;
-    int word_count = 0;
-    int trie_height = 0;
-    int bktree_height = 0;
+    std::unique_ptr<QueryCache> cache;
+    std::shared_ptr<Interner> interner;  // Shared with other dictionaries, used by `load`
+    std::shared_ptr<const Language::Model> model;  // Ranks the candidates of `correct`
+
+    // Keys of the words at the last rebuild, plus the ones added since in `recent`. Removed
+    // words linger until the next rebuild, the trie has the final say
+    std::unique_ptr<Filter::Xor8> filter;
+    std::unordered_map<uint64_t, uint32_t> recent;  // Key to word ID
+    size_t lookup_changes = 0;  // Inserts and removes since the last rebuild
+
+    // Word ID of every key in the filter, found without walking the trie
+    std::unique_ptr<PerfectHash::Function> perfect;
+    std::vector<uint32_t> slots;
+
+    // Writers serialize on `write_mutex`. Queries may run concurrently with a compaction but not
+    // with insert, remove or update
+    mutable std::mutex write_mutex;
+    std::thread compactor;
+    bool compacting = false;
+    std::vector<std::pair<bool, std::shared_ptr<Word>>> backlog;  // (inserted, word) meanwhile
+
+    // Mutations are logged once applied, `checkpoint` folds the log back into `base_path`
+    std::shared_ptr<Journal::Log> journal;  // Writers commit on the one they logged to
+    std::string base_path;
+    size_t checkpoint_size = 0;
+    Journal::Stamp checkpoint_stamp;        // `base_path` as the last checkpoint left it
+    std::shared_ptr<Dictionary> successor;  // Took the journal over, writes are passed on
 
    public:
     Dictionary();
     Dictionary(const std::string &filepath);
-    ~Dictionary() = default;
+    ~Dictionary();
+
+    // False for words with anything but letters, which the dictionary cannot store. Texts and
+    // queries are case folded and composed first, see utf8.hpp. With a journal open, the writes
+    // below return once the change is synced and false when it could not be
+    bool insert(std::shared_ptr<Word> word);
+    bool load(const std::string &filepath, bool balanced = true);
+
+    // False when no word has this text. Removed words leave BK-tree tombstones behind, once they
+    // pass a share of the tree it is rebuilt in the background
+    bool remove(const std::string &text);
+    bool update(const std::string &text,
+                const std::vector<std::pair<POS, std::string>> &definitions);
+    void finish_compaction();  // Waits for a background rebuild, from any thread
+
+    // Moves the definitions of words not in a store yet into a new compressed one, after which
+    // they are decompressed per block on demand. `load` does it unless an interner is set, its
+    // words may still be compared by other dictionaries loading at the same time
+    void compress_definitions();
 
-    void insert(std::shared_ptr<Word> word);
-    bool load(const std::string &filepath);
+    // Replays the log at `journal_path` on top of what is loaded, then logs every insert, update
+    // and remove there. Once the log passes `checkpoint_size` bytes (0 never) it is folded into
+    // `base_path`, a CSV file like the ones `load` reads
+    static constexpr size_t DEFAULT_CHECKPOINT_SIZE = 4 * 1024 * 1024;
+    bool open_journal(const std::string &journal_path, const std::string &base_path,
+                      size_t checkpoint_size = DEFAULT_CHECKPOINT_SIZE);
+    bool checkpoint();
+    const Journal::Log *get_journal() const;
 
-    std::vector<std::shared_ptr<Word>> search(const std::string &query) const;
+    // Moves the journal to `next`, which replays it, then calls `publish` to swap `next` in.
+    // Writes wait from the replay until the swap, later ones are passed on to `next`
+    void hand_over(const std::shared_ptr<Dictionary> &next, const std::function<void()> &publish);
+    // Whether `path` is still the file the last checkpoint wrote, a reload would change nothing
+    bool is_checkpoint(const std::string &path) const;
+
+    std::vector<std::shared_ptr<Word>> search(const std::string &query,
+                                              const std::string &after = "") const;
+    Generator<std::shared_ptr<Word>> stream(std::string query) const;
+    Mode recognize(const std::string &query) const;
+
+    // Whether a word with exactly this text is stored. Most absent texts are turned away by the
+    // filter without walking the trie
+    bool contains(const std::string &text) const;
+
+    // Corrections for every token of a sentence, in its order: a known word alone, the fuzzy
+    // results for the others and nothing for tokens that are not words. With a language model
+    // the fuzzy candidates, a wider pool than `search` returns, are ranked by the best reading
+    // of the whole sentence through them, so ties in distance are settled by the neighbours
+    std::vector<std::vector<std::shared_ptr<Word>>> correct(
+        const std::vector<std::string> &sentence) const;
 
-    void set_stable(bool stable);
     void set_config(const Config &cfg);
+    void set_cache_capacity(size_t capacity);
+    void set_interner(std::shared_ptr<Interner> interner);
+    void set_language_model(std::shared_ptr<const Language::Model> model);
 
-    int get_stable() const;
     int get_word_count() const;
-    size_t get_memory_usage();
-    int get_trie_height();
-    int get_bktree_height();
+
+    // Heap bytes by component, O(N). Words already in `counted` are skipped and the rest added
+    // to it, so dictionaries sharing interned words count them once
+    Memory::Usage get_memory_breakdown(std::unordered_set<const Word *> *counted = nullptr) const;
+
+    // Total of the breakdown without `counted`, from figures maintained by every write, so O(1)
+    // in the word count. Words changed other than through `update` make it drift: `audit` then
+    // fails and the next breakdown without `counted` warns and recounts
+    size_t get_memory_usage() const;
+    int get_trie_height() const;
+    int get_bktree_height() const;
+    size_t get_bktree_tombstone_count() const;  // Both trees, until compaction drops them
+    double get_bktree_average_visits() const;
+    const QueryCache *get_cache() const;
+    const Filter::Xor8 &get_filter() const;
+
+    // Deep consistency check of every index against its incremental statistics, O(N)
+    bool audit() const;
 
    private:
-    Mode recognize(const std::string &query) const;
+    static constexpr uint32_t NO_ID = UINT32_MAX;
+
+    // Writers without the lock and the log, shared with the replay
+    bool apply_insert(const std::shared_ptr<Word> &word);
+    std::shared_ptr<Word> apply_remove(const std::string &text);
+    std::shared_ptr<Word> apply_update(const std::string &text,
+                                       const std::vector<std::pair<POS, std::string>> &definitions);
+    bool add(std::shared_ptr<Word> word);
+    void add_id(std::shared_ptr<Word> word);
+    void replace(uint32_t id, std::shared_ptr<Word> word);
+    static bool storable(const std::string &text);
+    void pack_definitions();
+    Memory::Usage get_index_usage() const;
+    bool insert_trie(const std::shared_ptr<Word> &word);
+    std::shared_ptr<Word> search_trie(const std::string &text) const;
+    bool filtered_out(const std::string &text) const;
+    std::shared_ptr<Word> find(const std::string &text) const;
+    uint32_t find_id(const std::string &text) const;
+    uint32_t slot_id(uint64_t key, const std::string &text) const;
+    void refresh_lookup();
+    void rebuild_lookup();
+    // A change handed to the log under the write lock, committed once the lock is released
+    struct Logged {
+        std::shared_ptr<Journal::Log> log;
+        uint64_t sequence = 0;
+        size_t checkpoint_size = 0;
+    };
+    Logged record(Journal::Op op, const Word &word);
+    bool commit(const Logged &logged);
+    bool write_checkpoint();
+    void apply(const Journal::Record &record);
+    void compact_if_needed(const BK::Tree &tree);
+    void compact(std::vector<std::shared_ptr<Word>> live);
+    void compact_wide();
+    void add_phonetic(const std::string &query,
+                      std::vector<std::shared_ptr<Word>> &results) const;
+    std::vector<std::shared_ptr<Word>> search_key(const std::string &query,
+                                                  const std::string &after) const;
+    std::vector<std::shared_ptr<Word>> search_core(const std::string &query, Mode mode,
+                                                   const std::string &after) const;
+    std::vector<std::shared_ptr<Word>> search_fuzzy(const std::string &query, int limit) const;
+    std::string cache_key(const std::string &query, Mode mode, const std::string &after) const;
     Query validate(const std::string &query) const;
 };
 
@@ -0,0 +1,53 @@
+#ifndef DICTIONARY_SET_HPP
+#define DICTIONARY_SET_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "dictionary.hpp"
+#include "interner.hpp"
+#include "memory.hpp"
+#include "word.hpp"
+
+// Several dictionaries queried as one. Results are merged with duplicates dropped: a word found
+// in more than one dictionary comes from the earliest loaded, and words with the same entry in
+// several dictionaries are stored once through a shared interner
+class DictionarySet {
+   private:
+    std::vector<std::unique_ptr<Dictionary>> dictionaries;  // In load order, earlier ones win
+    std::vector<std::string> filepaths;
+    std::shared_ptr<Interner> interner;
+    Config config;
+    size_t cache_capacity = 0;
+
+   public:
+    DictionarySet();
+    ~DictionarySet() = default;
+
+    // Every file gets its own dictionary, loaded on its own thread when `parallel`. Files that
+    // cannot be read are left out and make the result false, the others stay loaded
+    bool load(const std::vector<std::string> &filepaths, bool parallel = true);
+
+    // Exact hits come from the earliest dictionary holding the word. Fuzzy results are ranked by
+    // edit distance, suggestions and matches merged in alphabetical order
+    std::vector<std::shared_ptr<Word>> search(const std::string &query,
+                                              const std::string &after = "") const;
+    Mode recognize(const std::string &query) const;
+    bool contains(const std::string &text) const;
+
+    void set_config(const Config &cfg);
+    void set_cache_capacity(size_t capacity);
+
+    size_t get_dictionary_count() const;
+    const Dictionary &get_dictionary(size_t index) const;
+    const std::string &get_filepath(size_t index) const;
+    int get_word_count() const;  // Distinct texts across every dictionary
+    Memory::Usage get_memory_breakdown() const;  // Shared words and the interner counted once
+    size_t get_memory_usage() const;
+    const Interner &get_interner() const;
+
+    bool audit() const;
+};
+
+#endif
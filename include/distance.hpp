@@ -0,0 +1,67 @@
+#ifndef DISTANCE_HPP
+#define DISTANCE_HPP
+
+#include <string_view>
+
+// Edit distances usable as BK-tree metrics. Each policy reports its costs so the tree can derive
+// lower bounds, whether it satisfies the triangle inequality BK pruning relies on, and whether it
+// counts bytes or UTF-8 code points
+namespace Distance {
+
+int levenshtein(std::string_view s1, std::string_view s2);
+int unicode(std::string_view s1, std::string_view s2);  // Levenshtein over UTF-8 code points
+int damerau(std::string_view s1, std::string_view s2);
+int keyboard(std::string_view s1, std::string_view s2);
+
+// Insertions, deletions and substitutions all cost one
+struct Levenshtein {
+    static constexpr bool is_metric = true;
+    static constexpr int unit = 1;        // Cost of one ordinary edit
+    static constexpr int indel_cost = 1;  // Cost of one insertion or deletion
+    static constexpr int min_cost = 1;    // Cheapest edit of any kind
+    static constexpr bool code_points = false;
+
+    int operator()(std::string_view s1, std::string_view s2) const { return levenshtein(s1, s2); }
+};
+
+// Levenshtein where an edit changes one code point, whatever its UTF-8 length. Equal to the byte
+// version on ASCII, which it hands pure ASCII pairs to
+struct Unicode {
+    static constexpr bool is_metric = true;
+    static constexpr int unit = 1;
+    static constexpr int indel_cost = 1;
+    static constexpr int min_cost = 1;
+    static constexpr bool code_points = true;
+
+    int operator()(std::string_view s1, std::string_view s2) const { return unicode(s1, s2); }
+};
+
+// Optimal string alignment: Levenshtein plus adjacent transpositions ("teh" -> "the") at cost
+// one. It breaks the triangle inequality, so BK-trees must not prune with it
+struct Damerau {
+    static constexpr bool is_metric = false;
+    static constexpr int unit = 1;
+    static constexpr int indel_cost = 1;
+    static constexpr int min_cost = 1;
+    static constexpr bool code_points = false;
+
+    int operator()(std::string_view s1, std::string_view s2) const { return damerau(s1, s2); }
+};
+
+// Substituting a QWERTY neighbour costs half an ordinary edit, every other edit a full one.
+// Costs are doubled to stay integral
+struct Keyboard {
+    static constexpr bool is_metric = true;
+    static constexpr int unit = 2;
+    static constexpr int indel_cost = 2;
+    static constexpr int min_cost = 1;
+    static constexpr bool code_points = false;
+
+    int operator()(std::string_view s1, std::string_view s2) const { return keyboard(s1, s2); }
+};
+
+bool is_adjacent(char c1, char c2);
+
+};  // namespace Distance
+
+#endif
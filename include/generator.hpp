@@ -0,0 +1,110 @@
+#ifndef GENERATOR_HPP
+#define GENERATOR_HPP
+
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#include <optional>
+#include <utility>
+#include <vector>
+
+// Lazy, resumable sequence produced by a coroutine. Every resume advances the traversal by one
+// result, so callers can stop early or take results page by page without restarting.
+template <typename T>
+class Generator {
+   public:
+    struct promise_type {
+        std::optional<T> current;
+        std::exception_ptr exception;
+
+        Generator get_return_object() {
+            return Generator(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        std::suspend_always yield_value(T value) {
+            current = std::move(value);
+            return {};
+        }
+        void return_void() {}
+        void unhandled_exception() { exception = std::current_exception(); }
+    };
+
+    class iterator {
+       private:
+        Generator *generator;
+
+       public:
+        using iterator_category = std::input_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = T;
+
+        explicit iterator(Generator *generator) : generator(generator) {}
+
+        const T &operator*() const { return *generator->handle.promise().current; }
+        iterator &operator++() {
+            generator->advance();
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+        bool operator==(std::default_sentinel_t) const { return generator->done(); }
+    };
+
+   private:
+    std::coroutine_handle<promise_type> handle;
+
+   public:
+    Generator() = default;
+    explicit Generator(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+    Generator(Generator &&other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    Generator &operator=(Generator &&other) noexcept {
+        if (this != &other) {
+            if (handle) handle.destroy();
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+    Generator(const Generator &) = delete;
+    Generator &operator=(const Generator &) = delete;
+    ~Generator() {
+        if (handle) handle.destroy();
+    }
+
+    // Resume to the next result, or return nullopt once the traversal is exhausted
+    std::optional<T> next() {
+        if (advance() == false) return std::nullopt;
+        return std::move(handle.promise().current);
+    }
+
+    // Resume up to `count` times and collect the results as one page
+    std::vector<T> take(size_t count) {
+        std::vector<T> page;
+        while (page.size() < count) {
+            std::optional<T> value = next();
+            if (value.has_value() == false) break;
+            page.push_back(std::move(*value));
+        }
+        return page;
+    }
+
+    iterator begin() {
+        advance();
+        return iterator(this);
+    }
+    std::default_sentinel_t end() { return {}; }
+
+   private:
+    bool done() const { return handle == nullptr || handle.done(); }
+
+    bool advance() {
+        if (done()) return false;
+        handle.promise().current.reset();
+        handle.resume();
+        if (handle.promise().exception) {
+            std::rethrow_exception(handle.promise().exception);
+        }
+        return done() == false;
+    }
+};
+
+#endif
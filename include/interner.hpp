@@ -0,0 +1,60 @@
+#ifndef INTERNER_HPP
+#define INTERNER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "word.hpp"
+
+// Pool of words shared between dictionaries. A word with the same text, parts of speech and
+// definitions as a pooled one is swapped for it, so overlapping vocabularies store it once.
+// Pooled words are shared across dictionaries and must not be modified afterwards
+class Interner {
+   private:
+    // Keyed by text alone, so a lookup needs no temporary Word
+    struct Hash {
+        using is_transparent = void;
+        size_t operator()(std::string_view text) const;
+        size_t operator()(const std::shared_ptr<Word> &word) const;
+    };
+    struct Equal {
+        using is_transparent = void;
+        bool operator()(const std::shared_ptr<Word> &a, const std::shared_ptr<Word> &b) const;
+        bool operator()(std::string_view a, const std::shared_ptr<Word> &b) const;
+        bool operator()(const std::shared_ptr<Word> &a, std::string_view b) const;
+    };
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_set<std::shared_ptr<Word>, Hash, Equal> words;
+    };
+
+    // Dictionaries loading in parallel intern concurrently, shards keep them off one mutex
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::atomic<size_t> shared_count = 0;
+
+   public:
+    Interner(size_t shard_count = 16);
+    ~Interner() = default;
+
+    // The pooled twin of `word` when there is one, `word` itself otherwise. The first word seen
+    // with a text is pooled, later ones with other definitions stay private to their dictionary
+    std::shared_ptr<Word> intern(std::shared_ptr<Word> word);
+
+    size_t get_word_count() const;
+    size_t get_shared_count() const;  // Words that were swapped for a pooled one
+
+    // The pool itself, the words belong to the dictionaries holding them
+    size_t get_memory_usage() const;
+
+   private:
+    Shard &shard_for(std::string_view text) const;
+};
+
+#endif
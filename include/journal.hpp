@@ -0,0 +1,96 @@
+#ifndef JOURNAL_HPP
+#define JOURNAL_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "word.hpp"
+
+// Append-only log of dictionary mutations, replayed on startup on top of the loaded file
+namespace Journal {
+
+enum class Op : uint8_t { Insert = 1, Update = 2, Remove = 3 };
+
+struct Record {
+    Op op;
+    std::string text;
+    std::vector<std::pair<POS, std::string>> definitions;  // Empty for Remove
+};
+
+// CRC-32 (IEEE 802.3), the checksum stored in front of every record
+uint32_t crc32(std::string_view data);
+
+// On disk a record is [payload length][payload CRC-32][payload], both header fields 32-bit
+// little endian. The payload holds the op, the text and the definitions, strings length prefixed
+void encode(const Record &record, std::string &out);
+bool decode(std::string_view payload, Record &record);
+
+// Replaces `path` with `data` atomically: written to a temporary file, synced, then renamed
+bool write_file(const std::string &path, std::string_view data);
+
+// Tells one version of a file from the next, a rename over it or a rewrite changes the stamp.
+// All zero when the file cannot be read
+struct Stamp {
+    uint64_t inode = 0;
+    uint64_t size = 0;
+    int64_t modified = 0;  // Nanoseconds
+
+    bool operator==(const Stamp &) const = default;
+};
+Stamp stamp(const std::string &path);
+
+class Log {
+   private:
+    int fd = -1;
+    mutable std::mutex mutex;
+    std::condition_variable flushed;
+    std::string buffer;     // Encoded records waiting for the next flush
+    uint64_t appended = 0;  // Sequence number of the last buffered record
+    uint64_t durable = 0;   // Sequence number of the last synced record
+    bool flushing = false;  // A leader is writing, later records wait for the next batch
+    bool failed = false;    // A write or sync failed, nothing after it is durable
+    size_t size = 0;        // Synced bytes
+    size_t sync_count = 0;
+    size_t replay_count = 0;
+
+   public:
+    Log() = default;
+    ~Log();
+
+    Log(const Log &) = delete;
+    Log &operator=(const Log &) = delete;
+
+    // Creates the file when missing
+    bool open(const std::string &path);
+    bool is_open() const;
+
+    // Feeds every intact record to `apply` in order. Replay stops at the first torn or corrupt
+    // record, which is cut off so new records do not land behind garbage. Returns the count
+    size_t replay(const std::function<void(const Record &)> &apply);
+
+    // Group commit: `enqueue` only buffers and is cheap enough to call under the caller's own
+    // lock. `wait` blocks until the record is synced, the first waiter writes and syncs every
+    // record buffered so far while the others queue up behind it for the next batch
+    uint64_t enqueue(const Record &record);
+    bool wait(uint64_t sequence);
+    bool append(const Record &record);
+
+    // Empties the log once its records are folded into a checkpoint. Buffered records count as
+    // durable, the checkpoint holds them
+    bool reset();
+
+    size_t get_size() const;
+    size_t get_record_count() const;  // Appended since `open`
+    size_t get_sync_count() const;
+    size_t get_replay_count() const;
+};
+
+};  // namespace Journal
+
+#endif
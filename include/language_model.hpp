@@ -0,0 +1,114 @@
+#ifndef LANGUAGE_MODEL_HPP
+#define LANGUAGE_MODEL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Word bigram language model, built offline from plain text by dict_lmbuild and mapped read only
+// at run time. Probabilities are log10 and quantized to a byte, unseen pairs back off to the
+// probability of the word alone
+namespace Language {
+
+// Sentences of `text` as words in key form (see utf8.hpp). Words are runs of letters, sentences
+// end at '.', '!', '?' and blank lines
+std::vector<std::vector<std::string>> split(std::string_view text);
+
+// Counts words and pairs of neighbouring words, then writes the model file
+class Builder {
+   private:
+    std::unordered_map<std::string, uint32_t> ids;  // ID 0 marks the sentence boundary
+    std::vector<uint64_t> counts;                    // Occurrences by ID
+    std::vector<uint64_t> followed;                  // Pairs starting with each ID
+    std::unordered_map<uint64_t, uint32_t> pairs;    // (first << 32 | second) to count
+    uint64_t token_count = 0;
+
+   public:
+    Builder();
+    ~Builder() = default;
+
+    void add(std::string_view text);
+
+    // Words and pairs seen fewer than `min_count` times are left out. The file is replaced
+    // whole, see Journal::write_file
+    bool write(const std::string &path, uint64_t min_count = 2) const;
+
+    size_t get_word_count() const;  // Distinct words seen
+    size_t get_pair_count() const;   // Distinct pairs seen
+    uint64_t get_token_count() const;
+
+   private:
+    uint32_t id_of(const std::string &word);
+};
+
+// One spelling for a position of a sentence, `penalty` is its own log10 cost (how unlikely the
+// typo is) added to the model's
+struct Candidate {
+    std::string_view text;
+    double penalty = 0.0;
+};
+
+class Model {
+   public:
+    static constexpr uint32_t UNKNOWN = UINT32_MAX;
+    static constexpr uint32_t BOUNDARY = 0;
+
+   private:
+    // Views into the mapped file, laid out as Header then these arrays in this order
+    const void *mapping = nullptr;
+    size_t mapping_size = 0;
+    const uint64_t *keys = nullptr;       // Hash of each word by ID, fixed by the format
+    const uint32_t *slots = nullptr;      // Open addressing table, ID + 1 or 0 when empty
+    const uint32_t *offsets = nullptr;    // Followers of ID i in [offsets[i], offsets[i + 1])
+    const uint32_t *followers = nullptr;  // Sorted within each ID
+    const uint8_t *pair_values = nullptr;
+    const uint8_t *word_values = nullptr;     // log10 P(word)
+    const uint8_t *backoff_values = nullptr;  // log10 weight of the fallback to P(word)
+    uint32_t word_count = 0;
+    uint32_t slot_mask = 0;
+    uint64_t pair_count = 0;
+    float minimum = 0.0f;  // Byte q stands for minimum + q * step
+    float step = 0.0f;
+    float unknown = 0.0f;  // log10 P of a word outside the vocabulary
+
+   public:
+    Model() = default;
+    ~Model();
+    Model(const Model &) = delete;
+    Model &operator=(const Model &) = delete;
+
+    // False when the file is missing, truncated, damaged or not a model. Reads the whole file
+    // once to check it
+    bool open(const std::string &path);
+    void close();
+    bool is_open() const;
+
+    // ID of a word in key form, UNKNOWN when the corpus did not have it
+    uint32_t lookup(std::string_view word) const;
+
+    // log10 P(word | previous), IDs from `lookup` or BOUNDARY around a sentence. With texts, an
+    // empty one stands for the boundary
+    double score(uint32_t previous, uint32_t word) const;
+    double score(std::string_view previous, std::string_view word) const;
+
+    // Candidates for every position of a sentence in one pass. Each candidate gets the log10
+    // probability of the best reading of the whole sentence that goes through it, penalties
+    // included, so candidates of one position compare by how well they fit their neighbours.
+    // Costs a pair lookup per two candidates of neighbouring positions
+    std::vector<std::vector<double>> score(
+        const std::vector<std::vector<Candidate>> &sentence) const;
+
+    size_t get_word_count() const;
+    size_t get_pair_count() const;
+    size_t get_file_size() const;
+
+   private:
+    double value(uint8_t quantized) const;
+};
+
+};  // namespace Language
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef MEMORY_HPP
+#define MEMORY_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Heap accounting in the block sizes the allocator hands out, which are larger than the sizes
+// requested and carry a header of their own
+namespace Memory {
+
+// Footprint of the live block starting at `pointer`, requested with `size` bytes. Read from
+// glibc through malloc_usable_size, `estimate(size)` with other allocators
+size_t block_size(const void *pointer, size_t size);
+
+// Footprint of a request of `size` bytes, for blocks whose start is not at hand: arrays behind
+// their length cookie, hash table nodes, make_shared blocks
+size_t estimate(size_t size);
+
+// make_shared places the object right after its control block
+size_t shared_block(size_t size);
+
+// Heap part of a string, 0 while it fits the inline buffer
+size_t of(const std::string &text);
+
+template <typename T>
+size_t of(const std::vector<T> &vector) {
+    return vector.capacity() == 0 ? 0 : block_size(vector.data(), vector.capacity() * sizeof(T));
+}
+
+// Node based unordered containers: the bucket array plus one node per element with the next
+// pointer, the value and, when the hash is not cheap to recompute, the cached hash. What the
+// values own is left to the caller
+template <typename Container>
+size_t of_hashed(const Container &container, bool cached_hash) {
+    size_t node = sizeof(void *) + sizeof(typename Container::value_type) +
+                  (cached_hash ? sizeof(size_t) : 0);
+    return estimate(container.bucket_count() * sizeof(void *)) + container.size() * estimate(node);
+}
+
+// Heap bytes of a dictionary by component
+struct Usage {
+    size_t trie = 0;
+    size_t bktree = 0;
+    size_t words = 0;        // Word objects and texts, the ID table and the interner
+    size_t definitions = 0;  // Definitions and their parts of speech
+    size_t lookup = 0;       // Phonetic index, filter and perfect hash
+    size_t cache = 0;
+
+    size_t total() const;
+    Usage &operator+=(const Usage &other);
+};
+
+};  // namespace Memory
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef PERFECT_HASH_HPP
+#define PERFECT_HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Minimal perfect hashing: a static set of N distinct keys onto slots 0 to N-1, one key per slot
+namespace PerfectHash {
+
+// PTHash style. Keys are split into buckets of about four, and every bucket stores the first
+// pilot that sends all of its keys to free slots. A lookup reads one pilot, so it costs one
+// cache miss plus the slot it returns. Keys outside the set land on an arbitrary slot, callers
+// verify what they find there
+class Function {
+   private:
+    uint64_t seed = 0;
+    size_t key_count = 0;
+    std::vector<uint32_t> pilots;  // One per bucket
+
+   public:
+    Function() = default;
+    ~Function() = default;
+
+    // `keys` must be distinct. Buckets are placed largest first, while the table is emptiest
+    void build(const std::vector<uint64_t> &keys);
+
+    // Below `get_key_count()`, which must not be 0
+    size_t lookup(uint64_t key) const;
+
+    size_t get_key_count() const;
+    size_t get_memory_usage() const;
+
+   private:
+    uint64_t mix(uint64_t key) const;
+    size_t bucket(uint64_t mixed) const;
+    size_t position(uint64_t mixed, uint32_t pilot) const;
+};
+
+};  // namespace PerfectHash
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef PHONETIC_HPP
+#define PHONETIC_HPP
+
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Sound-alike lookup for misspellings edit distance cannot reach ("fonetik" -> "phonetic")
+namespace Phonetic {
+
+// Metaphone style key packed 5 bits per sound, first sound in the lowest bits. Sounds past
+// MAX_SOUNDS are dropped
+using Key = uint64_t;
+inline constexpr int MAX_SOUNDS = 12;
+
+// Computed in place without allocating, 0 for words without any sound
+Key encode(std::string_view word);
+
+class Index {
+   private:
+    std::unordered_map<Key, std::vector<uint32_t>> buckets;  // Key to word IDs
+    size_t id_bytes = 0;                                     // Heap of the ID lists
+
+   public:
+    Index() = default;
+    ~Index() = default;
+
+    // Words without any sound, key 0, are left out: they would all share one bucket
+    void insert(std::string_view word, uint32_t id);
+    void remove(std::string_view word, uint32_t id);
+
+    // IDs of every word sharing the key of `word`, in insertion order
+    const std::vector<uint32_t> &lookup(std::string_view word) const;
+
+    size_t get_key_count() const;
+    size_t get_memory_usage() const;
+};
+
+};  // namespace Phonetic
+
+#endif
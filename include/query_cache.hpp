@@ -0,0 +1,52 @@
+#ifndef QUERY_CACHE_HPP
+#define QUERY_CACHE_HPP
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "word.hpp"
+
+// Size-bounded LRU cache of query results, split into independently locked shards so
+// concurrent callers rarely contend on the same mutex
+class QueryCache {
+   private:
+    using Results = std::vector<std::shared_ptr<Word>>;
+    using Entry = std::pair<std::string, Results>;
+
+    struct Shard {
+        std::mutex mutex;
+        std::list<Entry> entries;  // Most recently used at the front
+        std::unordered_map<std::string, std::list<Entry>::iterator> index;
+        size_t capacity = 0;
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::atomic<size_t> hits = 0;
+    std::atomic<size_t> misses = 0;
+
+   public:
+    QueryCache(size_t capacity, size_t shard_count = 8);
+    ~QueryCache() = default;
+
+    bool get(const std::string &key, Results &results);
+    void put(const std::string &key, const Results &results);
+    void clear();
+
+    size_t get_capacity() const;
+    size_t get_size() const;
+    size_t get_memory_usage() const;
+    size_t get_hits() const;
+    size_t get_misses() const;
+    double get_hit_ratio() const;
+
+   private:
+    Shard &shard_for(const std::string &key) const;
+};
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef RELOADER_HPP
+#define RELOADER_HPP
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "dictionary.hpp"
+
+// Owns the dictionary loaded from a file and replaces it whole when the file is reloaded. The
+// new dictionary is built off to the side, then swapped in atomically: queries holding the old
+// snapshot finish on it, and it is freed when the last of them lets go
+class Reloader {
+   private:
+    std::atomic<std::shared_ptr<Dictionary>> current;
+    std::string filepath;
+    std::function<bool(Dictionary &)> prepare;  // Settings every fresh dictionary starts with
+    std::mutex reload_mutex;                    // One build at a time
+    std::atomic<size_t> reload_count = 0;
+
+    std::thread watcher;
+    int inotify_fd = -1;
+    int wake_fd = -1;
+
+   public:
+    Reloader(std::function<bool(Dictionary &)> prepare = nullptr);
+    ~Reloader();
+
+    Reloader(const Reloader &) = delete;
+    Reloader &operator=(const Reloader &) = delete;
+
+    // False keeps the current dictionary, a file that cannot be read never replaces it
+    bool load(const std::string &filepath);
+    bool reload();
+
+    // Reloads in the background whenever the file is rewritten or replaced, which covers editors
+    // saving through a rename. Bursts of events within a short quiet period cause one reload,
+    // none when the file is the checkpoint the current dictionary wrote itself
+    bool watch();
+    void stop_watching();
+
+    // Runs `change` on the current dictionary once any reload in progress has swapped in, so a
+    // setting changed during a reload reaches the dictionary that replaced the old one
+    void update(const std::function<void(Dictionary &)> &change);
+
+    std::shared_ptr<Dictionary> get() const;
+    size_t get_reload_count() const;
+
+   private:
+    void watch_loop(std::string path, std::string name);
+};
+
+#endif
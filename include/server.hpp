@@ -0,0 +1,78 @@
+#ifndef SERVER_HPP
+#define SERVER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "dictionary.hpp"
+#include "reloader.hpp"
+#include "thread_pool.hpp"
+
+// Line protocol: each request is one query terminated by '\n', each response is one line with
+// the result count followed by the result words, separated by single spaces ("2 cat cut\n")
+std::string format_response(const std::vector<std::shared_ptr<Word>> &results);
+
+class Server {
+   private:
+    struct Connection {
+        int fd = -1;
+        std::string input;
+        std::string output;
+        bool busy = false;     // A query of this connection is running on the worker pool
+        bool closing = false;  // Peer hung up, close once the pending work is flushed
+        bool writing = false;  // Registered for EPOLLOUT
+    };
+
+    // Either a fixed dictionary or the current snapshot of a reloader, taken once per query
+    const Dictionary *dict = nullptr;
+    const Reloader *reloader = nullptr;
+    std::unique_ptr<ThreadPool> pool;
+    int listen_fd = -1;
+    int epoll_fd = -1;
+    int wake_fd = -1;
+    std::string socket_path;
+    std::atomic<bool> running = false;
+
+    // Connections are addressed by id so a reused fd never receives a stale response
+    std::unordered_map<uint64_t, Connection> connections;
+    std::unordered_map<int, uint64_t> ids;
+    uint64_t next_id = 1;
+
+    std::mutex completed_mutex;
+    std::vector<std::pair<uint64_t, std::string>> completed;
+
+   public:
+    Server(const Dictionary &dict, size_t worker_count = 0);
+    Server(const Reloader &reloader, size_t worker_count = 0);
+    ~Server();
+
+    Server(const Server &) = delete;
+    Server &operator=(const Server &) = delete;
+
+    bool listen_unix(const std::string &path);
+    bool listen_tcp(int port);
+    void run();
+    void stop();
+
+    size_t get_worker_count() const;
+
+   private:
+    void start(size_t worker_count);
+    std::shared_ptr<const Dictionary> snapshot() const;
+    bool setup(int fd);
+    void accept_connections();
+    void read_connection(uint64_t id);
+    void write_connection(uint64_t id);
+    void dispatch(uint64_t id);
+    void collect_completed();
+    void close_connection(uint64_t id);
+    void watch_output(Connection &connection, bool enable);
+};
+
+#endif
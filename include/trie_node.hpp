@@ -1,34 +1,108 @@
 #ifndef TRIE_NODE_HPP
 #define TRIE_NODE_HPP
 
+#include <cstdint>
 #include <memory>
-#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "word.hpp"
 
 namespace Trie {
 
+// Both node types share one child interface: child_count, child_key(i) and child_at(i) walk the
+// children in ascending key order, get_child/set_child/remove_child work on one key
+
+// Generic node for arbitrary bytes
 class Node {
    private:
-    std::unordered_map<char, std::unique_ptr<Node>> children;
+    // Children kept sorted by unsigned byte so traversal order is lexicographic
+    std::vector<std::pair<char, std::unique_ptr<Node>>> children;
     std::shared_ptr<Word> word;
 
    public:
     Node() = default;
     ~Node() = default;
 
+    static constexpr bool accepts(char) { return true; }
+
     bool is_word() const;
     std::shared_ptr<Word> get_word() const;
     void set_word(std::shared_ptr<Word> word);
 
     Node *get_child(char c) const;
     Node *set_child(char c);
+    bool has_child(char c) const;
+    void remove_child(char c);
+
+    size_t child_count() const;
+    char child_key(size_t index) const;
+    Node *child_at(size_t index) const;
+
+    // Heap the node owns directly: the child list and the child nodes themselves
+    size_t get_memory_usage() const;
+
+   private:
+};
+
+// Contiguous character range of at most 32 keys, so a node's children fit one bitmap
+template <char First, char Last>
+struct Alphabet {
+    static_assert(First <= Last && Last - First < 32, "alphabet must fit a 32-bit bitmap");
+    static constexpr unsigned size = Last - First + 1;
+
+    // Characters below First wrap around to large values, one comparison rejects both sides
+    static constexpr unsigned index(char c) {
+        return static_cast<unsigned>(static_cast<unsigned char>(c)) -
+               static_cast<unsigned char>(First);
+    }
+    static constexpr char key(unsigned index) { return static_cast<char>(First + index); }
+    static constexpr bool contains(char c) { return index(c) < size; }
+};
+
+using Lowercase = Alphabet<'a', 'z'>;
+
+// Node for a fixed small alphabet: an occupancy bitmap and a packed child array, the child for
+// key k sits at the number of set bits below k. Children are stored by value, so each step down
+// the tree touches one array instead of an array and a separately allocated node. Adding a
+// child moves its siblings, pointers to them are only stable while the node is not modified
+template <typename Alpha>
+class AlphaNode {
+   private:
+    uint32_t bitmap = 0;
+    std::unique_ptr<AlphaNode[]> children;
+    std::shared_ptr<Word> word;
+
+   public:
+    AlphaNode() = default;
+    ~AlphaNode() = default;
+    AlphaNode(AlphaNode &&other) = default;
+    AlphaNode &operator=(AlphaNode &&other) = default;
+
+    static constexpr bool accepts(char c) { return Alpha::contains(c); }
+
+    bool is_word() const;
+    std::shared_ptr<Word> get_word() const;
+    void set_word(std::shared_ptr<Word> word);
 
-    const std::unordered_map<char, std::unique_ptr<Node>> &get_children() const;
+    // Characters outside the alphabet never have a child, set_child returns nullptr for them
+    AlphaNode *get_child(char c) const;
+    AlphaNode *set_child(char c);
+    bool has_child(char c) const;
+    void remove_child(char c);
+
+    size_t child_count() const;
+    char child_key(size_t index) const;
+    AlphaNode *child_at(size_t index) const;
+
+    // Heap the node owns directly: the packed child array
+    size_t get_memory_usage() const;
 
    private:
 };
 
+extern template class AlphaNode<Lowercase>;
+
 };  // namespace Trie
 
 #endif
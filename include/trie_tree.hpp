@@ -3,45 +3,71 @@
 
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "generator.hpp"
 #include "trie_node.hpp"
 #include "word.hpp"
 
 namespace Trie {
 
-class Tree {
+// Trie over either node type of trie_node.hpp, chosen at compile time
+template <typename NodeType = Node>
+class BasicTree {
    private:
-    std::unique_ptr<Node> root;
-    size_t memory_usage = 0;
-    bool stable = true;
-    int height = 0;
+    std::unique_ptr<NodeType> root;
+
+    // Maintained by insert and remove so statistics never need a walk
+    size_t node_count = 1;
+    size_t node_bytes = 0;              // Heap the nodes own, see Node::get_memory_usage
+    std::vector<size_t> length_counts;  // Stored words per length, no trailing zeros
 
    public:
-    Tree();
-    ~Tree() = default;
+    BasicTree();
+    ~BasicTree() = default;
+
+    // False when the word has characters the node type cannot store, the tree is left unchanged
+    bool insert(std::shared_ptr<Word> word);
 
-    void insert(std::shared_ptr<Word> word);
+    // Detach the word stored under `text` and prune the nodes left without words, returns the
+    // removed word or nullptr
+    std::shared_ptr<Word> remove(const std::string &text);
 
     std::shared_ptr<Word> search(const std::string &word) const;
-    std::vector<std::shared_ptr<Word>> suggest(const std::string &prefix,
-                                               int max_suggestions) const;
+    std::vector<std::shared_ptr<Word>> suggest(const std::string &prefix, int max_suggestions,
+                                               const std::string &after = "") const;
     std::vector<std::shared_ptr<Word>> match(const std::string &pattern, int max_matches) const;
 
-    void set_stable(bool stable);
-    size_t get_memory_usage();
-    int get_height();
+    // Lazy versions yielding results one by one, the tree must outlive the generator
+    Generator<std::shared_ptr<Word>> suggest_stream(std::string prefix) const;
+    Generator<std::shared_ptr<Word>> match_stream(std::string pattern) const;
+
+    size_t get_node_count() const;
+    size_t get_memory_usage() const;
+    int get_height() const;
+
+    // Walk the whole tree and check the incremental statistics against it, O(N)
+    bool audit() const;
 
    private:
-    void suggest_core(const Node *node, std::string prefix,
-                      std::vector<std::shared_ptr<Word>> &suggestions, int max_suggestions) const;
-    void match_core(const Node *node, size_t pattern_index, const std::string &current,
-                    const std::string &pattern, std::vector<std::shared_ptr<Word>> &matches,
+    void suggest_core(const NodeType *start, size_t depth,
+                      std::vector<std::shared_ptr<Word>> &suggestions, int max_suggestions,
+                      const std::string &after, bool bounded) const;
+    void match_core(const std::string &pattern, std::vector<std::shared_ptr<Word>> &matches,
                     int max_matches) const;
-    size_t calculate_memory_usage(const Node *node) const;
-    int calculate_height(const Node *node) const;
+    void push_matches(const NodeType *node, size_t pattern_index, const std::string &pattern,
+                      std::vector<std::pair<const NodeType *, size_t>> &stack) const;
+    void push_character(const NodeType *node, size_t index, size_t pattern_index,
+                        std::vector<std::pair<const NodeType *, size_t>> &stack) const;
 };
 
+extern template class BasicTree<Node>;
+extern template class BasicTree<AlphaNode<Lowercase>>;
+
+using Tree = BasicTree<Node>;
+using LowercaseTree = BasicTree<AlphaNode<Lowercase>>;
+
 };  // namespace Trie
 
 #endif
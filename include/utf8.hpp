@@ -0,0 +1,44 @@
+#ifndef UTF8_HPP
+#define UTF8_HPP
+
+#include <string>
+#include <string_view>
+
+// UTF-8 keys. Dictionary keys are stored in the form `normalize` returns, and everything that
+// is plain lowercase ASCII is left alone so English text never leaves the byte fast path
+namespace Utf8 {
+
+// Whether every byte is below 0x80, checked eight bytes at a time
+bool is_ascii(std::string_view text);
+
+// Plain lowercase ASCII, already in key form
+bool is_key_ascii(std::string_view text);
+
+// Bytes in the sequence `lead` starts, 1 for ASCII and for stray continuation bytes
+int sequence_length(char lead);
+
+// Code points of `text`, false on malformed UTF-8: stray or missing continuation bytes,
+// overlong forms, surrogates and values past U+10FFFF
+bool decode(std::string_view text, std::u32string &code_points);
+void encode(char32_t code_point, std::string &text);
+size_t length(std::string_view text);  // In code points, `text` must be valid
+
+// Letters of the scripts keys may use: ASCII, Latin, Greek and Cyrillic, plus the combining
+// diacritics decomposed text carries
+bool is_letter(char32_t code_point);
+
+// Whether `text` is valid UTF-8 made of letters only
+bool is_letters(std::string_view text);
+
+// Simple case folding, one code point to one. Folds needing more than one ("ß" to "ss") are
+// left out, so lengths never change
+char32_t fold(char32_t code_point);
+
+// Key form of `text`: base letters followed by a diacritic are composed into their precomposed
+// letter (NFC for the scripts above, marks are expected in canonical order) and then case
+// folded. Empty for malformed UTF-8
+std::string normalize(std::string_view text);
+
+};  // namespace Utf8
+
+#endif
@@ -2,6 +2,7 @@
 #define WORD_HPP
 
 #include <chrono>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -18,23 +19,37 @@ enum class POS {
     Undefined
 };
 
+class DefinitionStore;
+
 class Word {
    private:
     std::string text;
-    std::vector<std::string> definition;
+    std::vector<std::string> definition;  // Empty while the definitions sit in `store`
     std::vector<POS> pos;
+    std::shared_ptr<const DefinitionStore> store;
+    uint32_t entry = 0;
 
    public:
     Word(const std::string &text);
     ~Word() = default;
 
     const std::string &get_text() const;
-    const std::vector<std::string> &get_definition() const;
+    // A copy, decompressed from the store when the definitions were moved there
+    std::vector<std::string> get_definition() const;
     const std::vector<POS> &get_pos() const;
+    bool has_definition() const;
 
     void set_text(const std::string &text);
     void add_definition(const std::string &definition);
     void add_pos(POS pos);
+    void clear_definition();  // Drops every definition together with its part of speech
+
+    // Hands the definitions over to `store`, where they were added as `entry`
+    void set_store(std::shared_ptr<const DefinitionStore> store, uint32_t entry);
+    const DefinitionStore *get_store() const;
+
+    // Heap of the parts of speech and the definitions kept in the word, not the store's
+    size_t get_definition_memory() const;
 
    private:
 };
@@ -0,0 +1,78 @@
+#ifndef WORKLOAD_HPP
+#define WORKLOAD_HPP
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+enum class QueryKind { Exact, Miss, Typo1, Typo2, Typo3, Prefix, Pattern, Replay, Count };
+
+struct Request {
+    QueryKind kind;
+    std::string query;
+};
+
+// Relative weights of each generated query kind
+struct Mix {
+    int exact = 40;
+    int miss = 10;
+    int typo1 = 15;
+    int typo2 = 10;
+    int typo3 = 5;
+    int prefix = 10;
+    int pattern = 10;
+};
+
+// Synthetic query mixes drawn from a word list, plus replay of recorded query logs
+class Workload {
+   private:
+    std::vector<std::string> words;
+    std::mt19937_64 rng;
+
+   public:
+    Workload(uint64_t seed = 42);
+    ~Workload() = default;
+
+    bool load_words(const std::string &filepath);
+    void add_word(const std::string &word);
+    size_t get_word_count() const;
+
+    std::vector<Request> generate(size_t count, const Mix &mix);
+
+    std::string make_typo(const std::string &word, int edits);
+    std::string make_miss();
+    std::string make_prefix(const std::string &word);
+    std::string make_pattern(const std::string &word);
+
+   private:
+    const std::string &random_word();
+    char random_letter();
+};
+
+// Recorded log: one query per line, kinds inferred from the query shape
+bool load_log(const std::string &filepath, std::vector<Request> &requests);
+
+std::string parse_kind(QueryKind kind);
+bool parse_mix(const std::string &str, Mix &mix);
+
+// Latency samples in nanoseconds, grouped by query kind
+class LatencyRecorder {
+   private:
+    std::vector<std::vector<uint64_t>> samples;
+
+   public:
+    LatencyRecorder();
+    ~LatencyRecorder() = default;
+
+    void add(QueryKind kind, uint64_t nanoseconds);
+    void merge(const LatencyRecorder &other);
+    void report(double elapsed_seconds) const;
+
+    size_t get_count(QueryKind kind) const;
+    uint64_t get_percentile(QueryKind kind, double percentile) const;
+};
+
+uint64_t percentile(std::vector<uint64_t> &samples, double percentile);
+
+#endif
@@ -1,18 +1,27 @@
 #include "app.hpp"
 
 #include <chrono>
+#include <csignal>
 #include <iomanip>
 #include <iostream>
 #include <memory>
+#include <sstream>
 #include <string>
 #include <thread>
+#include <utility>
+#include <vector>
 
 #include "dictionary.hpp"
+#include "dictionary_set.hpp"
+#include "language_model.hpp"
+#include "memory.hpp"
+#include "reloader.hpp"
+#include "server.hpp"
 #include "utility.hpp"
 #include "word.hpp"
 
 App::App(bool silent) : loaded(false), running(false), silent(silent) {
-    dict = std::make_unique<Dictionary>();
+    reloader = std::make_unique<Reloader>([this](Dictionary &dict) { return prepare(dict); });
 }
 
 App::App(const std::string &filepath, bool silent) : App(silent) {
@@ -20,7 +29,8 @@ App::App(const std::string &filepath, bool silent) : App(silent) {
 }
 
 bool App::load(const std::string &filepath) {
-    bool success = dict->load(filepath);
+    // Builds a new dictionary, queries keep the current one until it is swapped in
+    bool success = reloader->load(filepath);
     if (success == false) {
         log(Status::Error, "cannot load file " + filepath);
         return false;
@@ -34,6 +44,105 @@ bool App::load(const std::string &filepath) {
     return true;
 }
 
+bool App::load(const std::vector<std::string> &filepaths) {
+    if (filepaths.size() == 1) {
+        return load(filepaths.front());
+    }
+    auto dictionaries = std::make_unique<DictionarySet>();
+    {
+        std::lock_guard<std::mutex> lock(settings_mutex);
+        dictionaries->set_config(settings);
+        dictionaries->set_cache_capacity(cache_capacity);
+    }
+    bool success = dictionaries->load(filepaths);
+    for (size_t i = 0; i < dictionaries->get_dictionary_count(); ++i) {
+        log(Status::Info, "loaded file " + dictionaries->get_filepath(i));
+    }
+    if (success == false) {
+        log(Status::Error, "cannot load every file, querying the ones loaded");
+    }
+    if (dictionaries->get_dictionary_count() == 0) {
+        return false;
+    }
+    set = std::move(dictionaries);
+    loaded = true;
+    return success;
+}
+
+bool App::open_journal(const std::string &journal_path, const std::string &base_path) {
+    if (loaded == false) {
+        log(Status::Warning, "load a file before opening a journal");
+        return false;
+    }
+    if (single("journal") == false) {
+        return false;
+    }
+    // On the current dictionary, a reload in progress would hand the journal over otherwise
+    bool opened = false;
+    size_t count = 0;
+    reloader->update([&](Dictionary &dict) {
+        opened = dict.open_journal(journal_path, base_path);
+        count = opened ? dict.get_journal()->get_replay_count() : 0;
+    });
+    if (opened == false) {
+        log(Status::Error, "cannot open journal " + journal_path);
+        return false;
+    }
+    log(Status::Info, "replayed " + std::to_string(count) + " changes from " + journal_path);
+    return true;
+}
+
+bool App::watch() {
+    if (loaded == false) {
+        log(Status::Warning, "load a file before watching it");
+        return false;
+    }
+    if (single("watch") == false) {
+        return false;
+    }
+    return reloader->watch();
+}
+
+void App::set_cache_capacity(size_t capacity) {
+    {
+        std::lock_guard<std::mutex> lock(settings_mutex);
+        cache_capacity = capacity;
+    }
+    if (set != nullptr) {
+        set->set_cache_capacity(capacity);
+    } else if (loaded) {
+        reloader->update([capacity](Dictionary &dict) { dict.set_cache_capacity(capacity); });
+    }
+}
+
+void App::set_audit(bool audit) {
+    this->audit = audit;
+}
+
+bool App::set_language_model(const std::string &model_path) {
+    if (loaded == false) {
+        log(Status::Warning, "load a file before adding a language model");
+        return false;
+    }
+    if (single("model") == false) {
+        return false;
+    }
+    auto language_model = std::make_shared<Language::Model>();
+    if (language_model->open(model_path) == false) {
+        log(Status::Error, "cannot open language model " + model_path);
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(settings_mutex);
+        model = language_model;
+    }
+    reloader->update([&](Dictionary &dict) { dict.set_language_model(language_model); });
+    log(Status::Info, "loaded language model " + model_path + " (" +
+                          std::to_string(language_model->get_word_count()) + " words, " +
+                          std::to_string(language_model->get_pair_count()) + " pairs)");
+    return true;
+}
+
 void App::run() {
     if (loaded == false) {
         log(Status::Warning, "load a file before run the app");
@@ -53,13 +162,56 @@ void App::run() {
         if (is_command) {
             continue;
         }
+        std::vector<std::shared_ptr<Word>> results;
         auto start = std::chrono::steady_clock::now();
-        auto results = dict->search(lower(input));
+        if (set != nullptr) {
+            results = set->search(lower(input));
+        } else {
+            results = reloader->get()->search(lower(input));
+        }
         auto end = std::chrono::steady_clock::now();
         print(results, end - start);
     }
 }
 
+// Server reachable from the signal handler, only set while serve() runs
+static Server *active_server = nullptr;
+
+static void handle_signal(int) {
+    if (active_server != nullptr) {
+        active_server->stop();
+    }
+}
+
+bool App::serve(const std::string &socket_path, int port, size_t worker_count) {
+    if (loaded == false) {
+        log(Status::Warning, "load a file before serving the app");
+        return false;
+    }
+    if (single("serve") == false) {
+        return false;
+    }
+    Server server(*reloader, worker_count);
+    bool listening = (port > 0) ? server.listen_tcp(port) : server.listen_unix(socket_path);
+    if (listening == false) {
+        return false;
+    }
+    std::string endpoint = (port > 0) ? "127.0.0.1:" + std::to_string(port) : socket_path;
+    log(Status::Info, "serving on " + endpoint + " with " +
+                          std::to_string(server.get_worker_count()) + " workers");
+
+    active_server = &server;
+    std::signal(SIGINT, handle_signal);
+    std::signal(SIGTERM, handle_signal);
+    server.run();
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+    active_server = nullptr;
+
+    log(Status::Info, "server stopped");
+    return true;
+}
+
 bool App::terminate(const std::string &input) const {
     return input == "exit()" || input == "quit()";
 }
@@ -95,6 +247,12 @@ bool App::parse_command(const std::string &command) {
     } else if (command == "stats()") {
         show_stats();
         return true;
+    } else if (command == "reload()") {
+        reload();
+        return true;
+    } else if (command.rfind("check(", 0) == 0 && command.back() == ')') {
+        check(command.substr(6, command.size() - 7));  // between "check(" and ")"
+        return true;
     }
     return false;
 }
@@ -103,27 +261,90 @@ void App::show_docs() const {
     std::cout << "\tdocs: https://github.com/haolamnm/dictionary/blob/main/README.md\n";
 }
 
+// Byte count in the largest unit that keeps it at or above one
+static std::string format_size(size_t bytes) {
+    const char *units[] = {"bytes", "kilobytes", "megabytes", "gigabytes"};
+    double display = static_cast<double>(bytes);
+    int unit = 0;
+    while (display >= 1024.0 && unit < 3) {
+        display /= 1024.0;
+        unit += 1;
+    }
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2) << display << " " << units[unit];
+    return out.str();
+}
+
 void App::show_stats() const {
+    std::shared_ptr<Dictionary> dict = (set == nullptr) ? reloader->get() : nullptr;
     std::cout << std::left;
-    int word_count = dict->get_word_count();
+    int word_count = (dict != nullptr) ? dict->get_word_count() : set->get_word_count();
     std::string word_unit = (word_count == 1) ? "word" : "words";
     std::cout << std::setw(20) << "\tword-count" << ": " << word_count << " " << word_unit << '\n';
 
-    size_t memory_usage = dict->get_memory_usage();
-    std::string memory_unit = "bytes";
-    double memory_display = static_cast<double>(memory_usage);
-    if (memory_usage >= 1024 && memory_usage < 1024 * 1024) {
-        memory_display /= 1024.0;
-        memory_unit = "kilobytes";
-    } else if (memory_usage >= 1024 * 1024 && memory_usage < 1024 * 1024 * 1024) {
-        memory_display /= (1024.0 * 1024.0);
-        memory_unit = "megabytes";
-    } else if (memory_usage >= 1024 * 1024 * 1024) {
-        memory_display /= (1024.0 * 1024.0 * 1024.0);
-        memory_unit = "gigabytes";
-    }
-    std::cout << std::setw(20) << "\tmemory-usage" << ": " << std::fixed << std::setprecision(2)
-              << memory_display << " " << memory_unit << '\n';
+    Memory::Usage memory =
+        (dict != nullptr) ? dict->get_memory_breakdown() : set->get_memory_breakdown();
+    std::cout << std::setw(20) << "\tmemory-usage" << ": " << format_size(memory.total()) << '\n';
+    const std::pair<const char *, size_t> components[] = {
+        {"trie", memory.trie},
+        {"bktree", memory.bktree},
+        {"words", memory.words},
+        {"definitions", memory.definitions},
+        {"lookup", memory.lookup},
+        {"cache", memory.cache},
+    };
+    for (const auto &[name, bytes] : components) {
+        std::cout << std::setw(20) << "\t  " + std::string(name) << ": " << format_size(bytes)
+                  << '\n';
+    }
+
+    if (set != nullptr) {
+        std::cout << std::setw(20) << "\tdictionaries" << ": " << set->get_dictionary_count()
+                  << " (" << set->get_interner().get_shared_count() << " shared words)\n";
+    }
+
+    // A set keeps one cache and one filter per dictionary, report them together
+    std::vector<const Dictionary *> parts;
+    if (dict != nullptr) {
+        parts.push_back(dict.get());
+    } else {
+        for (size_t i = 0; i < set->get_dictionary_count(); ++i) {
+            parts.push_back(&set->get_dictionary(i));
+        }
+    }
+
+    // A miss gets through the set when it gets through any of its filters
+    size_t filter_memory = 0;
+    double filter_pass = 1.0;
+    for (const Dictionary *part : parts) {
+        filter_memory += part->get_filter().get_memory_usage();
+        filter_pass *= 1.0 - part->get_filter().get_false_positive_rate();
+    }
+    std::cout << std::setw(20) << "\tfilter" << ": " << format_size(filter_memory) << ", "
+              << std::fixed << std::setprecision(2) << (1.0 - filter_pass) * 100.0
+              << "% false positives\n";
+
+    std::vector<const QueryCache *> caches;
+    for (const Dictionary *part : parts) {
+        caches.push_back(part->get_cache());
+    }
+    if (caches.front() != nullptr) {
+        size_t hits = 0, misses = 0;
+        for (const QueryCache *cache : caches) {
+            hits += cache->get_hits();
+            misses += cache->get_misses();
+        }
+        double hit_ratio = (hits + misses > 0) ? static_cast<double>(hits) / (hits + misses) : 0;
+        std::cout << std::setw(20) << "\tcache-hit-ratio" << ": " << std::fixed
+                  << std::setprecision(2) << hit_ratio * 100.0 << "% (" << hits << " hits, "
+                  << misses << " misses)\n";
+    }
+
+    if (audit) {
+        bool passed = (dict != nullptr) ? dict->audit() : set->audit();
+        std::string result = passed ? "passed" : "failed";
+        std::cout << std::setw(20) << "\taudit" << ": " << result << '\n';
+    }
 
     // NOTE: May not be useful for users
     // std::cout << std::setw(20) << "\ttrie-height" << ": " << dict->get_trie_height() << '\n';
@@ -131,6 +352,70 @@ void App::show_stats() const {
     std::cout << std::flush;
 }
 
+void App::check(const std::string &text) const {
+    if (single("check") == false) {
+        return;
+    }
+    std::shared_ptr<Dictionary> dict = reloader->get();
+    size_t token_count = 0, unknown_count = 0;
+    std::ostringstream out;
+    auto start = std::chrono::steady_clock::now();
+    for (const std::vector<std::string> &sentence : Language::split(text)) {
+        std::vector<std::vector<std::shared_ptr<Word>>> corrections = dict->correct(sentence);
+        token_count += sentence.size();
+        for (size_t i = 0; i < sentence.size(); ++i) {
+            if (corrections[i].size() == 1 && corrections[i][0]->get_text() == sentence[i]) {
+                continue;  // Known word
+            }
+            unknown_count += 1;
+            out << "\t * " << sentence[i] << " ->";
+            for (size_t k = 0; k < corrections[i].size(); ++k) {
+                out << (k == 0 ? " " : ", ") << corrections[i][k]->get_text();
+            }
+            out << (corrections[i].empty() ? " no suggestions\n" : "\n");
+        }
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    log(Status::Info, "checked " + std::to_string(token_count) + " words in " +
+                          std::to_string(elapsed.count()) + " microseconds, " +
+                          std::to_string(unknown_count) + " unknown");
+    std::cout << out.str() << std::flush;
+}
+
+void App::reload() {
+    if (single("reload") == false) {
+        return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    if (reloader->reload() == false) {
+        log(Status::Error, "cannot reload file, keeping the current dictionary");
+        return;
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    log(Status::Info, "reloaded file in " + std::to_string(elapsed.count()) + " milliseconds");
+}
+
+bool App::prepare(Dictionary &dict) const {
+    // A snapshot, changes made meanwhile are applied once the dictionary is swapped in
+    std::lock_guard<std::mutex> lock(settings_mutex);
+    dict.set_config(settings);
+    dict.set_language_model(model);
+    if (cache_capacity > 0) {
+        dict.set_cache_capacity(cache_capacity);
+    }
+    return true;
+}
+
+bool App::single(const std::string &feature) const {
+    if (set != nullptr) {
+        log(Status::Warning, feature + " needs a single file, not available with several");
+        return false;
+    }
+    return true;
+}
+
 void App::clear() const {
     std::cout << "\033[2J\033[1;1H";
 }
@@ -142,6 +427,14 @@ void App::config() {
     get_int(max_matches, "\tmax-matches = ", 1, 1000);
     std::cin.ignore();
 
-    Config config{max_distance, max_suggestions, max_matches};
-    dict->set_config(config);
+    Config changed{max_distance, max_suggestions, max_matches};
+    {
+        std::lock_guard<std::mutex> lock(settings_mutex);
+        settings = changed;
+    }
+    if (set != nullptr) {
+        set->set_config(changed);
+    } else {
+        reloader->update([&changed](Dictionary &dict) { dict.set_config(changed); });
+    }
 }
@@ -1,36 +1,70 @@
 #include "bk_node.hpp"
 
+#include <algorithm>
+#include <cstdint>
 #include <memory>
-#include <unordered_map>
+#include <utility>
 
 #include "word.hpp"
 
 namespace BK {
 
-Node::Node(std::shared_ptr<Word> word) : word(std::move(word)) {}
+Node::Node(std::shared_ptr<Word> word, int distance)
+    : word(std::move(word)), distance(distance), first_child(NONE), next_sibling(NONE) {
+    min_length = max_length = static_cast<uint16_t>(this->word->get_text().size());
+}
+
+Node::Node(std::shared_ptr<Word> word, int distance, uint16_t length)
+    : word(std::move(word)),
+      distance(distance),
+      first_child(NONE),
+      next_sibling(NONE),
+      min_length(length),
+      max_length(length) {}
 
 std::shared_ptr<Word> Node::get_word() const {
     return word;
 }
 
-Node *Node::set_child(int distance, std::shared_ptr<Word> new_word) {
-    if (children.find(distance) == children.end()) {
-        children[distance] = std::make_unique<Node>(new_word);
-    }
-    return children[distance].get();
+void Node::set_word(std::shared_ptr<Word> word) {
+    this->word = std::move(word);
+}
+
+int Node::get_distance() const {
+    return distance;
+}
+
+uint32_t Node::get_first_child() const {
+    return first_child;
+}
+
+uint32_t Node::get_next_sibling() const {
+    return next_sibling;
+}
+
+void Node::set_first_child(uint32_t index) {
+    first_child = index;
+}
+
+void Node::set_next_sibling(uint32_t index) {
+    next_sibling = index;
+}
+
+bool Node::is_leaf() const {
+    return first_child == NONE;
 }
 
-Node *Node::get_child(int distance) const {
-    auto it = children.find(distance);
-    return (it != children.end()) ? it->second.get() : nullptr;
+uint16_t Node::get_min_length() const {
+    return min_length;
 }
 
-bool Node::has_child(int distance) const {
-    return children.find(distance) != children.end();
+uint16_t Node::get_max_length() const {
+    return max_length;
 }
 
-const std::unordered_map<int, std::unique_ptr<Node>> &Node::get_children() const {
-    return children;
+void Node::extend_length(uint16_t min_length, uint16_t max_length) {
+    this->min_length = std::min(this->min_length, min_length);
+    this->max_length = std::max(this->max_length, max_length);
 }
 
 };  // namespace BK
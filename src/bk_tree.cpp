@@ -1,143 +1,532 @@
 #include "bk_tree.hpp"
 
 #include <algorithm>
+#include <array>
 #include <cstddef>
+#include <cstdlib>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <functional>
 #include <memory>
+#include <random>
+#include <string>
+#include <utility>
 #include <vector>
 
+#include "distance.hpp"
+#include "generator.hpp"
+#include "memory.hpp"
+#include "utf8.hpp"
 #include "word.hpp"
 
 namespace BK {
 
-void Tree::insert(std::shared_ptr<Word> word) {
-    if (root.get() == nullptr) {
-        root = std::make_unique<Node>(word);
-        stable = false;
+// Pivot candidates tried per subtree, and the sample each candidate is scored against
+static constexpr size_t PIVOT_CANDIDATES = 8;
+static constexpr size_t PIVOT_SAMPLE = 32;
+
+using Candidate = std::pair<std::shared_ptr<Word>, int>;
+
+// Strict ranking of search results: smaller distance first, then alphabetical
+static bool closer(const Candidate &a, const Candidate &b) {
+    if (a.second != b.second) return a.second < b.second;
+    return a.first->get_text() < b.first->get_text();
+}
+
+// Lengths and histograms count the units the metric edits: code points or bytes
+template <typename Metric>
+static int text_length(const std::string &text) {
+    if constexpr (Metric::code_points) {
+        return static_cast<int>(Utf8::length(text));
+    } else {
+        return static_cast<int>(text.size());
+    }
+}
+
+// Adds `delta` to the bucket of every character of `text`
+template <typename Metric>
+static void count_characters(Histogram &histogram, const std::string &text, int delta) {
+    if constexpr (Metric::code_points) {
+        if (Utf8::is_ascii(text) == false) {
+            thread_local std::u32string code_points;
+            Utf8::decode(text, code_points);
+            for (char32_t c : code_points) {
+                histogram[c & 31] += delta;
+            }
+            return;
+        }
+    }
+    for (char c : text) {
+        histogram[c & 31] += delta;
+    }
+}
+
+// Character histogram folded into 32 buckets (c & 31), so 'a'..'z' each get their own bucket
+template <typename Metric>
+static Histogram make_histogram(const std::string &text) {
+    Histogram histogram{};
+    count_characters<Metric>(histogram, text, 1);
+    return histogram;
+}
+
+// Every edit fixes at most one surplus character on each side, so the larger surplus is a lower
+// bound of the edit distance. Merged buckets only make the bound weaker, never wrong
+template <typename Metric>
+static int histogram_bound(const Histogram &query, const std::string &text) {
+    Histogram histogram = query;
+    count_characters<Metric>(histogram, text, -1);
+    int surplus = 0, deficit = 0;
+    for (int count : histogram) {
+        if (count > 0) surplus += count;
+        else deficit -= count;
+    }
+    return std::max(surplus, deficit);
+}
+
+template <typename Metric>
+void BasicTree<Metric>::insert(std::shared_ptr<Word> word) {
+    if (nodes.empty()) {
+        add_node(word, 0, Node::NONE);
+        height = 1;
         return;
     }
-    Node *node = root.get();
-    while (true) {
-        int distance = calculate_distance(word->get_text(), node->get_word()->get_text());
+    uint16_t length = static_cast<uint16_t>(text_length<Metric>(word->get_text()));
+    uint32_t index = 0;
+    for (int depth = 1;; ++depth) {
+        nodes[index].extend_length(length, length);  // The new word joins this subtree
+        int distance = metric(word->get_text(), nodes[index].get_word()->get_text());
+
+        // Reinserting a removed word brings its tombstone back to life
+        if (distance == 0 && tombstones[index]) {
+            nodes[index].set_word(std::move(word));
+            tombstones[index] = false;
+            tombstone_count -= 1;
+            return;
+        }
 
-        Node *child = node->get_child(distance);
-        if (child == nullptr) {
-            node->set_child(distance, word);
-            stable = false;
+        // Siblings are sorted, stop at the first edge that is not smaller
+        uint32_t child = nodes[index].get_first_child();
+        while (child != Node::NONE && nodes[child].get_distance() < distance) {
+            child = nodes[child].get_next_sibling();
+        }
+        if (child == Node::NONE || nodes[child].get_distance() != distance) {
+            add_node(word, distance, index);
+            height = std::max(height, depth + 1);
             return;
         }
-        node = child;
+        index = child;
     }
 }
 
-std::vector<std::shared_ptr<Word>> Tree::search(const std::string &query, int max_distance,
-                                                int max_searches) const {
-    std::vector<std::pair<std::shared_ptr<Word>, int>> container;
-    if (root.get() == nullptr) {
+template <typename Metric>
+size_t BasicTree<Metric>::remove(const std::string &text) {
+    if (nodes.empty()) return 0;
+
+    // Follow the path insert would take, equal words are chained below each other by 0 edges
+    size_t removed = 0;
+    uint32_t index = 0;
+    while (index != Node::NONE) {
+        int distance = metric(text, nodes[index].get_word()->get_text());
+        if (distance == 0 && tombstones[index] == false) {
+            tombstones[index] = true;
+            tombstone_count += 1;
+            removed += 1;
+        }
+        uint32_t child = nodes[index].get_first_child();
+        while (child != Node::NONE && nodes[child].get_distance() < distance) {
+            child = nodes[child].get_next_sibling();
+        }
+        if (child != Node::NONE && nodes[child].get_distance() != distance) {
+            child = Node::NONE;
+        }
+        index = child;
+    }
+    return removed;
+}
+
+template <typename Metric>
+void BasicTree<Metric>::build(std::vector<std::shared_ptr<Word>> words) {
+    std::mt19937_64 rng(words.size());  // Deterministic shape for the same input
+
+    if (nodes.empty() == false) {
+        // Extending a tree: a random order avoids the long chains of sorted input
+        std::shuffle(words.begin(), words.end(), rng);
+        for (const std::shared_ptr<Word> &word : words) {
+            insert(word);
+        }
+        return;
+    }
+    if (words.empty()) return;
+    nodes.reserve(words.size());
+    tombstones.reserve(words.size());
+
+    // Breadth-first construction: the children of every node are created back to back, so each
+    // sibling list is also a contiguous run of the node vector
+    struct Task {
+        uint32_t parent;
+        int distance;
+        int depth;
+        size_t begin;
+        size_t end;
+    };
+    std::deque<Task> queue = {{Node::NONE, 0, 1, 0, words.size()}};
+    std::vector<std::pair<int, std::shared_ptr<Word>>> partition;
+
+    while (queue.empty() == false) {
+        Task task = queue.front();
+        queue.pop_front();
+
+        // Move the pivot to the front of the range, it becomes the subtree root
+        std::swap(words[task.begin], words[select_pivot(words, task.begin, task.end, rng)]);
+        uint32_t index = add_node(words[task.begin], task.distance, task.parent);
+        height = std::max(height, task.depth);
+        const std::string &pivot = words[task.begin]->get_text();
+
+        // Partition the rest by distance to the pivot, each run becomes one child subtree
+        partition.clear();
+        for (size_t i = task.begin + 1; i < task.end; ++i) {
+            partition.emplace_back(metric(pivot, words[i]->get_text()), words[i]);
+        }
+        std::stable_sort(partition.begin(), partition.end(),
+                         [](const auto &a, const auto &b) { return a.first < b.first; });
+        for (size_t i = 0; i < partition.size(); ++i) {
+            words[task.begin + 1 + i] = std::move(partition[i].second);
+        }
+
+        size_t run = 0;
+        while (run < partition.size()) {
+            size_t next = run;
+            while (next < partition.size() && partition[next].first == partition[run].first) {
+                ++next;
+            }
+            queue.push_back({index, partition[run].first, task.depth + 1, task.begin + 1 + run,
+                             task.begin + 1 + next});
+            run = next;
+        }
+    }
+    // Children come after their parent, so a backward pass folds subtree lengths upwards
+    for (size_t i = nodes.size(); i-- > 0;) {
+        for (uint32_t child = nodes[i].get_first_child(); child != Node::NONE;
+             child = nodes[child].get_next_sibling()) {
+            nodes[i].extend_length(nodes[child].get_min_length(), nodes[child].get_max_length());
+        }
+    }
+}
+
+template <typename Metric>
+std::vector<std::shared_ptr<Word>> BasicTree<Metric>::search(const std::string &query,
+                                                             int max_distance,
+                                                             int max_searches) const {
+    if (nodes.empty()) {
         return {};
     }
-    search_core(root.get(), query, max_distance, container, max_searches);
-    std::sort(container.begin(), container.end(), [](const auto &a, const auto &b) {
-        return a.second < b.second;  // sort by distance
-    });
+    // Scratch space reused by every query on this thread, the result is the only allocation
+    thread_local std::vector<Candidate> container;
+    container.clear();
+    size_t visited = 0;
+    search_core(query, max_distance * Metric::unit, container, max_searches, visited);
+    visited_nodes.fetch_add(visited, std::memory_order_relaxed);
+    query_count.fetch_add(1, std::memory_order_relaxed);
+
+    std::sort(container.begin(), container.end(), closer);
     std::vector<std::shared_ptr<Word>> results;
-    for (const auto &pair : container) {
-        results.push_back(pair.first);
+    results.reserve(container.size());
+    for (auto &pair : container) {
+        results.push_back(std::move(pair.first));
     }
+    container.clear();  // Do not keep the words alive until the next query
     return results;
 }
 
-void Tree::set_stable(bool stable) {
-    this->stable = stable;
-}
+template <typename Metric>
+Generator<std::shared_ptr<Word>> BasicTree<Metric>::search_stream(std::string query,
+                                                                 int max_distance) const {
+    if (nodes.empty()) co_return;
+    max_distance *= Metric::unit;
 
-size_t Tree::get_memory_usage() {
-    if (stable == false || memory_usage == 0) {
-        memory_usage = calculate_memory_usage(root.get());
-        stable = true;
+    Histogram histogram = make_histogram<Metric>(query);
+    int query_length = text_length<Metric>(query);
+    std::vector<uint32_t> stack = {0};
+    while (stack.empty() == false) {
+        uint32_t index = stack.back();
+        const Node &node = nodes[index];
+        stack.pop_back();
+        if (tombstones[index] && node.is_leaf()) continue;
+
+        int distance = max_distance + 1;
+        if (can_skip(node, query, histogram, max_distance)) {
+            // Without a metric the children do not depend on this node, search them anyway
+            if (Metric::is_metric || node.is_leaf()) continue;
+        } else {
+            distance = metric(query, node.get_word()->get_text());
+        }
+        if (distance <= max_distance && tombstones[index] == false) {
+            co_yield node.get_word();
+        }
+        push_children(node, distance, query_length, max_distance, stack);
     }
-    return memory_usage;
 }
 
-int Tree::get_height() {
-    if (stable == false || height == 0) {
-        height = calculate_height(root.get());
-        stable = true;
-    }
+template <typename Metric>
+size_t BasicTree<Metric>::get_memory_usage() const {
+    // The bits of a vector<bool> are stored in whole machine words
+    size_t tombstone_words = (tombstones.capacity() + 63) / 64;
+    return Memory::of(nodes) +
+           (tombstone_words == 0 ? 0 : Memory::estimate(tombstone_words * sizeof(uint64_t)));
+}
+
+template <typename Metric>
+int BasicTree<Metric>::get_height() const {
     return height;
 }
 
-void Tree::search_core(const Node *node, const std::string &query, int max_distance,
-                       std::vector<std::pair<std::shared_ptr<Word>, int>> &results,
-                       int max_searches) const {
-    if (node == nullptr || results.size() >= max_searches) return;
+template <typename Metric>
+bool BasicTree<Metric>::audit() const {
+    if (nodes.empty()) return height == 0;
+    if (tombstones.size() != nodes.size()) return false;
+    if (static_cast<size_t>(std::count(tombstones.begin(), tombstones.end(), true)) !=
+        tombstone_count) {
+        return false;
+    }
 
-    int distance = calculate_distance(query, node->get_word()->get_text());
+    for (const Node &node : nodes) {
+        int length = text_length<Metric>(node.get_word()->get_text());
+        if (length < node.get_min_length() || length > node.get_max_length()) return false;
 
-    if (distance <= max_distance) {
-        results.emplace_back(node->get_word(), distance);
-        if (results.size() >= max_searches) return;
+        int previous = -1;
+        for (uint32_t child = node.get_first_child(); child != Node::NONE;
+             child = nodes[child].get_next_sibling()) {
+            const Node &next = nodes[child];
+            // Sorted distinct edges, each equal to the real distance, nested length ranges
+            if (next.get_distance() <= previous) return false;
+            if (metric(node.get_word()->get_text(), next.get_word()->get_text()) !=
+                next.get_distance()) {
+                return false;
+            }
+            if (next.get_min_length() < node.get_min_length() ||
+                next.get_max_length() > node.get_max_length()) {
+                return false;
+            }
+            previous = next.get_distance();
+        }
     }
+    return calculate_height() == height;
+}
 
-    const auto &children = node->get_children();
-    for (int d = distance - max_distance; d <= distance + max_distance; ++d) {
-        auto it = children.find(d);
-        if (it != children.end()) {
-            Node *child = it->second.get();
-            search_core(child, query, max_distance, results, max_searches);
-            if (results.size() >= max_searches) return;
-        }
+template <typename Metric>
+size_t BasicTree<Metric>::get_node_count() const {
+    return nodes.size();
+}
+
+template <typename Metric>
+size_t BasicTree<Metric>::get_tombstone_count() const {
+    return tombstone_count;
+}
+
+template <typename Metric>
+double BasicTree<Metric>::get_average_visits() const {
+    uint64_t queries = query_count.load(std::memory_order_relaxed);
+    if (queries == 0) return 0.0;
+    return static_cast<double>(visited_nodes.load(std::memory_order_relaxed)) / queries;
+}
+
+template <typename Metric>
+void BasicTree<Metric>::reset_visits() {
+    visited_nodes = 0;
+    query_count = 0;
+}
+
+template <typename Metric>
+uint32_t BasicTree<Metric>::add_node(std::shared_ptr<Word> word, int distance,
+                                     uint32_t parent) {
+    uint32_t index = static_cast<uint32_t>(nodes.size());
+    uint16_t length = static_cast<uint16_t>(text_length<Metric>(word->get_text()));
+    nodes.emplace_back(std::move(word), distance, length);
+    tombstones.push_back(false);
+    if (parent == Node::NONE) return index;
+
+    // Link into the parent's sibling list, keeping it sorted by edge distance
+    uint32_t child = nodes[parent].get_first_child();
+    if (child == Node::NONE || nodes[child].get_distance() > distance) {
+        nodes[index].set_next_sibling(child);
+        nodes[parent].set_first_child(index);
+        return index;
+    }
+    while (nodes[child].get_next_sibling() != Node::NONE &&
+           nodes[nodes[child].get_next_sibling()].get_distance() < distance) {
+        child = nodes[child].get_next_sibling();
     }
+    nodes[index].set_next_sibling(nodes[child].get_next_sibling());
+    nodes[child].set_next_sibling(index);
+    return index;
 }
 
-int Tree::calculate_distance(const std::string &s1, const std::string &s2) const {
-    int sz1 = s1.size();
-    int sz2 = s2.size();
+template <typename Metric>
+size_t BasicTree<Metric>::select_pivot(const std::vector<std::shared_ptr<Word>> &words,
+                                       size_t begin, size_t end, std::mt19937_64 &rng) const {
+    size_t count = end - begin;
+    if (count <= 2) return begin;
 
-    // Ensure s2 is longer than s1
-    if (sz1 > sz2) {
-        return calculate_distance(s2, s1);
+    std::uniform_int_distribution<size_t> pick(begin, end - 1);
+    std::vector<size_t> sample;
+    for (size_t i = 0; i < std::min(count, PIVOT_SAMPLE); ++i) {
+        sample.push_back(pick(rng));
     }
-    std::vector<int> prev(sz2 + 1), curr(sz2 + 1);
 
-    for (int j = 0; j <= sz2; ++j) {
-        prev[j] = j;
+    // Medoid of the sample: the candidate closest to everything else splits the subtree into
+    // many well-filled distance buckets instead of one huge bucket and a few outliers
+    size_t best = begin;
+    long best_cost = std::numeric_limits<long>::max();
+    for (size_t i = 0; i < std::min(count, PIVOT_CANDIDATES); ++i) {
+        size_t candidate = pick(rng);
+        long cost = 0;
+        for (size_t other : sample) {
+            cost += metric(words[candidate]->get_text(), words[other]->get_text());
+        }
+        if (cost < best_cost) {
+            best_cost = cost;
+            best = candidate;
+        }
     }
-    // Fill the DP table row by row
-    for (int i = 1; i <= sz1; ++i) {
-        curr[0] = i;  // Initialize the first column of the current row
-        for (int j = 1; j <= sz2; ++j) {
-            if (s1[i - 1] == s2[j - 1]) {
-                curr[j] = prev[j - 1];  // No cost if characters match
-            } else {
-                curr[j] = 1 + std::min({prev[j - 1], prev[j], curr[j - 1]});
+    return best;
+}
+
+template <typename Metric>
+void BasicTree<Metric>::search_core(const std::string &query, int max_distance,
+                                    std::vector<std::pair<std::shared_ptr<Word>, int>> &results,
+                                    int max_searches, size_t &visited) const {
+    if (max_searches <= 0) return;
+    Histogram histogram = make_histogram<Metric>(query);
+    int query_length = text_length<Metric>(query);
+
+    // Best-first: expand the subtree with the smallest distance lower bound first
+    // Min-heap kept in a reusable vector rather than a priority_queue that allocates per query
+    using Entry = std::pair<int, uint32_t>;  // (lower bound, node index)
+    thread_local std::vector<Entry> frontier;
+    frontier.assign(1, {0, 0});
+    auto push = [](int bound, uint32_t index) {
+        frontier.emplace_back(bound, index);
+        std::push_heap(frontier.begin(), frontier.end(), std::greater<Entry>());
+    };
+
+    // `results` is a max-heap of the best candidates so far, its front is the worst one kept
+    int radius = max_distance;
+
+    while (frontier.empty() == false) {
+        std::pop_heap(frontier.begin(), frontier.end(), std::greater<Entry>());
+        auto [bound, index] = frontier.back();
+        frontier.pop_back();
+        if (bound > radius) break;  // Nothing left can beat the current results
+
+        const Node &node = nodes[index];
+        if (tombstones[index] && node.is_leaf()) continue;
+
+        int distance = radius + 1;
+        if (can_skip(node, query, histogram, radius)) {
+            if (Metric::is_metric || node.is_leaf()) continue;
+        } else {
+            visited += 1;
+            distance = metric(query, node.get_word()->get_text());
+        }
+        if (distance <= radius && tombstones[index] == false) {
+            Candidate candidate(node.get_word(), distance);
+            if (results.size() < static_cast<size_t>(max_searches)) {
+                results.push_back(std::move(candidate));
+                std::push_heap(results.begin(), results.end(), closer);
+            } else if (closer(candidate, results.front())) {
+                std::pop_heap(results.begin(), results.end(), closer);
+                results.back() = std::move(candidate);
+                std::push_heap(results.begin(), results.end(), closer);
+            }
+            // Once k candidates are held, only strictly closer words can still get in
+            if (results.size() == static_cast<size_t>(max_searches)) {
+                radius = std::min(radius, results.front().second - 1);
+            }
+        }
+
+        // Every word under edge e is exactly e away from this node, so by the triangle
+        // inequality it is at least |distance - e| away from the query. Without a metric only
+        // the length bound is left and every subtree has to be considered
+        for (uint32_t child = node.get_first_child(); child != Node::NONE;
+             child = nodes[child].get_next_sibling()) {
+            const Node &next = nodes[child];
+            int edge_gap = 0;
+            if constexpr (Metric::is_metric) {
+                if (next.get_distance() > distance + radius) break;
+                edge_gap = std::abs(distance - next.get_distance());
+            }
+            int length_gap = std::max({0, next.get_min_length() - query_length,
+                                       query_length - next.get_max_length()});
+            int child_bound = std::max({bound, edge_gap, length_gap * Metric::indel_cost});
+            if (child_bound <= radius) {
+                push(child_bound, child);
             }
         }
-        // Swap prev and curr for the next iteration
-        swap(prev, curr);
     }
-    // The result is in prev[n] after the final swap
-    return prev[sz2];
 }
 
-size_t Tree::calculate_memory_usage(const Node *node) const {
-    if (node == nullptr) return 0;
+template <typename Metric>
+bool BasicTree<Metric>::can_skip(const Node &node, const std::string &query,
+                                 const Histogram &histogram, int max_distance) const {
+    // Without a metric the exact distance steers nothing, so any node may be ruled out
+    if constexpr (Metric::is_metric) {
+        // Inner nodes need their exact distance to choose which children to follow
+        if (node.is_leaf() == false) return false;
+    }
 
-    size_t size = sizeof(Node);
+    // This node only has to be ruled out, cheap lower bounds settle most of them without the DP
+    const std::string &text = node.get_word()->get_text();
+    int length_gap = std::abs(text_length<Metric>(text) - text_length<Metric>(query));
+    return length_gap * Metric::indel_cost > max_distance ||
+           histogram_bound<Metric>(histogram, text) * Metric::min_cost > max_distance;
+}
+
+template <typename Metric>
+void BasicTree<Metric>::push_children(const Node &node, int distance, size_t query_length,
+                                      int max_distance, std::vector<uint32_t> &stack) const {
+    // Edit distance is at least the length difference, so subtrees whose word lengths all fall
+    // outside [query_length - max_distance, query_length + max_distance] are skipped whole
+    int slack = max_distance / Metric::indel_cost;
+    int min_length = static_cast<int>(query_length) - slack;
+    int max_length = static_cast<int>(query_length) + slack;
 
-    for (const auto &[_, child] : node->get_children()) {
-        size += calculate_memory_usage(child.get());
+    // Only children with edge in [distance - max_distance, distance + max_distance] can match
+    size_t mark = stack.size();
+    for (uint32_t child = node.get_first_child(); child != Node::NONE;
+         child = nodes[child].get_next_sibling()) {
+        const Node &next = nodes[child];
+        if constexpr (Metric::is_metric) {
+            if (next.get_distance() < distance - max_distance) continue;
+            if (next.get_distance() > distance + max_distance) break;
+        }
+        if (next.get_max_length() < min_length || next.get_min_length() > max_length) continue;
+        stack.push_back(child);
     }
-    return size;
+    // Smallest edge on top, so children are visited in ascending distance
+    std::reverse(stack.begin() + mark, stack.end());
 }
 
-int Tree::calculate_height(const Node *node) const {
-    if (node == nullptr) return 0;
+template <typename Metric>
+int BasicTree<Metric>::calculate_height() const {
+    if (nodes.empty()) return 0;
 
-    int max_depth = 0;
-    for (const auto &[_, child] : node->get_children()) {
-        max_depth = std::max(max_depth, calculate_height(child.get()));
+    // Children always come after their parent in the vector, so one forward pass is enough
+    std::vector<int> depth(nodes.size(), 1);
+    int max_depth = 1;
+    for (uint32_t i = 0; i < nodes.size(); ++i) {
+        for (uint32_t child = nodes[i].get_first_child(); child != Node::NONE;
+             child = nodes[child].get_next_sibling()) {
+            depth[child] = depth[i] + 1;
+            max_depth = std::max(max_depth, depth[child]);
+        }
     }
-    return 1 + max_depth;
+    return max_depth;
 }
 
+template class BasicTree<Distance::Levenshtein>;
+template class BasicTree<Distance::Unicode>;
+template class BasicTree<Distance::Damerau>;
+template class BasicTree<Distance::Keyboard>;
+
 };  // namespace BK
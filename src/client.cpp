@@ -0,0 +1,108 @@
+#include "client.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+Client::~Client() {
+    disconnect();
+}
+
+bool Client::connect_unix(const std::string &path) {
+    disconnect();
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) return false;
+
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) return false;
+    if (connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == -1) {
+        disconnect();
+        return false;
+    }
+    return true;
+}
+
+bool Client::connect_tcp(int port) {
+    disconnect();
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) return false;
+    if (connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == -1) {
+        disconnect();
+        return false;
+    }
+    int enable = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    return true;
+}
+
+bool Client::is_connected() const {
+    return fd != -1;
+}
+
+void Client::disconnect() {
+    if (fd != -1) {
+        close(fd);
+        fd = -1;
+    }
+    buffer.clear();
+}
+
+bool Client::send_query(const std::string &query) {
+    if (fd == -1) return false;
+
+    std::string line = query + '\n';
+    size_t sent = 0;
+    while (sent < line.size()) {
+        ssize_t size = send(fd, line.data() + sent, line.size() - sent, MSG_NOSIGNAL);
+        if (size == -1 && errno == EINTR) continue;
+        if (size <= 0) return false;
+        sent += size;
+    }
+    return true;
+}
+
+bool Client::receive(std::vector<std::string> &words) {
+    if (fd == -1) return false;
+
+    size_t end;
+    while ((end = buffer.find('\n')) == std::string::npos) {
+        char chunk[4096];
+        ssize_t size = read(fd, chunk, sizeof(chunk));
+        if (size == -1 && errno == EINTR) continue;
+        if (size <= 0) return false;
+        buffer.append(chunk, size);
+    }
+    std::string line = buffer.substr(0, end);
+    buffer.erase(0, end + 1);
+
+    // "<count> word word ..."
+    words.clear();
+    size_t start = line.find(' ');
+    while (start != std::string::npos) {
+        size_t next = line.find(' ', start + 1);
+        words.push_back(line.substr(start + 1, next - start - 1));
+        start = next;
+    }
+    return std::strtoul(line.c_str(), nullptr, 10) == words.size();
+}
+
+bool Client::query(const std::string &query, std::vector<std::string> &words) {
+    return send_query(query) && receive(words);
+}
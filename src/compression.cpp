@@ -0,0 +1,204 @@
+#include "compression.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "memory.hpp"
+
+namespace Compression {
+
+static constexpr size_t MIN_MATCH = 4;
+static constexpr size_t MAX_OFFSET = 65535;
+static constexpr int HASH_BITS = 14;
+
+// Training: substring length, segment length and the size of the substring count table
+static constexpr size_t DMER = 8;
+static constexpr size_t SEGMENT = 64;
+static constexpr int COUNT_BITS = 20;
+
+static uint32_t read32(const char *data) {
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static uint32_t hash(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static size_t dmer(const std::string &data, size_t i) {
+    uint64_t value;
+    std::memcpy(&value, data.data() + i, sizeof(value));
+    return static_cast<size_t>((value * 0x9E3779B97F4A7C15) >> (64 - COUNT_BITS));
+}
+
+// A length past the 15 of its nibble continues in bytes, 255 meaning another byte follows
+static void write_length(size_t length, std::string &output) {
+    for (length -= 15; length >= 255; length -= 255) {
+        output += static_cast<char>(255);
+    }
+    output += static_cast<char>(length);
+}
+
+static bool read_length(std::string_view input, size_t &i, size_t &length) {
+    uint8_t byte;
+    do {
+        if (i >= input.size()) return false;
+        byte = static_cast<uint8_t>(input[i++]);
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+// One sequence, a match of length 0 ends the block
+static void emit(std::string_view literals, size_t offset, size_t match, std::string &output) {
+    size_t literal_nibble = std::min<size_t>(literals.size(), 15);
+    size_t match_nibble = (match == 0) ? 0 : std::min<size_t>(match - MIN_MATCH, 15);
+    output += static_cast<char>(literal_nibble << 4 | match_nibble);
+    if (literals.size() >= 15) write_length(literals.size(), output);
+    output.append(literals);
+    if (match == 0) return;
+    output += static_cast<char>(offset & 0xFF);
+    output += static_cast<char>(offset >> 8);
+    if (match - MIN_MATCH >= 15) write_length(match - MIN_MATCH, output);
+}
+
+std::string train(const std::vector<std::string_view> &samples, size_t size) {
+    std::string data;
+    for (std::string_view sample : samples) data.append(sample);
+    size_t segments = size / SEGMENT;
+    if (data.size() <= size || segments == 0) {
+        return data;
+    }
+
+    // Frequencies of the substrings, hashed into a fixed table so collisions only add noise
+    std::vector<uint32_t> counts(size_t{1} << COUNT_BITS);
+    for (size_t i = 0; i + DMER <= data.size(); ++i) {
+        counts[dmer(data, i)] += 1;
+    }
+
+    // Every epoch, a stretch of the samples, contributes its best segment
+    std::string dictionary;
+    size_t epoch = data.size() / segments;
+    for (size_t begin = 0; begin + SEGMENT <= data.size() && dictionary.size() < size;
+         begin += epoch) {
+        size_t end = std::min(begin + std::max(epoch, SEGMENT), data.size());
+        uint64_t score = 0;
+        for (size_t i = begin; i + DMER <= begin + SEGMENT; ++i) score += counts[dmer(data, i)];
+        uint64_t best = score;
+        size_t best_begin = begin;
+        for (size_t i = begin + 1; i + SEGMENT <= end; ++i) {
+            score += counts[dmer(data, i + SEGMENT - DMER)];
+            score -= counts[dmer(data, i - 1)];
+            if (score > best) {
+                best = score;
+                best_begin = i;
+            }
+        }
+        dictionary.append(data, best_begin, SEGMENT);
+        for (size_t i = best_begin; i + DMER <= best_begin + SEGMENT; ++i) {
+            counts[dmer(data, i)] = 0;  // Covered, later segments should bring something new
+        }
+    }
+    return dictionary;
+}
+
+Codec::Codec(std::string dictionary) : dictionary(std::move(dictionary)) {
+    dictionary_table.assign(size_t{1} << HASH_BITS, 0);
+    for (size_t i = 0; i + MIN_MATCH <= this->dictionary.size(); ++i) {
+        dictionary_table[hash(read32(this->dictionary.data() + i))] = static_cast<uint32_t>(i + 1);
+    }
+}
+
+void Codec::compress(std::string_view input, std::string &output) const {
+    output.clear();
+    std::string history;
+    history.reserve(dictionary.size() + input.size());
+    history.append(dictionary).append(input);
+    std::vector<uint32_t> table = dictionary_table;
+
+    // Greedy: the most recent earlier occurrence of the next four bytes, extended as far as
+    // it goes
+    const char *data = history.data();
+    size_t end = history.size();
+    size_t anchor = dictionary.size();
+    size_t i = anchor;
+    while (i + MIN_MATCH <= end) {
+        uint32_t sequence = read32(data + i);
+        uint32_t &slot = table[hash(sequence)];
+        size_t candidate = slot;
+        slot = static_cast<uint32_t>(i + 1);
+        if (candidate == 0 || i - (candidate - 1) > MAX_OFFSET ||
+            read32(data + candidate - 1) != sequence) {
+            i += 1;
+            continue;
+        }
+        size_t from = candidate - 1;
+        size_t length = MIN_MATCH;
+        while (i + length < end && data[from + length] == data[i + length]) length += 1;
+
+        emit(std::string_view(data + anchor, i - anchor), i - from, length, output);
+        for (size_t k = i + 1; k < i + length && k + MIN_MATCH <= end; ++k) {
+            table[hash(read32(data + k))] = static_cast<uint32_t>(k + 1);
+        }
+        i += length;
+        anchor = i;
+    }
+    emit(std::string_view(data + anchor, end - anchor), 0, 0, output);
+}
+
+bool Codec::decompress(std::string_view input, size_t size, std::string &output) const {
+    output.resize(size);
+    char *out = output.data();
+    size_t o = 0;  // Bytes written
+    size_t i = 0;
+    while (i < input.size()) {
+        uint8_t token = static_cast<uint8_t>(input[i++]);
+        size_t literals = token >> 4;
+        if (literals == 15 && read_length(input, i, literals) == false) return false;
+        if (literals > input.size() - i || literals > size - o) return false;
+        std::memcpy(out + o, input.data() + i, literals);
+        o += literals;
+        i += literals;
+        if (i == input.size()) break;  // The last sequence has no match
+
+        if (input.size() - i < 2) return false;
+        size_t offset = static_cast<uint8_t>(input[i]) | static_cast<uint8_t>(input[i + 1]) << 8;
+        i += 2;
+        size_t match = (token & 15) + MIN_MATCH;
+        if ((token & 15) == 15 && read_length(input, i, match) == false) return false;
+        if (offset == 0 || offset > dictionary.size() + o || match > size - o) return false;
+
+        // The part of the match still in the dictionary, then the part in the output
+        if (offset > o) {
+            size_t from = dictionary.size() - (offset - o);
+            size_t length = std::min(match, offset - o);
+            std::memcpy(out + o, dictionary.data() + from, length);
+            o += length;
+            match -= length;
+        }
+        if (match > 0 && offset >= match) {
+            std::memcpy(out + o, out + o - offset, match);
+        } else {
+            // Overlapping, the match repeats bytes it produces itself
+            for (size_t k = 0; k < match; ++k) out[o + k] = out[o + k - offset];
+        }
+        o += match;
+    }
+    return o == size;
+}
+
+const std::string &Codec::get_dictionary() const {
+    return dictionary;
+}
+
+size_t Codec::get_memory_usage() const {
+    return Memory::of(dictionary) + Memory::of(dictionary_table);
+}
+
+};  // namespace Compression
@@ -0,0 +1,140 @@
+#include "csv.hpp"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Csv {
+
+static constexpr size_t BLOCK_SIZE = 64;
+
+#ifdef __SSE2__
+Block scan(const char *block) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i newline = _mm_set1_epi8('\n');
+    Block result{0, 0, 0};
+    for (int i = 0; i < 4; ++i) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + 16 * i));
+        auto mask = [&](__m128i target) {
+            return static_cast<uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, target)) & 0xFFFF)
+                   << (16 * i);
+        };
+        result.quotes |= mask(quote);
+        result.commas |= mask(comma);
+        result.newlines |= mask(newline);
+    }
+    return result;
+}
+#else
+Block scan(const char *block) {
+    Block result{0, 0, 0};
+    for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+        uint64_t bit = uint64_t(1) << i;
+        if (block[i] == '"') result.quotes |= bit;
+        if (block[i] == ',') result.commas |= bit;
+        if (block[i] == '\n') result.newlines |= bit;
+    }
+    return result;
+}
+#endif
+
+// Bit i becomes the XOR of bits 0 to i: set from an opening quote up to its closing one. A
+// doubled quote flips twice, so escaped quotes never leave the field
+static uint64_t prefix_xor(uint64_t bits) {
+    for (int shift = 1; shift < 64; shift *= 2) {
+        bits ^= bits << shift;
+    }
+    return bits;
+}
+
+Parser::Parser(std::string &buffer) : data(buffer.data()), size(buffer.size()) {}
+
+bool Parser::next(std::vector<std::string_view> &fields) {
+    fields.clear();
+    if (offset >= size) {
+        return false;
+    }
+    while (true) {
+        size_t end = next_separator();
+        bool last = (end >= size || data[end] == '\n');
+        char *begin = data + offset;
+        char *stop = data + std::min(end, size);
+        if (last && stop > begin && stop[-1] == '\r') {
+            --stop;
+        }
+        if (std::memchr(begin, '"', stop - begin) != nullptr) {
+            fields.push_back(unquote(begin, stop));
+        } else {
+            fields.emplace_back(begin, stop - begin);
+        }
+        offset = end + 1;
+        if (last) {
+            return true;
+        }
+    }
+}
+
+size_t Parser::get_offset() const {
+    return std::min(offset, size);
+}
+
+size_t Parser::next_separator() {
+    while (separators == 0) {
+        if (scanned) {
+            block_start += BLOCK_SIZE;
+        }
+        if (block_start >= size) {
+            return size;
+        }
+        Block block;
+        if (size - block_start >= BLOCK_SIZE) {
+            block = scan(data + block_start);
+        } else {
+            char tail[BLOCK_SIZE] = {};  // Zero padding holds no separators
+            std::memcpy(tail, data + block_start, size - block_start);
+            block = scan(tail);
+        }
+        scanned = true;
+
+        uint64_t inside = prefix_xor(block.quotes) ^ (in_quotes ? ~uint64_t(0) : 0);
+        in_quotes = (inside >> 63) != 0;
+        separators = (block.commas | block.newlines) & ~inside;
+    }
+    size_t position = block_start + std::countr_zero(separators);
+    separators &= separators - 1;
+    return position;
+}
+
+std::string_view unquote(char *begin, char *end) {
+    char *write = begin;
+    char *read = begin;
+    bool quoted = false;
+    while (read < end) {
+        char *quote = static_cast<char *>(std::memchr(read, '"', end - read));
+        char *chunk_end = (quote == nullptr) ? end : quote;
+        std::memmove(write, read, chunk_end - read);
+        write += chunk_end - read;
+        if (quote == nullptr) {
+            break;
+        }
+        if (quoted && quote + 1 < end && quote[1] == '"') {
+            *write++ = '"';
+            read = quote + 2;
+        } else {
+            quoted = !quoted;  // Opening or closing quote
+            read = quote + 1;
+        }
+    }
+    return std::string_view(begin, write - begin);
+}
+
+};  // namespace Csv
@@ -0,0 +1,164 @@
+#include "definition_store.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "compression.hpp"
+#include "memory.hpp"
+
+// Share of the raw text the dictionary is trained on, the whole of it for smaller stores
+static constexpr size_t TRAINING_SIZE = 1024 * 1024;
+
+static void write_varint(size_t value, std::string &output) {
+    while (value >= 0x80) {
+        output += static_cast<char>(value | 0x80);
+        value >>= 7;
+    }
+    output += static_cast<char>(value);
+}
+
+static size_t read_varint(std::string_view input, size_t &i) {
+    size_t value = 0;
+    for (int shift = 0; i < input.size(); shift += 7) {
+        uint8_t byte = static_cast<uint8_t>(input[i++]);
+        value |= static_cast<size_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) break;
+    }
+    return value;
+}
+
+uint32_t DefinitionStore::add(const std::vector<std::string> &definitions) {
+    // An entry is its definition count followed by each definition with its length
+    if (pending.size() >= BLOCK_SIZE) {
+        close_block();
+    }
+    if (pending.empty()) {
+        blocks.push_back({entry_count, 0, ""});
+    }
+    write_varint(definitions.size(), pending);
+    for (const std::string &definition : definitions) {
+        write_varint(definition.size(), pending);
+        pending += definition;
+    }
+    return entry_count++;
+}
+
+void DefinitionStore::close_block() {
+    // Kept raw until `seal` has a dictionary to compress them with
+    blocks.back().size = static_cast<uint32_t>(pending.size());
+    blocks.back().data = std::move(pending);
+    pending.clear();
+}
+
+void DefinitionStore::seal() {
+    if (pending.empty() == false) {
+        close_block();
+    }
+    // Blocks spread over the store, so the dictionary sees all of it
+    std::vector<std::string_view> samples;
+    size_t stride = std::max<size_t>(1, blocks.size() * BLOCK_SIZE / TRAINING_SIZE);
+    for (size_t i = 0; i < blocks.size(); i += stride) {
+        samples.push_back(blocks[i].data);
+    }
+    codec = std::make_unique<Compression::Codec>(Compression::train(samples, DICTIONARY_SIZE));
+
+    std::string compressed;
+    for (Block &block : blocks) {
+        raw_size += block.size;
+        codec->compress(block.data, compressed);
+        block.data = std::string(compressed);  // A new string, the raw one's capacity goes
+    }
+    blocks.shrink_to_fit();
+    sealed = true;
+}
+
+std::vector<std::string> DefinitionStore::get(uint32_t entry) const {
+    if (sealed == false || entry >= entry_count) {
+        return {};
+    }
+    auto it = std::upper_bound(
+        blocks.begin(), blocks.end(), entry,
+        [](uint32_t e, const Block &block) { return e < block.first_entry; });
+    size_t index = static_cast<size_t>(it - blocks.begin()) - 1;
+    std::shared_ptr<const std::string> block = load_block(index);
+    if (block == nullptr) {
+        return {};
+    }
+
+    // Skip the entries in front of this one, they are only a few hundred bytes each
+    std::string_view data = *block;
+    size_t i = 0;
+    for (uint32_t e = blocks[index].first_entry; e < entry; ++e) {
+        size_t count = read_varint(data, i);
+        for (size_t k = 0; k < count; ++k) {
+            i += read_varint(data, i);
+        }
+    }
+    std::vector<std::string> definitions(read_varint(data, i));
+    for (std::string &definition : definitions) {
+        size_t length = read_varint(data, i);
+        definition = data.substr(std::min(i, data.size()), length);
+        i += length;
+    }
+    return definitions;
+}
+
+std::shared_ptr<const std::string> DefinitionStore::load_block(size_t index) const {
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        for (size_t i = 0; i < cache.size(); ++i) {
+            if (cache[i].first == index) {
+                std::rotate(cache.begin(), cache.begin() + i, cache.begin() + i + 1);
+                return cache.front().second;
+            }
+        }
+    }
+    // Decompressed without the lock, two readers missing on one block both do the work
+    auto block = std::make_shared<std::string>();
+    if (codec->decompress(blocks[index].data, blocks[index].size, *block) == false) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    if (cache.size() >= CACHED_BLOCKS) {
+        cache.pop_back();
+    }
+    cache.emplace(cache.begin(), index, block);
+    return block;
+}
+
+size_t DefinitionStore::get_entry_count() const {
+    return entry_count;
+}
+
+size_t DefinitionStore::get_raw_size() const {
+    return raw_size;
+}
+
+size_t DefinitionStore::get_compressed_size() const {
+    size_t bytes = (codec != nullptr) ? codec->get_dictionary().size() : 0;
+    for (const Block &block : blocks) {
+        bytes += block.data.size();
+    }
+    return bytes;
+}
+
+size_t DefinitionStore::get_memory_usage() const {
+    size_t bytes = Memory::of(blocks) + Memory::of(pending);
+    for (const Block &block : blocks) {
+        bytes += Memory::of(block.data);
+    }
+    if (codec != nullptr) {
+        bytes += Memory::estimate(sizeof(Compression::Codec)) + codec->get_memory_usage();
+    }
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    bytes += Memory::of(cache);
+    for (const auto &[index, block] : cache) {
+        bytes += Memory::shared_block(sizeof(std::string)) + Memory::of(*block);
+    }
+    return bytes;
+}
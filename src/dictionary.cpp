@@ -1,129 +1,462 @@
 #include "dictionary.hpp"
 
+#include <algorithm>
 #include <cctype>
 #include <fstream>
 #include <iostream>
+#include <iterator>
 #include <memory>
-#include <sstream>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "bk_tree.hpp"
+#include "csv.hpp"
+#include "definition_store.hpp"
+#include "distance.hpp"
+#include "generator.hpp"
+#include "journal.hpp"
+#include "language_model.hpp"
+#include "memory.hpp"
+#include "perfect_hash.hpp"
+#include "phonetic.hpp"
+#include "query_cache.hpp"
 #include "trie_tree.hpp"
+#include "utf8.hpp"
 #include "utility.hpp"
+#include "xor_filter.hpp"
+
+// Share of tombstones in the BK-tree that triggers a background rebuild
+static constexpr double COMPACTION_RATIO = 0.25;
+
+// Changes the filter and perfect hash absorb before a rebuild: a share of the words, so the O(N)
+// rebuild stays amortized O(1) per change, but never fewer than the minimum
+static constexpr double LOOKUP_REBUILD_RATIO = 0.125;
+static constexpr size_t LOOKUP_REBUILD_MIN = 256;
+
+// Fuzzy candidates `correct` hands to the language model, and the log10 cost of each edit
+// between a token and a candidate: a candidate one edit further away needs a hundred times the
+// probability in context to win
+static constexpr int CORRECTION_CANDIDATES = 16;
+static constexpr double CORRECTION_EDIT_COST = 2.0;
+
+// Key form of a text given by the caller, plain lowercase ASCII is used as it is
+static std::string to_key(const std::string &text) {
+    return Utf8::is_key_ascii(text) ? text : Utf8::normalize(text);
+}
+
+// Heap of a word with its text and definitions, as the memory breakdown counts it
+static size_t footprint(const Word &word) {
+    return Memory::shared_block(sizeof(Word)) + Memory::of(word.get_text()) +
+           word.get_definition_memory();
+}
+
+// Merge of two result lists sorted by text, cut to `limit`
+static std::vector<std::shared_ptr<Word>> merge_by_text(
+    const std::vector<std::shared_ptr<Word>> &a, const std::vector<std::shared_ptr<Word>> &b,
+    size_t limit) {
+    std::vector<std::shared_ptr<Word>> merged;
+    merged.reserve(a.size() + b.size());
+    std::merge(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(merged),
+               [](const auto &x, const auto &y) { return x->get_text() < y->get_text(); });
+    if (merged.size() > limit) merged.resize(limit);
+    return merged;
+}
 
 Dictionary::Dictionary() {
-    trie = std::make_unique<Trie::Tree>();
-    bktree = std::make_unique<BK::Tree>();
+    trie = std::make_unique<Trie::LowercaseTree>();
+    bktree = std::make_shared<BK::Tree>();
+    wide_trie = std::make_unique<Trie::Tree>();
+    wide_bktree = std::make_shared<BK::UnicodeTree>();
+    phonetic = std::make_unique<Phonetic::Index>();
+    filter = std::make_unique<Filter::Xor8>();
+    perfect = std::make_unique<PerfectHash::Function>();
     config = std::make_unique<Config>();
-    word_count = 0;
 }
 
 Dictionary::Dictionary(const std::string &filepath) : Dictionary() {
     load(filepath);
 }
 
-void Dictionary::insert(std::shared_ptr<Word> word) {
-    trie->insert(word);
-    bktree->insert(word);
+Dictionary::~Dictionary() {
+    finish_compaction();
+}
+
+bool Dictionary::insert(std::shared_ptr<Word> word) {
+    std::unique_lock<std::mutex> lock(write_mutex);
+    if (successor != nullptr) {
+        std::shared_ptr<Dictionary> next = successor;
+        lock.unlock();
+        return next->insert(word);
+    }
+    if (apply_insert(word) == false) {
+        return false;
+    }
+    Logged logged = record(Journal::Op::Insert, *word);
+    lock.unlock();
+    return commit(logged);
+}
+
+bool Dictionary::remove(const std::string &text) {
+    std::unique_lock<std::mutex> lock(write_mutex);
+    if (successor != nullptr) {
+        std::shared_ptr<Dictionary> next = successor;
+        lock.unlock();
+        return next->remove(text);
+    }
+    std::shared_ptr<Word> word = apply_remove(to_key(text));
+    if (word == nullptr) {
+        return false;
+    }
+    Logged logged = record(Journal::Op::Remove, *word);
+    lock.unlock();
+    return commit(logged);
+}
+
+bool Dictionary::update(const std::string &text,
+                        const std::vector<std::pair<POS, std::string>> &definitions) {
+    std::unique_lock<std::mutex> lock(write_mutex);
+    if (successor != nullptr) {
+        std::shared_ptr<Dictionary> next = successor;
+        lock.unlock();
+        return next->update(text, definitions);
+    }
+    std::shared_ptr<Word> word = apply_update(to_key(text), definitions);
+    if (word == nullptr) {
+        return false;
+    }
+    Logged logged = record(Journal::Op::Update, *word);
+    lock.unlock();
+    return commit(logged);
+}
+
+bool Dictionary::apply_insert(const std::shared_ptr<Word> &word) {
+    if (add(word) == false) {
+        return false;
+    }
+    if (Utf8::is_ascii(word->get_text())) {
+        if (compacting) {
+            backlog.emplace_back(true, word);
+        }
+        compact_if_needed(*bktree.load());  // A replaced word leaves a tombstone
+    } else {
+        compact_wide();
+    }
+    if (cache != nullptr) {
+        cache->clear();  // Cached results may miss the new word
+    }
+    return true;
+}
+
+std::shared_ptr<Word> Dictionary::apply_remove(const std::string &text) {
+    bool ascii = Utf8::is_ascii(text);
+    uint32_t id = find_id(text);
+    if (id == NO_ID) {
+        return nullptr;
+    }
+    std::shared_ptr<Word> word = ascii ? trie->remove(text) : wide_trie->remove(text);
+    std::shared_ptr<BK::Tree> tree = bktree.load();
+    if (ascii == false) {
+        wide_bktree->remove(text);
+    } else {
+        tree->remove(text);
+        if (compacting) {
+            backlog.emplace_back(false, word);
+        }
+    }
+    phonetic->remove(text, id);
+    word_bytes -= footprint(*words[id]);
+    words[id] = nullptr;
+    live_count -= 1;
+    refresh_lookup();
+    if (cache != nullptr) {
+        cache->clear();
+    }
+    if (ascii) {
+        compact_if_needed(*tree);
+    } else {
+        compact_wide();
+    }
+    return word;
+}
+
+std::shared_ptr<Word> Dictionary::apply_update(
+    const std::string &text, const std::vector<std::pair<POS, std::string>> &definitions) {
+    std::shared_ptr<Word> word = search_trie(text);
+    if (word == nullptr) {
+        return nullptr;
+    }
+    // The text stays the same, so every index keeps pointing at the right place
+    word_bytes -= footprint(*word);
+    word->clear_definition();
+    for (const auto &[pos, definition] : definitions) {
+        word->add_pos(pos);
+        word->add_definition(definition);
+    }
+    word_bytes += footprint(*word);
+    if (cache != nullptr) {
+        cache->clear();
+    }
+    return word;
+}
+
+void Dictionary::finish_compaction() {
+    // Taken out under the lock that starts compactions, joined outside it since the compaction
+    // needs the lock to finish
+    std::thread running;
+    {
+        std::lock_guard<std::mutex> lock(write_mutex);
+        running = std::move(compactor);
+    }
+    if (running.joinable()) {
+        running.join();
+    }
+}
+
+bool Dictionary::open_journal(const std::string &journal_path, const std::string &base_path,
+                              size_t checkpoint_size) {
+    auto log = std::make_shared<Journal::Log>();
+    if (log->open(journal_path) == false) {
+        return false;
+    }
+    // Replayed under the lock so no write slips in unlogged. Replayed changes are in the log
+    // already, they must not be logged again
+    std::lock_guard<std::mutex> lock(write_mutex);
+    journal.reset();
+    log->replay([this](const Journal::Record &record) { apply(record); });
+    journal = std::move(log);
+    this->base_path = base_path;
+    this->checkpoint_size = checkpoint_size;
+    return true;
+}
+
+bool Dictionary::checkpoint() {
+    std::lock_guard<std::mutex> lock(write_mutex);
+    return write_checkpoint();
+}
+
+const Journal::Log *Dictionary::get_journal() const {
+    return journal.get();
+}
+
+void Dictionary::hand_over(const std::shared_ptr<Dictionary> &next,
+                           const std::function<void()> &publish) {
+    // Held until `next` is published, a write landing here after the replay would be lost
+    std::lock_guard<std::mutex> lock(write_mutex);
+    if (journal != nullptr) {
+        journal->wait(journal->get_record_count());  // The replay reads synced records only
+        std::lock_guard<std::mutex> next_lock(next->write_mutex);
+        journal->replay([&](const Journal::Record &record) { next->apply(record); });
+        next->journal = std::move(journal);
+        next->base_path = base_path;
+        next->checkpoint_size = checkpoint_size;
+        next->checkpoint_stamp = checkpoint_stamp;
+        successor = next;  // For writers still holding this dictionary
+    }
+    publish();
 }
 
-bool Dictionary::load(const std::string &filepath) {
+bool Dictionary::is_checkpoint(const std::string &path) const {
+    std::lock_guard<std::mutex> lock(write_mutex);
+    return checkpoint_stamp.inode != 0 && Journal::stamp(path) == checkpoint_stamp;
+}
+
+bool Dictionary::load(const std::string &filepath, bool balanced) {
     std::ifstream fin(filepath.c_str(), std::ios::binary);
     if (fin.is_open() == false) {
         return false;
     }
-    // Get total file size
+    // Read whole, the tokenizer hands out fields as views into this buffer
     fin.seekg(0, std::ios::end);
-    std::streampos total_size = fin.tellg();
+    std::string buffer(static_cast<size_t>(fin.tellg()), '\0');
     fin.seekg(0);
+    fin.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    fin.close();
+
+    // Bulk loading extends the tree a rebuild would replace, so none may run meanwhile
+    std::unique_lock<std::mutex> lock(write_mutex);
+    while (compacting) {
+        lock.unlock();
+        finish_compaction();
+        lock.lock();
+    }
 
     // Only show progress for file bigger than 4 megabytes
-    bool show_progress = (total_size > 4 * 1024 * 1024);
+    bool show_progress = (buffer.size() > 4 * 1024 * 1024);
 
-    std::string line;
-    std::getline(fin, line);  // Skip header
+    Csv::Parser parser(buffer);
+    std::vector<std::string_view> fields;
 
     std::shared_ptr<Word> current_word = nullptr;
-    std::string prev_text;
-
-    int line_processed = 0;
 
-    while (std::getline(fin, line)) {
-        std::string text, pos_string, definition;
+    // Balanced mode defers the BK-trees of the words from `first_id` on, so they can be bulk
+    // built with good pivots
+    uint32_t first_id = static_cast<uint32_t>(words.size());
+    size_t rows = 0, skipped = 0;  // Rows of the current word, rows of words left out
+    auto flush = [&](std::shared_ptr<Word> word) {
+        // Checked before interning, the pool only holds words some dictionary stores
+        if (storable(word->get_text()) == false) {
+            skipped += rows;
+            return;
+        }
+        if (interner != nullptr) {
+            word = interner->intern(std::move(word));
+        }
+        if (balanced == false) {
+            add(std::move(word));
+            return;
+        }
+        uint32_t id = find_id(word->get_text());
+        if (id == NO_ID) {
+            insert_trie(word);
+            add_id(std::move(word));
+        } else if (id >= first_id) {
+            insert_trie(word);  // Not in a BK-tree yet
+            word_bytes += footprint(*word) - footprint(*words[id]);
+            words[id] = std::move(word);
+        } else {
+            replace(id, std::move(word));
+        }
+    };
 
-        std::istringstream ss(line);
-        std::getline(ss, text, ',');
-        std::getline(ss, pos_string, ',');
-        POS pos = parse_string(pos_string);
+    int line_processed = 0;
 
-        if (ss.peek() == '"') {
-            ss.get();  // Remove opening quote
-            std::getline(ss, definition, '"');
-        } else {
-            std::getline(ss, definition);  // Fallback
+    bool first = true;
+    while (parser.next(fields)) {
+        if (fields[0].empty()) continue;  // Blank line
+        // Plain word lists have no header, one word per line reads as a row without definition
+        if (std::exchange(first, false) && fields.size() > 1 && fields[0] == "text") continue;
+        std::string_view text = fields[0];
+        std::string folded;
+        if (Utf8::is_key_ascii(text) == false) {
+            folded = Utf8::normalize(text);
+            if (folded.empty()) continue;  // Malformed UTF-8
+            text = folded;
         }
+        std::string_view pos_string = (fields.size() > 1) ? fields[1] : std::string_view();
+        std::string_view definition = (fields.size() > 2) ? fields[2] : std::string_view();
 
-        // If current text differ from previous text
-        if (current_word == nullptr || text != prev_text) {
-            // Insert previous word
+        // Rows of the same word are adjacent, a new text starts a new word
+        if (current_word == nullptr || text != current_word->get_text()) {
             if (current_word) {
-                insert(current_word);
-                word_count += 1;
+                flush(current_word);
             }
-            // Start new word
-            current_word = std::make_shared<Word>(text);
-            prev_text = text;
+            current_word = std::make_shared<Word>(std::string(text));
+            rows = 0;
+        }
+        rows += 1;
+        // A row without part of speech and definition only declares the word
+        if (pos_string.empty() == false || definition.empty() == false) {
+            current_word->add_pos(parse_string(std::string(pos_string)));
+            current_word->add_definition(std::string(definition));
         }
-        current_word->add_pos(pos);
-        current_word->add_definition(definition);
 
         if (show_progress && ++line_processed % 500 == 0) {
-            std::streampos current_pos = fin.tellg();
-            print_progress_bar(static_cast<int>(current_pos), static_cast<int>(total_size));
+            print_progress_bar(static_cast<int>(parser.get_offset() / 1024),
+                               static_cast<int>(buffer.size() / 1024));
         }
     }
     // Last word
     if (current_word) {
-        insert(current_word);
-        word_count += 1;
+        flush(current_word);
+    }
+    if (balanced) {
+        std::vector<std::shared_ptr<Word>> pending, wide_pending;
+        for (uint32_t id = first_id; id < words.size(); ++id) {
+            if (words[id] == nullptr) continue;
+            (Utf8::is_ascii(words[id]->get_text()) ? pending : wide_pending).push_back(words[id]);
+        }
+        bktree.load()->build(std::move(pending));
+        wide_bktree->build(std::move(wide_pending));
+    }
+    rebuild_lookup();
+    if (interner == nullptr) {
+        pack_definitions();
+    }
+    if (cache != nullptr) {
+        cache->clear();
     }
     // Final 100% bar
     if (show_progress) {
         print_progress_bar(1, 1);
         std::cout << std::endl;
     }
-
-    // Set as stable after load a file
-    trie->set_stable(true);
-    bktree->set_stable(true);
-
-    // Load member parameters
-    memory_usage = trie->get_memory_usage() + bktree->get_memory_usage();
-    trie_height = trie->get_height();
-    bktree_height = bktree->get_height();
-
-    fin.close();
+    if (skipped > 0) {
+        log(Status::Warning, "skipped " + std::to_string(skipped) + " rows of " + filepath +
+                                 " with more than letters");
+    }
     return true;
 }
 
-std::vector<std::shared_ptr<Word>> Dictionary::search(const std::string &query) const {
+std::vector<std::shared_ptr<Word>> Dictionary::search(const std::string &query,
+                                                      const std::string &after) const {
+    if (Utf8::is_key_ascii(query) == false) {
+        return search_key(Utf8::normalize(query), after);
+    }
+    return search_key(query, after);
+}
+
+std::vector<std::shared_ptr<Word>> Dictionary::search_key(const std::string &query,
+                                                          const std::string &after) const {
     Mode mode = recognize(query);
+    if (cache == nullptr || mode == Mode::None) {
+        return search_core(query, mode, after);
+    }
+    std::string key = cache_key(query, mode, after);
+    std::vector<std::shared_ptr<Word>> results;
+    if (cache->get(key, results)) {
+        return results;
+    }
+    results = search_core(query, mode, after);
+    cache->put(key, results);
+    return results;
+}
 
+std::vector<std::shared_ptr<Word>> Dictionary::search_core(const std::string &query, Mode mode,
+                                                           const std::string &after) const {
     switch (mode) {
         case Mode::Search: {
-            std::shared_ptr<Word> word = trie->search(query);
+            std::shared_ptr<Word> word = find(query);
             if (word == nullptr) {
-                return bktree->search(query, config->max_distance, config->max_suggestions);
+                std::vector<std::shared_ptr<Word>> results =
+                    search_fuzzy(query, config->max_suggestions);
+                add_phonetic(query, results);
+                return results;
             }
             return {word};
         }
         case Mode::Suggest: {
             std::string prefix = query;
             prefix.pop_back();
-            return trie->suggest(prefix, config->max_suggestions);
+            std::vector<std::shared_ptr<Word>> suggestions;
+            if (Utf8::is_ascii(prefix)) {
+                suggestions = trie->suggest(prefix, config->max_suggestions, after);
+            }
+            if (wide_trie->get_node_count() == 1) {
+                return suggestions;
+            }
+            // Both tries list words in byte order, which for UTF-8 is code point order
+            return merge_by_text(suggestions,
+                                 wide_trie->suggest(prefix, config->max_suggestions, after),
+                                 static_cast<size_t>(config->max_suggestions));
+        }
+        case Mode::Match: {
+            // ASCII words first, then the others, each in the order of its trie
+            size_t limit = static_cast<size_t>(config->max_matches);
+            std::vector<std::shared_ptr<Word>> matches;
+            if (Utf8::is_ascii(query)) {
+                matches = trie->match(query, config->max_matches);
+            }
+            if (matches.size() < limit && wide_trie->get_node_count() > 1) {
+                for (auto &match : wide_trie->match(query, limit - matches.size())) {
+                    matches.push_back(std::move(match));
+                }
+            }
+            return matches;
         }
-        case Mode::Match:
-            return trie->match(query, config->max_matches);
         case Mode::None:
             // NOTE: Disable log for performance
             // log(Status::Warning, "invalid query");
@@ -133,8 +466,110 @@ std::vector<std::shared_ptr<Word>> Dictionary::search(const std::string &query)
     }
 }
 
-void Dictionary::set_stable(bool stable) {
-    this->stable = stable;
+Generator<std::shared_ptr<Word>> Dictionary::stream(std::string query) const {
+    if (Utf8::is_key_ascii(query) == false) {
+        query = Utf8::normalize(query);
+    }
+    Mode mode = recognize(query);
+
+    if (mode == Mode::Search) {
+        std::shared_ptr<Word> word = find(query);
+        if (word != nullptr) {
+            co_yield word;
+            co_return;
+        }
+        // The snapshots keep the trees alive even if a compaction replaces them meanwhile
+        std::shared_ptr<BK::Tree> tree = bktree.load();
+        std::shared_ptr<BK::UnicodeTree> wide_tree = wide_bktree;
+        int max_distance = config->max_distance;
+        // See search_fuzzy for the slack
+        int slack = static_cast<int>(query.size() - Utf8::length(query));
+        for (const std::shared_ptr<Word> &match :
+             tree->search_stream(query, max_distance + slack)) {
+            if (slack == 0 || Distance::unicode(query, match->get_text()) <= max_distance) {
+                co_yield match;
+            }
+        }
+        for (const std::shared_ptr<Word> &match : wide_tree->search_stream(query, max_distance)) {
+            co_yield match;
+        }
+    } else if (mode == Mode::Suggest) {
+        query.pop_back();
+        if (Utf8::is_ascii(query)) {
+            for (const std::shared_ptr<Word> &suggestion : trie->suggest_stream(query)) {
+                co_yield suggestion;
+            }
+        }
+        for (const std::shared_ptr<Word> &suggestion : wide_trie->suggest_stream(query)) {
+            co_yield suggestion;
+        }
+    } else if (mode == Mode::Match) {
+        if (Utf8::is_ascii(query)) {
+            for (const std::shared_ptr<Word> &match : trie->match_stream(query)) {
+                co_yield match;
+            }
+        }
+        for (const std::shared_ptr<Word> &match : wide_trie->match_stream(query)) {
+            co_yield match;
+        }
+    }
+}
+
+bool Dictionary::contains(const std::string &text) const {
+    if (Utf8::is_key_ascii(text) == false) {
+        return find(Utf8::normalize(text)) != nullptr;
+    }
+    return find(text) != nullptr;
+}
+
+std::vector<std::vector<std::shared_ptr<Word>>> Dictionary::correct(
+    const std::vector<std::string> &sentence) const {
+    std::vector<std::string> keys;
+    std::vector<std::vector<std::shared_ptr<Word>>> corrections(sentence.size());
+    int limit = (model != nullptr) ? std::max(config->max_suggestions, CORRECTION_CANDIDATES)
+                                   : config->max_suggestions;
+    for (size_t i = 0; i < sentence.size(); ++i) {
+        keys.push_back(to_key(sentence[i]));
+        if (recognize(keys[i]) != Mode::Search) continue;
+        if (std::shared_ptr<Word> word = find(keys[i])) {
+            corrections[i] = {word};
+            continue;
+        }
+        corrections[i] = search_fuzzy(keys[i], limit);
+        add_phonetic(keys[i], corrections[i]);
+    }
+    if (model == nullptr) {
+        return corrections;
+    }
+
+    // A token without candidates still takes part as the word it is
+    std::vector<std::vector<Language::Candidate>> lattice(sentence.size());
+    for (size_t i = 0; i < sentence.size(); ++i) {
+        if (corrections[i].empty()) {
+            lattice[i].push_back({keys[i], 0.0});
+        }
+        for (const std::shared_ptr<Word> &word : corrections[i]) {
+            int distance = Distance::unicode(keys[i], word->get_text());
+            lattice[i].push_back({word->get_text(), -CORRECTION_EDIT_COST * distance});
+        }
+    }
+    std::vector<std::vector<double>> scores = model->score(lattice);
+
+    // Equal scores keep the order of distance, then text
+    for (size_t i = 0; i < sentence.size(); ++i) {
+        if (corrections[i].size() < 2) continue;
+        std::vector<size_t> order(corrections[i].size());
+        for (size_t k = 0; k < order.size(); ++k) order[k] = k;
+        std::stable_sort(order.begin(), order.end(),
+                         [&](size_t a, size_t b) { return scores[i][a] > scores[i][b]; });
+        size_t keep = std::min(order.size(), static_cast<size_t>(config->max_suggestions));
+        std::vector<std::shared_ptr<Word>> ranked;
+        for (size_t k = 0; k < keep; ++k) {
+            ranked.push_back(std::move(corrections[i][order[k]]));
+        }
+        corrections[i] = std::move(ranked);
+    }
+    return corrections;
 }
 
 void Dictionary::set_config(const Config &cfg) {
@@ -143,36 +578,520 @@ void Dictionary::set_config(const Config &cfg) {
     config->max_matches = cfg.max_matches;
 }
 
-int Dictionary::get_stable() const {
-    return stable;
+void Dictionary::set_interner(std::shared_ptr<Interner> interner) {
+    this->interner = std::move(interner);
+}
+
+void Dictionary::set_language_model(std::shared_ptr<const Language::Model> model) {
+    this->model = std::move(model);
+}
+
+void Dictionary::set_cache_capacity(size_t capacity) {
+    if (capacity == 0) {
+        cache.reset();
+        return;
+    }
+    cache = std::make_unique<QueryCache>(capacity);
 }
 
 int Dictionary::get_word_count() const {
-    return word_count;
+    return static_cast<int>(live_count);
 }
 
-size_t Dictionary::get_memory_usage() {
-    if (stable == false || memory_usage == 0) {
-        memory_usage = trie->get_memory_usage() + bktree->get_memory_usage();
-        stable = true;
+Memory::Usage Dictionary::get_memory_breakdown(std::unordered_set<const Word *> *counted) const {
+    Memory::Usage usage = get_index_usage();
+
+    // Words shared with other dictionaries through the interner are stored once
+    std::unordered_set<const Word *> local;
+    bool alone = (counted == nullptr);
+    if (alone) {
+        counted = &local;
+    }
+    size_t walked = 0;
+    for (const std::shared_ptr<Word> &word : words) {
+        if (word == nullptr || counted->insert(word.get()).second == false) continue;
+        usage.words += Memory::shared_block(sizeof(Word)) + Memory::of(word->get_text());
+        usage.definitions += word->get_definition_memory();
+        walked += footprint(*word);
     }
-    return memory_usage;
+    // Words changed directly rather than through `update` leave the running figure behind
+    if (alone && walked != word_bytes) {
+        log(Status::Warning, "word memory was off by " +
+                                 std::to_string(static_cast<long long>(walked - word_bytes)) +
+                                 " bytes, words were changed outside update");
+        word_bytes = walked;
+    }
+    return usage;
+}
+
+size_t Dictionary::get_memory_usage() const {
+    return get_index_usage().total() + word_bytes;
 }
 
-int Dictionary::get_trie_height() {
-    if (stable == false || trie_height == 0) {
-        trie_height = trie->get_height();
-        stable = true;
+Memory::Usage Dictionary::get_index_usage() const {
+    // Everything but the words themselves, from figures the structures maintain
+    Memory::Usage usage;
+    usage.trie = trie->get_memory_usage() + wide_trie->get_memory_usage();
+    usage.bktree = bktree.load()->get_memory_usage() + wide_bktree->get_memory_usage();
+    usage.words = Memory::of(words);
+    usage.lookup = phonetic->get_memory_usage() + filter->get_memory_usage() +
+                   perfect->get_memory_usage() + Memory::of(slots) +
+                   Memory::of_hashed(recent, false);
+    usage.cache = (cache != nullptr) ? cache->get_memory_usage() : 0;
+    for (const auto &store : stores) {
+        usage.definitions += Memory::shared_block(sizeof(DefinitionStore)) +
+                             store->get_memory_usage();
     }
-    return trie_height;
+    return usage;
 }
 
-int Dictionary::get_bktree_height() {
-    if (stable == false || bktree_height == 0) {
-        bktree_height = bktree->get_height();
-        stable = true;
+int Dictionary::get_trie_height() const {
+    return trie->get_height();
+}
+
+size_t Dictionary::get_bktree_tombstone_count() const {
+    return bktree.load()->get_tombstone_count() + wide_bktree->get_tombstone_count();
+}
+
+int Dictionary::get_bktree_height() const {
+    return bktree.load()->get_height();
+}
+
+double Dictionary::get_bktree_average_visits() const {
+    return bktree.load()->get_average_visits();
+}
+
+const QueryCache *Dictionary::get_cache() const {
+    return cache.get();
+}
+
+const Filter::Xor8 &Dictionary::get_filter() const {
+    return *filter;
+}
+
+bool Dictionary::audit() const {
+    // Every live word is reachable from its trie and through the filter, and has its own live
+    // node in one of the BK-trees
+    std::shared_ptr<BK::Tree> tree = bktree.load();
+    size_t nodes = tree->get_node_count() - tree->get_tombstone_count() +
+                   wide_bktree->get_node_count() - wide_bktree->get_tombstone_count();
+    if (nodes != live_count) return false;
+    size_t live = 0;
+    for (const std::shared_ptr<Word> &word : words) {
+        if (word == nullptr) continue;
+        std::shared_ptr<Word> stored = search_trie(word->get_text());
+        if (stored == nullptr || find(word->get_text()) != stored) return false;
+        live += 1;
+    }
+    size_t walked = 0;
+    for (const std::shared_ptr<Word> &word : words) {
+        if (word != nullptr) walked += footprint(*word);
+    }
+    return live == live_count && walked == word_bytes && trie->audit() && tree->audit() &&
+           wide_trie->audit() && wide_bktree->audit();
+}
+
+bool Dictionary::add(std::shared_ptr<Word> word) {
+    // Stored in key form, the form queries are normalized to
+    if (Utf8::is_key_ascii(word->get_text()) == false) {
+        std::string key = Utf8::normalize(word->get_text());
+        if (key.empty()) {
+            return false;  // Malformed UTF-8
+        }
+        word->set_text(key);
+    }
+    // A word with the text of a live one replaces it under its ID
+    uint32_t id = find_id(word->get_text());
+    if (id != NO_ID) {
+        replace(id, std::move(word));
+        return true;
+    }
+    if (insert_trie(word) == false) {
+        return false;
+    }
+    if (Utf8::is_ascii(word->get_text())) {
+        bktree.load()->insert(word);
+    } else {
+        wide_bktree->insert(word);
+    }
+    add_id(std::move(word));
+    refresh_lookup();
+    return true;
+}
+
+void Dictionary::replace(uint32_t id, std::shared_ptr<Word> word) {
+    // The old BK-tree node becomes a tombstone, the trie entry is swapped
+    const std::string &text = word->get_text();
+    insert_trie(word);
+    if (Utf8::is_ascii(text)) {
+        std::shared_ptr<BK::Tree> tree = bktree.load();
+        tree->remove(text);
+        tree->insert(word);
+        if (compacting) {
+            backlog.emplace_back(false, words[id]);
+        }
+    } else {
+        wide_bktree->remove(text);
+        wide_bktree->insert(word);
+    }
+    word_bytes += footprint(*word) - footprint(*words[id]);
+    words[id] = std::move(word);
+}
+
+void Dictionary::compress_definitions() {
+    std::lock_guard<std::mutex> lock(write_mutex);
+    pack_definitions();
+}
+
+void Dictionary::pack_definitions() {
+    // Stores whose words were all updated or removed since are only held here
+    std::erase_if(stores, [](const auto &store) { return store.use_count() == 1; });
+
+    // Word ID order is file order, so neighbouring words share a block
+    std::vector<Word *> packed;
+    auto store = std::make_shared<DefinitionStore>();
+    for (const std::shared_ptr<Word> &word : words) {
+        if (word == nullptr || word->get_store() != nullptr || word->has_definition() == false) {
+            continue;
+        }
+        store->add(word->get_definition());
+        packed.push_back(word.get());
+    }
+    if (packed.empty() == false) {
+        store->seal();
+        for (uint32_t entry = 0; entry < packed.size(); ++entry) {
+            packed[entry]->set_store(store, entry);
+        }
+        stores.push_back(std::move(store));
+    }
+
+    // Recounted, other dictionaries may have packed the interned words shared with this one
+    word_bytes = 0;
+    for (const std::shared_ptr<Word> &word : words) {
+        if (word != nullptr) word_bytes += footprint(*word);
+    }
+}
+
+void Dictionary::add_id(std::shared_ptr<Word> word) {
+    uint32_t id = static_cast<uint32_t>(words.size());
+    phonetic->insert(word->get_text(), id);
+    recent[Filter::hash(word->get_text())] = id;
+    word_bytes += footprint(*word);
+    words.push_back(std::move(word));
+    live_count += 1;
+}
+
+bool Dictionary::storable(const std::string &text) {
+    // The ASCII trie only stores a-z, the other one any byte so letters are checked here
+    if (Utf8::is_ascii(text)) {
+        return text.empty() == false &&
+               std::all_of(text.begin(), text.end(), Trie::Lowercase::contains);
+    }
+    return Utf8::is_letters(text);
+}
+
+bool Dictionary::insert_trie(const std::shared_ptr<Word> &word) {
+    const std::string &text = word->get_text();
+    if (storable(text) == false) {
+        return false;
+    }
+    return Utf8::is_ascii(text) ? trie->insert(word) : wide_trie->insert(word);
+}
+
+std::shared_ptr<Word> Dictionary::search_trie(const std::string &text) const {
+    return Utf8::is_ascii(text) ? trie->search(text) : wide_trie->search(text);
+}
+
+bool Dictionary::filtered_out(const std::string &text) const {
+    uint64_t key = Filter::hash(text);
+    return filter->contains(key) == false && recent.count(key) == 0;
+}
+
+std::shared_ptr<Word> Dictionary::find(const std::string &text) const {
+    uint64_t key = Filter::hash(text);
+    if (filter->contains(key) == false && recent.count(key) == 0) {
+        return nullptr;  // Definitely absent
+    }
+    uint32_t id = slot_id(key, text);
+    if (id != NO_ID) {
+        return words[id];
+    }
+    // A false positive of the filter, or a text whose key collides with another's
+    return search_trie(text);
+}
+
+uint32_t Dictionary::find_id(const std::string &text) const {
+    uint32_t id = slot_id(Filter::hash(text), text);
+    if (id != NO_ID) {
+        return id;
+    }
+    // Only a text sharing its 64-bit key with another gets this far while stored
+    std::shared_ptr<Word> word = search_trie(text);
+    if (word == nullptr) {
+        return NO_ID;
+    }
+    auto found = std::find(words.begin(), words.end(), word);
+    return found == words.end() ? NO_ID : static_cast<uint32_t>(found - words.begin());
+}
+
+uint32_t Dictionary::slot_id(uint64_t key, const std::string &text) const {
+    auto match = [&](uint32_t id) { return words[id] != nullptr && words[id]->get_text() == text; };
+    auto added = recent.find(key);
+    if (added != recent.end() && match(added->second)) {
+        return added->second;
+    }
+    uint32_t id = slots.empty() ? NO_ID : slots[perfect->lookup(key)];
+    return id != NO_ID && match(id) ? id : NO_ID;
+}
+
+void Dictionary::refresh_lookup() {
+    lookup_changes += 1;
+    size_t threshold = static_cast<size_t>(static_cast<double>(live_count) * LOOKUP_REBUILD_RATIO);
+    if (lookup_changes > std::max(threshold, LOOKUP_REBUILD_MIN)) {
+        rebuild_lookup();
+    }
+}
+
+void Dictionary::rebuild_lookup() {
+    // (key, ID) of the live words, texts with colliding keys share a slot the trie settles
+    std::vector<std::pair<uint64_t, uint32_t>> entries;
+    entries.reserve(live_count);
+    for (uint32_t id = 0; id < words.size(); ++id) {
+        if (words[id] != nullptr) entries.emplace_back(Filter::hash(words[id]->get_text()), id);
+    }
+    std::sort(entries.begin(), entries.end());
+    std::vector<uint64_t> keys;
+    std::vector<uint32_t> ids;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (i + 1 < entries.size() && entries[i + 1].first == entries[i].first) continue;
+        keys.push_back(entries[i].first);
+        ids.push_back(entries[i].second);
     }
-    return bktree_height;
+
+    perfect->build(keys);
+    slots.assign(keys.size(), 0);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        slots[perfect->lookup(keys[i])] = ids[i];
+    }
+    filter->build(std::move(keys));
+    recent.clear();
+    lookup_changes = 0;
+}
+
+Dictionary::Logged Dictionary::record(Journal::Op op, const Word &word) {
+    if (journal == nullptr) {
+        return {};
+    }
+    Journal::Record record{op, word.get_text(), {}};
+    if (op != Journal::Op::Remove) {
+        const std::vector<POS> &pos = word.get_pos();
+        const std::vector<std::string> &definition = word.get_definition();
+        for (size_t i = 0; i < std::min(pos.size(), definition.size()); ++i) {
+            record.definitions.emplace_back(pos[i], definition[i]);
+        }
+    }
+    return {journal, journal->enqueue(record), checkpoint_size};
+}
+
+bool Dictionary::commit(const Logged &logged) {
+    if (logged.log == nullptr) {
+        return true;
+    }
+    // Waiting outside the write lock lets concurrent writers share one sync
+    bool synced = logged.log->wait(logged.sequence);
+    if (logged.checkpoint_size > 0 && logged.log->get_size() >= logged.checkpoint_size) {
+        std::lock_guard<std::mutex> lock(write_mutex);
+        // Another writer may have been faster, or the log replaced meanwhile
+        if (journal == logged.log && journal->get_size() >= checkpoint_size) {
+            write_checkpoint();
+        }
+    }
+    return synced;
+}
+
+void Dictionary::apply(const Journal::Record &record) {
+    // Idempotent, so a crash between a checkpoint and its log reset replays harmlessly. Runs
+    // under the write lock
+    std::string text = to_key(record.text);
+    switch (record.op) {
+        case Journal::Op::Insert:
+            if (search_trie(text) == nullptr) {
+                auto word = std::make_shared<Word>(text);
+                for (const auto &[pos, definition] : record.definitions) {
+                    word->add_pos(pos);
+                    word->add_definition(definition);
+                }
+                apply_insert(word);
+                break;
+            }
+            apply_update(text, record.definitions);
+            break;
+        case Journal::Op::Update:
+            apply_update(text, record.definitions);
+            break;
+        case Journal::Op::Remove:
+            apply_remove(text);
+            break;
+    }
+}
+
+bool Dictionary::write_checkpoint() {
+    if (journal == nullptr) {
+        return false;
+    }
+    // One entry per text, the one the trie returns
+    std::vector<const Word *> live;
+    live.reserve(live_count);
+    for (const std::shared_ptr<Word> &word : words) {
+        if (word != nullptr && search_trie(word->get_text()) == word) {
+            live.push_back(word.get());
+        }
+    }
+    std::sort(live.begin(), live.end(), [](const Word *a, const Word *b) {
+        return a->get_text() < b->get_text();
+    });
+
+    std::string data = "text,pos,definition\n";
+    for (const Word *word : live) {
+        const std::vector<POS> &pos = word->get_pos();
+        const std::vector<std::string> &definition = word->get_definition();
+        size_t count = std::min(pos.size(), definition.size());
+        if (count == 0) {
+            data += word->get_text() + ",,\n";
+        }
+        for (size_t i = 0; i < count; ++i) {
+            data += word->get_text() + ',' + parse_pos(pos[i]) + ",\"";
+            for (char c : definition[i]) {
+                if (c == '"') data += '"';
+                data += c;
+            }
+            data += "\"\n";
+        }
+    }
+    // The new base holds every logged change, so the log can start over
+    if (Journal::write_file(base_path, data) == false) {
+        return false;
+    }
+    checkpoint_stamp = Journal::stamp(base_path);  // Tells a watcher the rename was ours
+    return journal->reset();
+}
+
+void Dictionary::compact_if_needed(const BK::Tree &tree) {
+    if (compacting || tree.get_tombstone_count() < COMPACTION_RATIO * tree.get_node_count()) {
+        return;
+    }
+    std::vector<std::shared_ptr<Word>> live;
+    live.reserve(live_count);
+    for (const std::shared_ptr<Word> &word : words) {
+        if (word != nullptr && Utf8::is_ascii(word->get_text())) live.push_back(word);
+    }
+    if (compactor.joinable()) {
+        compactor.join();  // The previous one is done, only its thread is left to exit
+    }
+    compacting = true;
+    compactor = std::thread(&Dictionary::compact, this, std::move(live));
+}
+
+void Dictionary::compact(std::vector<std::shared_ptr<Word>> live) {
+    // The rebuild runs without the lock, queries keep using the current tree meanwhile
+    std::shared_ptr<BK::Tree> tree = std::make_shared<BK::Tree>();
+    tree->build(std::move(live));
+
+    // Catch up with the writes made during the rebuild, then publish the new tree
+    std::lock_guard<std::mutex> lock(write_mutex);
+    for (const auto &[inserted, word] : backlog) {
+        if (inserted) {
+            tree->insert(word);
+        } else {
+            tree->remove(word->get_text());
+        }
+    }
+    backlog.clear();
+    bktree.store(std::move(tree));
+    compacting = false;
+}
+
+void Dictionary::compact_wide() {
+    // Small next to the ASCII tree, so it is rebuilt under the write lock
+    if (wide_bktree->get_tombstone_count() < COMPACTION_RATIO * wide_bktree->get_node_count()) {
+        return;
+    }
+    std::vector<std::shared_ptr<Word>> live;
+    for (const std::shared_ptr<Word> &word : words) {
+        if (word != nullptr && Utf8::is_ascii(word->get_text()) == false) live.push_back(word);
+    }
+    wide_bktree = std::make_shared<BK::UnicodeTree>();
+    wide_bktree->build(std::move(live));
+}
+
+void Dictionary::add_phonetic(const std::string &query,
+                              std::vector<std::shared_ptr<Word>> &results) const {
+    size_t limit = static_cast<size_t>(config->max_suggestions);
+    if (results.size() >= limit || Phonetic::encode(query) == 0) return;
+
+    // Sound-alikes the BK-tree did not return, closest spelling first
+    std::vector<std::pair<int, std::shared_ptr<Word>>> candidates;
+    for (uint32_t id : phonetic->lookup(query)) {
+        const std::shared_ptr<Word> &word = words[id];
+        if (std::find(results.begin(), results.end(), word) != results.end()) continue;
+        candidates.emplace_back(Distance::unicode(query, word->get_text()), word);
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const auto &a, const auto &b) {
+        if (a.first != b.first) return a.first < b.first;
+        return a.second->get_text() < b.second->get_text();
+    });
+    for (auto &candidate : candidates) {
+        if (results.size() >= limit) break;
+        results.push_back(std::move(candidate.second));
+    }
+}
+
+std::vector<std::shared_ptr<Word>> Dictionary::search_fuzzy(const std::string &query,
+                                                            int limit) const {
+    int max_distance = config->max_distance;
+    std::shared_ptr<BK::Tree> tree = bktree.load();
+    std::shared_ptr<BK::UnicodeTree> wide_tree = wide_bktree;
+    bool wide_words = wide_tree->get_node_count() > wide_tree->get_tombstone_count();
+    if (Utf8::is_ascii(query) && wide_words == false) {
+        return tree->search(query, max_distance, limit);  // Bytes are characters here
+    }
+
+    // Against ASCII words a letter of n bytes costs up to n byte edits instead of one, so the
+    // byte tree is searched that much wider and every candidate ranked in code points
+    int slack = static_cast<int>(query.size() - Utf8::length(query));
+    std::vector<std::pair<int, std::shared_ptr<Word>>> candidates;
+    for (std::shared_ptr<Word> &word : tree->search(query, max_distance + slack, limit)) {
+        candidates.emplace_back(Distance::unicode(query, word->get_text()), std::move(word));
+    }
+    if (wide_words) {
+        for (std::shared_ptr<Word> &word : wide_tree->search(query, max_distance, limit)) {
+            candidates.emplace_back(Distance::unicode(query, word->get_text()), std::move(word));
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const auto &a, const auto &b) {
+        if (a.first != b.first) return a.first < b.first;
+        return a.second->get_text() < b.second->get_text();
+    });
+    std::vector<std::shared_ptr<Word>> results;
+    for (auto &[distance, word] : candidates) {
+        if (distance > max_distance || results.size() >= static_cast<size_t>(limit)) break;
+        results.push_back(std::move(word));
+    }
+    return results;
+}
+
+std::string Dictionary::cache_key(const std::string &query, Mode mode,
+                                  const std::string &after) const {
+    // Results depend on the query, its mode, the active limits and the pagination token
+    std::string key = query;
+    key += '\x1f';
+    key += std::to_string(static_cast<int>(mode));
+    key += ',' + std::to_string(config->max_distance);
+    key += ',' + std::to_string(config->max_suggestions);
+    key += ',' + std::to_string(config->max_matches);
+    key += '\x1f';
+    key += after;
+    return key;
 }
 
 Mode Dictionary::recognize(const std::string &query) const {
@@ -192,11 +1111,30 @@ Query Dictionary::validate(const std::string &query) const {
         q.valid = false;
         return q;  // Empty query
     }
+    // Past ASCII only letters are allowed, the loop below then takes their bytes as such
+    if (Utf8::is_ascii(query) == false) {
+        thread_local std::u32string code_points;
+        if (Utf8::decode(query, code_points) == false) {
+            q.valid = false;
+            return q;  // Malformed UTF-8
+        }
+        for (char32_t code_point : code_points) {
+            if (code_point >= 0x80 && Utf8::is_letter(code_point) == false) {
+                q.valid = false;
+                return q;
+            }
+        }
+    }
     bool seen_wildcards = false;
     char prev_c = '\0';
 
     for (size_t i = 0; i < query.size(); ++i) {
         char c = query[i];
+        if (static_cast<unsigned char>(c) >= 0x80) {
+            seen_wildcards = false;
+            prev_c = c;
+            continue;  // Part of a letter checked above
+        }
 
         if (std::isalpha(c) == false && c != '*' && c != '+' && c != '?' && c != '_') {
             q.valid = false;
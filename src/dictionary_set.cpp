@@ -0,0 +1,184 @@
+#include "dictionary_set.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_set>
+#include <vector>
+
+#include "dictionary.hpp"
+#include "distance.hpp"
+#include "interner.hpp"
+#include "utf8.hpp"
+
+DictionarySet::DictionarySet() {
+    interner = std::make_shared<Interner>();
+}
+
+bool DictionarySet::load(const std::vector<std::string> &filepaths, bool parallel) {
+    std::vector<std::unique_ptr<Dictionary>> loading;
+    for (size_t i = 0; i < filepaths.size(); ++i) {
+        auto dict = std::make_unique<Dictionary>();
+        dict->set_interner(interner);
+        dict->set_config(config);
+        loading.push_back(std::move(dict));
+    }
+
+    // Each thread writes only its own slot
+    std::vector<char> loaded(filepaths.size(), false);
+    if (parallel && filepaths.size() > 1) {
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < filepaths.size(); ++i) {
+            threads.emplace_back([&, i] { loaded[i] = loading[i]->load(filepaths[i]); });
+        }
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+    } else {
+        for (size_t i = 0; i < filepaths.size(); ++i) {
+            loaded[i] = loading[i]->load(filepaths[i]);
+        }
+    }
+
+    bool success = true;
+    for (size_t i = 0; i < filepaths.size(); ++i) {
+        if (loaded[i] == false) {
+            success = false;
+            continue;
+        }
+        loading[i]->set_cache_capacity(cache_capacity);
+        // Only now, the parallel loads compared each other's words while interning them
+        loading[i]->compress_definitions();
+        dictionaries.push_back(std::move(loading[i]));
+        this->filepaths.push_back(filepaths[i]);
+    }
+    return success;
+}
+
+std::vector<std::shared_ptr<Word>> DictionarySet::search(const std::string &text,
+                                                         const std::string &after) const {
+    // Compared with stored texts below, so in their key form like every dictionary makes it
+    const std::string query = Utf8::is_key_ascii(text) ? text : Utf8::normalize(text);
+    Mode mode = recognize(query);
+    if (mode == Mode::None) {
+        return {};
+    }
+
+    std::vector<std::vector<std::shared_ptr<Word>>> results;
+    for (const auto &dict : dictionaries) {
+        results.push_back(dict->search(query, after));
+    }
+
+    // An exact hit anywhere beats every fuzzy one, as it does within a dictionary
+    if (mode == Mode::Search) {
+        for (const auto &result : results) {
+            if (result.size() == 1 && result[0]->get_text() == query) {
+                return result;
+            }
+        }
+    }
+
+    // Fuzzy results rank by distance to the query, then by text like suggestions and matches.
+    // A text found in several dictionaries keeps the copy from the earliest
+    struct Candidate {
+        int distance;
+        size_t dictionary;
+        size_t position;
+        std::shared_ptr<Word> word;
+    };
+    std::vector<Candidate> candidates;
+    for (size_t i = 0; i < results.size(); ++i) {
+        for (size_t j = 0; j < results[i].size(); ++j) {
+            const std::shared_ptr<Word> &word = results[i][j];
+            int distance =
+                (mode == Mode::Search) ? Distance::unicode(query, word->get_text()) : 0;
+            candidates.push_back({distance, i, j, word});
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b) {
+        if (a.distance != b.distance) return a.distance < b.distance;
+        if (a.word->get_text() != b.word->get_text()) {
+            return a.word->get_text() < b.word->get_text();
+        }
+        return std::tie(a.dictionary, a.position) < std::tie(b.dictionary, b.position);
+    });
+
+    size_t limit = static_cast<size_t>(
+        (mode == Mode::Match) ? config.max_matches : config.max_suggestions);
+    std::vector<std::shared_ptr<Word>> merged;
+    std::unordered_set<std::string> seen;
+    for (Candidate &candidate : candidates) {
+        if (merged.size() >= limit) break;
+        if (seen.insert(candidate.word->get_text()).second == false) continue;
+        merged.push_back(std::move(candidate.word));
+    }
+    return merged;
+}
+
+Mode DictionarySet::recognize(const std::string &query) const {
+    if (dictionaries.empty()) {
+        return Mode::None;
+    }
+    return dictionaries.front()->recognize(query);
+}
+
+bool DictionarySet::contains(const std::string &text) const {
+    return std::any_of(dictionaries.begin(), dictionaries.end(),
+                       [&](const auto &dict) { return dict->contains(text); });
+}
+
+void DictionarySet::set_config(const Config &cfg) {
+    config = cfg;
+    for (const auto &dict : dictionaries) {
+        dict->set_config(cfg);
+    }
+}
+
+void DictionarySet::set_cache_capacity(size_t capacity) {
+    cache_capacity = capacity;
+    for (const auto &dict : dictionaries) {
+        dict->set_cache_capacity(capacity);
+    }
+}
+
+size_t DictionarySet::get_dictionary_count() const {
+    return dictionaries.size();
+}
+
+const Dictionary &DictionarySet::get_dictionary(size_t index) const {
+    return *dictionaries.at(index);
+}
+
+const std::string &DictionarySet::get_filepath(size_t index) const {
+    return filepaths.at(index);
+}
+
+int DictionarySet::get_word_count() const {
+    // The first word loaded with each text is pooled, so the pool holds every distinct text
+    return static_cast<int>(interner->get_word_count());
+}
+
+Memory::Usage DictionarySet::get_memory_breakdown() const {
+    Memory::Usage usage;
+    std::unordered_set<const Word *> counted;
+    for (const auto &dict : dictionaries) {
+        usage += dict->get_memory_breakdown(&counted);
+    }
+    usage.words += interner->get_memory_usage();
+    return usage;
+}
+
+size_t DictionarySet::get_memory_usage() const {
+    return get_memory_breakdown().total();
+}
+
+const Interner &DictionarySet::get_interner() const {
+    return *interner;
+}
+
+bool DictionarySet::audit() const {
+    return std::all_of(dictionaries.begin(), dictionaries.end(),
+                       [](const auto &dict) { return dict->audit(); });
+}
@@ -0,0 +1,191 @@
+#include "distance.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "utf8.hpp"
+
+namespace Distance {
+
+// Rows up to this length live on the stack, longer words fall back to the heap
+static constexpr size_t STACK_ROW = 64;
+
+// Bit-parallel Levenshtein (Myers, in Hyyro's formulation) for patterns of at most 64
+// characters: one column of the DP table is encoded as two bit vectors of +1/-1 deltas
+static int levenshtein_bits(std::string_view pattern, std::string_view text) {
+    // Match masks, set for the pattern characters only and cleared again before returning
+    thread_local std::array<uint64_t, 256> peq{};
+    for (size_t i = 0; i < pattern.size(); ++i) {
+        peq[static_cast<unsigned char>(pattern[i])] |= uint64_t{1} << i;
+    }
+
+    uint64_t positive = ~uint64_t{0};
+    uint64_t negative = 0;
+    uint64_t last = uint64_t{1} << (pattern.size() - 1);
+    int score = static_cast<int>(pattern.size());
+
+    for (char c : text) {
+        uint64_t eq = peq[static_cast<unsigned char>(c)];
+        uint64_t xv = eq | negative;
+        uint64_t xh = (((eq & positive) + positive) ^ positive) | eq;
+        uint64_t horizontal_positive = negative | ~(xh | positive);
+        uint64_t horizontal_negative = positive & xh;
+        if (horizontal_positive & last) {
+            score += 1;
+        } else if (horizontal_negative & last) {
+            score -= 1;
+        }
+        horizontal_positive = (horizontal_positive << 1) | 1;
+        horizontal_negative <<= 1;
+        positive = horizontal_negative | ~(xv | horizontal_positive);
+        negative = horizontal_positive & xv;
+    }
+
+    for (char c : pattern) {
+        peq[static_cast<unsigned char>(c)] = 0;
+    }
+    return score;
+}
+
+// Two-row DP for patterns too long for a single machine word, or over code points
+template <typename View>
+static int levenshtein_rows(View s1, View s2) {
+    std::vector<int> prev(s2.size() + 1), curr(s2.size() + 1);
+    for (size_t j = 0; j <= s2.size(); ++j) {
+        prev[j] = static_cast<int>(j);
+    }
+    for (size_t i = 1; i <= s1.size(); ++i) {
+        curr[0] = static_cast<int>(i);
+        for (size_t j = 1; j <= s2.size(); ++j) {
+            if (s1[i - 1] == s2[j - 1]) {
+                curr[j] = prev[j - 1];
+            } else {
+                curr[j] = 1 + std::min({prev[j - 1], prev[j], curr[j - 1]});
+            }
+        }
+        std::swap(prev, curr);
+    }
+    return prev[s2.size()];
+}
+
+int levenshtein(std::string_view s1, std::string_view s2) {
+    // Ensure s1 is the shorter one, it becomes the bit-parallel pattern
+    if (s1.size() > s2.size()) std::swap(s1, s2);
+    if (s1.empty()) return static_cast<int>(s2.size());
+    if (s1.size() <= 64) return levenshtein_bits(s1, s2);
+    return levenshtein_rows(s1, s2);
+}
+
+int unicode(std::string_view s1, std::string_view s2) {
+    if (Utf8::is_ascii(s1) && Utf8::is_ascii(s2)) {
+        return levenshtein(s1, s2);
+    }
+    thread_local std::u32string a, b;
+    Utf8::decode(s1, a);
+    Utf8::decode(s2, b);
+    return levenshtein_rows(std::u32string_view(a), std::u32string_view(b));
+}
+
+int damerau(std::string_view s1, std::string_view s2) {
+    if (s1.size() > s2.size()) std::swap(s1, s2);
+    size_t width = s2.size() + 1;
+
+    // Three rolling rows: a transposition looks two rows back
+    std::array<int, 3 * (STACK_ROW + 1)> buffer;
+    std::vector<int> heap;
+    int *rows = buffer.data();
+    if (width > STACK_ROW + 1) {
+        heap.resize(3 * width);
+        rows = heap.data();
+    }
+    int *before = rows, *prev = rows + width, *curr = rows + 2 * width;
+
+    for (size_t j = 0; j < width; ++j) {
+        prev[j] = static_cast<int>(j);
+    }
+    for (size_t i = 1; i <= s1.size(); ++i) {
+        curr[0] = static_cast<int>(i);
+        for (size_t j = 1; j < width; ++j) {
+            int cost = s1[i - 1] == s2[j - 1] ? 0 : 1;
+            curr[j] = std::min({prev[j - 1] + cost, prev[j] + 1, curr[j - 1] + 1});
+            if (i > 1 && j > 1 && s1[i - 1] == s2[j - 2] && s1[i - 2] == s2[j - 1]) {
+                curr[j] = std::min(curr[j], before[j - 2] + 1);
+            }
+        }
+        std::swap(before, prev);
+        std::swap(prev, curr);
+    }
+    return prev[s2.size()];
+}
+
+// Bitmask of the QWERTY neighbours of every letter, built once from the staggered key layout
+static std::array<uint32_t, 26> make_neighbours() {
+    // Row offsets follow the physical stagger, in quarter keys
+    static constexpr std::string_view rows[] = {"qwertyuiop", "asdfghjkl", "zxcvbnm"};
+    static constexpr int offsets[] = {0, 1, 3};
+
+    std::array<uint32_t, 26> neighbours{};
+    for (int r1 = 0; r1 < 3; ++r1) {
+        for (int r2 = 0; r2 < 3; ++r2) {
+            if (std::abs(r1 - r2) > 1) continue;
+            for (size_t i = 0; i < rows[r1].size(); ++i) {
+                for (size_t j = 0; j < rows[r2].size(); ++j) {
+                    int gap = std::abs(static_cast<int>(4 * i) + offsets[r1] -
+                                       static_cast<int>(4 * j) - offsets[r2]);
+                    // Same row: the keys either side. Next row: keys overlapping this one
+                    bool adjacent = r1 == r2 ? gap == 4 : gap < 4;
+                    if (adjacent) {
+                        neighbours[rows[r1][i] - 'a'] |= uint32_t{1} << (rows[r2][j] - 'a');
+                    }
+                }
+            }
+        }
+    }
+    return neighbours;
+}
+
+bool is_adjacent(char c1, char c2) {
+    static const std::array<uint32_t, 26> neighbours = make_neighbours();
+    if (c1 >= 'A' && c1 <= 'Z') c1 += 'a' - 'A';
+    if (c2 >= 'A' && c2 <= 'Z') c2 += 'a' - 'A';
+    if (c1 < 'a' || c1 > 'z' || c2 < 'a' || c2 > 'z') return false;
+    return (neighbours[c1 - 'a'] >> (c2 - 'a')) & 1;
+}
+
+int keyboard(std::string_view s1, std::string_view s2) {
+    if (s1.size() > s2.size()) std::swap(s1, s2);
+    size_t width = s2.size() + 1;
+    constexpr int indel = Keyboard::indel_cost;
+
+    std::array<int, 2 * (STACK_ROW + 1)> buffer;
+    std::vector<int> heap;
+    int *rows = buffer.data();
+    if (width > STACK_ROW + 1) {
+        heap.resize(2 * width);
+        rows = heap.data();
+    }
+    int *prev = rows, *curr = rows + width;
+
+    for (size_t j = 0; j < width; ++j) {
+        prev[j] = static_cast<int>(j) * indel;
+    }
+    for (size_t i = 1; i <= s1.size(); ++i) {
+        curr[0] = static_cast<int>(i) * indel;
+        for (size_t j = 1; j < width; ++j) {
+            int cost = 0;
+            if (s1[i - 1] != s2[j - 1]) {
+                cost = is_adjacent(s1[i - 1], s2[j - 1]) ? 1 : Keyboard::unit;
+            }
+            curr[j] = std::min({prev[j - 1] + cost, prev[j] + indel, curr[j - 1] + indel});
+        }
+        std::swap(prev, curr);
+    }
+    return prev[s2.size()];
+}
+
+};  // namespace Distance
@@ -0,0 +1,82 @@
+#include "interner.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string_view>
+
+#include "memory.hpp"
+#include "word.hpp"
+
+size_t Interner::Hash::operator()(std::string_view text) const {
+    return std::hash<std::string_view>{}(text);
+}
+
+size_t Interner::Hash::operator()(const std::shared_ptr<Word> &word) const {
+    return (*this)(std::string_view(word->get_text()));
+}
+
+bool Interner::Equal::operator()(const std::shared_ptr<Word> &a,
+                                 const std::shared_ptr<Word> &b) const {
+    return a->get_text() == b->get_text();
+}
+
+bool Interner::Equal::operator()(std::string_view a, const std::shared_ptr<Word> &b) const {
+    return a == b->get_text();
+}
+
+bool Interner::Equal::operator()(const std::shared_ptr<Word> &a, std::string_view b) const {
+    return a->get_text() == b;
+}
+
+Interner::Interner(size_t shard_count) {
+    shard_count = std::max<size_t>(1, shard_count);
+    for (size_t i = 0; i < shard_count; ++i) {
+        shards.push_back(std::make_unique<Shard>());
+    }
+}
+
+std::shared_ptr<Word> Interner::intern(std::shared_ptr<Word> word) {
+    Shard &shard = shard_for(word->get_text());
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.words.find(std::string_view(word->get_text()));
+    if (it == shard.words.end()) {
+        shard.words.insert(word);
+        return word;
+    }
+    const Word &pooled = **it;
+    if (pooled.get_pos() != word->get_pos() || pooled.get_definition() != word->get_definition()) {
+        return word;
+    }
+    shared_count.fetch_add(1, std::memory_order_relaxed);
+    return *it;
+}
+
+size_t Interner::get_word_count() const {
+    size_t count = 0;
+    for (const auto &shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        count += shard->words.size();
+    }
+    return count;
+}
+
+size_t Interner::get_memory_usage() const {
+    size_t bytes = Memory::of(shards);
+    for (const auto &shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        bytes += Memory::block_size(shard.get(), sizeof(Shard)) +
+                 Memory::of_hashed(shard->words, true);
+    }
+    return bytes;
+}
+
+size_t Interner::get_shared_count() const {
+    return shared_count.load(std::memory_order_relaxed);
+}
+
+Interner::Shard &Interner::shard_for(std::string_view text) const {
+    return *shards[Hash{}(text) % shards.size()];
+}
@@ -0,0 +1,315 @@
+#include "journal.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#include "utility.hpp"
+#include "word.hpp"
+
+namespace Journal {
+
+// Length and checksum in front of every payload
+static constexpr size_t HEADER_SIZE = 8;
+
+static constexpr std::array<uint32_t, 256> make_crc_table() {
+    std::array<uint32_t, 256> table{};
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+static constexpr std::array<uint32_t, 256> CRC_TABLE = make_crc_table();
+
+uint32_t crc32(std::string_view data) {
+    uint32_t crc = 0xFFFFFFFFu;
+    for (unsigned char c : data) {
+        crc = CRC_TABLE[(crc ^ c) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+// Fixed little endian so a log survives a move between machines
+static void put_u32(std::string &out, uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) {
+        out.push_back(static_cast<char>((value >> shift) & 0xFF));
+    }
+}
+
+static uint32_t get_u32(const char *in) {
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; --i) {
+        value = (value << 8) | static_cast<unsigned char>(in[i]);
+    }
+    return value;
+}
+
+static void put_string(std::string &out, const std::string &str) {
+    put_u32(out, static_cast<uint32_t>(str.size()));
+    out.append(str);
+}
+
+void encode(const Record &record, std::string &out) {
+    size_t start = out.size();
+    out.append(HEADER_SIZE, '\0');  // Filled in once the payload is known
+
+    out.push_back(static_cast<char>(record.op));
+    put_string(out, record.text);
+    put_u32(out, static_cast<uint32_t>(record.definitions.size()));
+    for (const auto &[pos, definition] : record.definitions) {
+        out.push_back(static_cast<char>(pos));
+        put_string(out, definition);
+    }
+
+    std::string header;
+    std::string_view payload(out.data() + start + HEADER_SIZE, out.size() - start - HEADER_SIZE);
+    put_u32(header, static_cast<uint32_t>(payload.size()));
+    put_u32(header, crc32(payload));
+    out.replace(start, HEADER_SIZE, header);
+}
+
+bool decode(std::string_view payload, Record &record) {
+    size_t offset = 0;
+    auto read_u32 = [&](uint32_t &value) {
+        if (payload.size() - offset < 4) return false;
+        value = get_u32(payload.data() + offset);
+        offset += 4;
+        return true;
+    };
+    auto read_string = [&](std::string &str) {
+        uint32_t length;
+        if (read_u32(length) == false || payload.size() - offset < length) return false;
+        str.assign(payload.data() + offset, length);
+        offset += length;
+        return true;
+    };
+
+    if (payload.empty()) return false;
+    uint8_t op = static_cast<uint8_t>(payload[offset++]);
+    if (op < static_cast<uint8_t>(Op::Insert) || op > static_cast<uint8_t>(Op::Remove)) {
+        return false;
+    }
+    record.op = static_cast<Op>(op);
+    record.definitions.clear();
+
+    uint32_t count;
+    if (read_string(record.text) == false || read_u32(count) == false) return false;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (offset == payload.size()) return false;
+        uint8_t pos = static_cast<uint8_t>(payload[offset++]);
+        if (pos > static_cast<uint8_t>(POS::Undefined)) return false;
+        std::string definition;
+        if (read_string(definition) == false) return false;
+        record.definitions.emplace_back(static_cast<POS>(pos), std::move(definition));
+    }
+    return offset == payload.size();
+}
+
+static bool write_all(int fd, std::string_view data) {
+    while (data.empty() == false) {
+        ssize_t written = ::write(fd, data.data(), data.size());
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data.remove_prefix(static_cast<size_t>(written));
+    }
+    return true;
+}
+
+bool write_file(const std::string &path, std::string_view data) {
+    std::string temp = path + ".tmp";
+    int fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        log(Status::Error, "cannot create " + temp + ": " + std::strerror(errno));
+        return false;
+    }
+    bool written = write_all(fd, data) && ::fsync(fd) == 0;
+    ::close(fd);
+    if (written == false || ::rename(temp.c_str(), path.c_str()) != 0) {
+        log(Status::Error, "cannot write " + path + ": " + std::strerror(errno));
+        ::unlink(temp.c_str());
+        return false;
+    }
+    // The rename itself only survives a crash once the directory is synced
+    size_t slash = path.find_last_of('/');
+    std::string directory = (slash == std::string::npos) ? "." : path.substr(0, slash + 1);
+    int dir_fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd >= 0) {
+        ::fsync(dir_fd);
+        ::close(dir_fd);
+    }
+    return true;
+}
+
+Stamp stamp(const std::string &path) {
+    struct stat info;
+    if (::stat(path.c_str(), &info) != 0) {
+        return {};
+    }
+    int64_t modified =
+        static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+    return {static_cast<uint64_t>(info.st_ino), static_cast<uint64_t>(info.st_size), modified};
+}
+
+Log::~Log() {
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+bool Log::open(const std::string &path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        log(Status::Error, "cannot open journal " + path + ": " + std::strerror(errno));
+        return false;
+    }
+    struct stat info;
+    size = (::fstat(fd, &info) == 0) ? static_cast<size_t>(info.st_size) : 0;
+    buffer.clear();
+    appended = durable = 0;
+    flushing = failed = false;
+    sync_count = replay_count = 0;
+    return true;
+}
+
+bool Log::is_open() const {
+    return fd >= 0;
+}
+
+size_t Log::replay(const std::function<void(const Record &)> &apply) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (fd < 0) return 0;
+
+    std::string data(size, '\0');
+    size_t read_size = 0;
+    while (read_size < data.size()) {
+        ssize_t count = ::pread(fd, data.data() + read_size, data.size() - read_size,
+                                static_cast<off_t>(read_size));
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) break;
+        read_size += static_cast<size_t>(count);
+    }
+    data.resize(read_size);
+
+    size_t offset = 0;
+    size_t count = 0;
+    Record record;
+    while (data.size() - offset >= HEADER_SIZE) {
+        uint32_t length = get_u32(data.data() + offset);
+        uint32_t checksum = get_u32(data.data() + offset + 4);
+        if (data.size() - offset - HEADER_SIZE < length) break;  // Torn by a crash mid-write
+
+        std::string_view payload(data.data() + offset + HEADER_SIZE, length);
+        if (crc32(payload) != checksum || decode(payload, record) == false) break;
+        apply(record);
+        offset += HEADER_SIZE + length;
+        count += 1;
+    }
+    replay_count = count;
+    if (offset < size) {
+        log(Status::Warning, "dropped " + std::to_string(size - offset) +
+                                 " bytes of torn or corrupt records from the journal");
+        if (::ftruncate(fd, static_cast<off_t>(offset)) == 0) {
+            ::fsync(fd);
+        }
+        size = offset;
+    }
+    return count;
+}
+
+uint64_t Log::enqueue(const Record &record) {
+    std::lock_guard<std::mutex> lock(mutex);
+    encode(record, buffer);
+    return ++appended;
+}
+
+bool Log::wait(uint64_t sequence) {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (durable < sequence) {
+        if (failed || fd < 0) return false;
+        if (flushing) {
+            flushed.wait(lock);
+            continue;
+        }
+        // Lead the next batch: everything buffered so far goes out with a single sync
+        flushing = true;
+        std::string batch;
+        batch.swap(buffer);
+        uint64_t target = appended;
+        lock.unlock();
+
+        bool synced = write_all(fd, batch) && ::fdatasync(fd) == 0;
+
+        lock.lock();
+        flushing = false;
+        if (synced) {
+            durable = target;
+            size += batch.size();
+            sync_count += 1;
+        } else {
+            log(Status::Error, std::string("cannot write journal: ") + std::strerror(errno));
+            failed = true;
+        }
+        flushed.notify_all();
+    }
+    return true;
+}
+
+bool Log::append(const Record &record) {
+    return wait(enqueue(record));
+}
+
+bool Log::reset() {
+    std::unique_lock<std::mutex> lock(mutex);
+    flushed.wait(lock, [this]() { return flushing == false; });
+    if (fd < 0 || ::ftruncate(fd, 0) != 0 || ::fsync(fd) != 0) {
+        return false;
+    }
+    buffer.clear();
+    durable = appended;
+    size = 0;
+    failed = false;
+    flushed.notify_all();
+    return true;
+}
+
+size_t Log::get_size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return size;
+}
+
+size_t Log::get_record_count() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return appended;
+}
+
+size_t Log::get_sync_count() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return sync_count;
+}
+
+size_t Log::get_replay_count() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return replay_count;
+}
+
+};  // namespace Journal
@@ -0,0 +1,462 @@
+#include "language_model.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "journal.hpp"
+#include "utf8.hpp"
+
+namespace Language {
+
+// Absolute discount taken from every seen pair and handed to the fallback, the usual value for
+// Kneser-Ney style smoothing
+static constexpr double DISCOUNT = 0.75;
+
+// Quantized values never go below this log10 probability, so one rare outlier cannot stretch
+// the byte range for everyone else
+static constexpr double FLOOR = -12.0;
+
+// File layout: this header, then keys, slots, offsets, followers, pair values, word values and
+// backoff values, each tightly packed in native byte order. 64 bit arrays come first so every
+// array stays aligned
+struct Header {
+    char magic[8];
+    uint32_t word_count;
+    uint32_t slot_count;  // A power of two, at least twice the words
+    uint64_t pair_count;
+    float minimum;
+    float step;
+    float unknown;
+    uint32_t reserved;
+};
+
+static constexpr char MAGIC[8] = {'D', 'I', 'C', 'T', 'L', 'M', '0', '2'};
+
+// Key of a word in the file. Spelled out rather than std::hash, whose values differ between
+// standard libraries: FNV-1a, then a final mix so the low bits the slots use depend on every byte
+static uint64_t key_of(std::string_view word) {
+    uint64_t key = 14695981039346656037ull;
+    for (char c : word) {
+        key = (key ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+    }
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    return key;
+}
+
+static size_t file_size(const Header &header) {
+    return sizeof(Header) + header.word_count * sizeof(uint64_t) +
+           header.slot_count * sizeof(uint32_t) + (header.word_count + 1) * sizeof(uint32_t) +
+           header.pair_count * (sizeof(uint32_t) + sizeof(uint8_t)) + header.word_count * 2;
+}
+
+static void finish_word(std::string &word, bool ascii, std::vector<std::string> &sentence) {
+    if (word.empty()) return;
+    sentence.push_back(ascii ? word : Utf8::normalize(word));
+    word.clear();
+}
+
+static void finish_sentence(std::vector<std::string> &sentence,
+                            std::vector<std::vector<std::string>> &sentences) {
+    if (sentence.empty()) return;
+    sentences.push_back(std::move(sentence));
+    sentence.clear();
+}
+
+std::vector<std::vector<std::string>> split(std::string_view text) {
+    std::vector<std::vector<std::string>> sentences;
+    std::vector<std::string> sentence;
+    std::string word;
+    bool ascii = true;
+    int newlines = 0;  // Since the last character that is not white space
+    std::u32string code_points;
+    for (size_t i = 0; i < text.size();) {
+        char c = text[i];
+        if (static_cast<unsigned char>(c) >= 0x80) {
+            size_t length = std::min<size_t>(Utf8::sequence_length(c), text.size() - i);
+            std::string_view sequence = text.substr(i, length);
+            i += length;
+            if (Utf8::decode(sequence, code_points) && code_points.size() == 1 &&
+                Utf8::is_letter(code_points[0])) {
+                word.append(sequence);
+                ascii = false;
+                newlines = 0;
+                continue;
+            }
+            finish_word(word, ascii, sentence);
+            ascii = true;
+            continue;
+        }
+        i += 1;
+        if (std::isalpha(static_cast<unsigned char>(c))) {
+            word += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+            newlines = 0;
+            continue;
+        }
+        finish_word(word, ascii, sentence);
+        ascii = true;
+        if (c == '.' || c == '!' || c == '?' || (c == '\n' && ++newlines == 2)) {
+            finish_sentence(sentence, sentences);
+        } else if (std::isspace(static_cast<unsigned char>(c)) == 0) {
+            newlines = 0;
+        }
+    }
+    finish_word(word, ascii, sentence);
+    finish_sentence(sentence, sentences);
+    return sentences;
+}
+
+Builder::Builder() {
+    ids.emplace("", 0);
+    counts.push_back(0);
+    followed.push_back(0);
+}
+
+uint32_t Builder::id_of(const std::string &word) {
+    auto [it, inserted] = ids.try_emplace(word, static_cast<uint32_t>(counts.size()));
+    if (inserted) {
+        counts.push_back(0);
+        followed.push_back(0);
+    }
+    return it->second;
+}
+
+void Builder::add(std::string_view text) {
+    // Every sentence is framed by the boundary, which counts as one more token
+    for (const std::vector<std::string> &sentence : split(text)) {
+        uint32_t previous = 0;
+        for (const std::string &word : sentence) {
+            uint32_t id = id_of(word);
+            counts[id] += 1;
+            followed[previous] += 1;
+            pairs[static_cast<uint64_t>(previous) << 32 | id] += 1;
+            previous = id;
+        }
+        counts[0] += 1;
+        followed[previous] += 1;
+        pairs[static_cast<uint64_t>(previous) << 32] += 1;
+        token_count += sentence.size() + 1;
+    }
+}
+
+bool Builder::write(const std::string &path, uint64_t min_count) const {
+    min_count = std::max<uint64_t>(min_count, 1);
+
+    // New IDs for the words kept, the boundary stays 0
+    std::vector<const std::string *> texts(counts.size());
+    for (const auto &[text, id] : ids) texts[id] = &text;
+    std::vector<uint32_t> renumbered(counts.size(), Model::UNKNOWN);
+    std::vector<uint32_t> kept;
+    for (uint32_t id = 0; id < counts.size(); ++id) {
+        if (id == 0 || counts[id] >= min_count) {
+            renumbered[id] = static_cast<uint32_t>(kept.size());
+            kept.push_back(id);
+        }
+    }
+    double total = static_cast<double>(std::max<uint64_t>(token_count, 1));
+    std::vector<double> word_log(kept.size()), backoff_log(kept.size(), 0.0);
+    for (size_t i = 0; i < kept.size(); ++i) {
+        word_log[i] = std::log10(std::max<uint64_t>(counts[kept[i]], 1) / total);
+    }
+
+    // Pairs of kept words, ordered by first then second word
+    std::vector<std::tuple<uint32_t, uint32_t, uint32_t>> rows;
+    for (const auto &[key, count] : pairs) {
+        uint32_t first = renumbered[key >> 32];
+        uint32_t second = renumbered[key & UINT32_MAX];
+        if (count >= min_count && first != Model::UNKNOWN && second != Model::UNKNOWN) {
+            rows.emplace_back(first, second, count);
+        }
+    }
+    std::sort(rows.begin(), rows.end());
+
+    // Interpolated absolute discounting: a seen pair keeps its count minus the discount, the
+    // mass set free goes to P(word) through the backoff weight of the first word
+    std::vector<double> pair_log(rows.size());
+    std::vector<uint32_t> offsets(kept.size() + 1, 0);
+    for (size_t begin = 0, end = 0; begin < rows.size(); begin = end) {
+        uint32_t first = std::get<0>(rows[begin]);
+        double context = static_cast<double>(followed[kept[first]]);
+        double kept_mass = 0.0;
+        for (end = begin; end < rows.size() && std::get<0>(rows[end]) == first; ++end) {
+            kept_mass += (std::get<2>(rows[end]) - DISCOUNT) / context;
+        }
+        double weight = 1.0 - kept_mass;
+        backoff_log[first] = std::log10(weight);
+        for (size_t i = begin; i < end; ++i) {
+            double discounted = (std::get<2>(rows[i]) - DISCOUNT) / context;
+            double fallback = weight * std::pow(10.0, word_log[std::get<1>(rows[i])]);
+            pair_log[i] = std::log10(discounted + fallback);
+        }
+        offsets[first + 1] = static_cast<uint32_t>(end - begin);
+    }
+    for (size_t i = 0; i < kept.size(); ++i) offsets[i + 1] += offsets[i];
+
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.word_count = static_cast<uint32_t>(kept.size());
+    header.slot_count = 2;
+    while (header.slot_count < 2 * kept.size()) header.slot_count *= 2;
+    header.pair_count = rows.size();
+    header.unknown = static_cast<float>(std::max(std::log10(0.5 / total), FLOOR));
+    double minimum = -1.0;
+    for (const std::vector<double> *values : {&word_log, &backoff_log, &pair_log}) {
+        for (double value : *values) minimum = std::min(minimum, value);
+    }
+    header.minimum = static_cast<float>(std::max(minimum, FLOOR));
+    header.step = -header.minimum / 255.0f;
+    auto quantize = [&](double value) {
+        double q = std::round((value - header.minimum) / header.step);
+        return static_cast<uint8_t>(std::clamp(q, 0.0, 255.0));
+    };
+
+    std::vector<uint64_t> keys(kept.size(), 0);
+    std::vector<uint32_t> slots(header.slot_count, 0);
+    for (uint32_t id = 1; id < kept.size(); ++id) {
+        keys[id] = key_of(*texts[kept[id]]);
+        uint32_t slot = static_cast<uint32_t>(keys[id]) & (header.slot_count - 1);
+        while (slots[slot] != 0) slot = (slot + 1) & (header.slot_count - 1);
+        slots[slot] = id + 1;
+    }
+
+    std::string data(reinterpret_cast<const char *>(&header), sizeof(header));
+    auto append = [&](const auto &vector) {
+        data.append(reinterpret_cast<const char *>(vector.data()),
+                    vector.size() * sizeof(vector[0]));
+    };
+    append(keys);
+    append(slots);
+    append(offsets);
+    std::vector<uint32_t> followers;
+    std::vector<uint8_t> pair_values;
+    for (size_t i = 0; i < rows.size(); ++i) {
+        followers.push_back(std::get<1>(rows[i]));
+        pair_values.push_back(quantize(pair_log[i]));
+    }
+    append(followers);
+    append(pair_values);
+    std::vector<uint8_t> word_values, backoff_values;
+    for (size_t i = 0; i < kept.size(); ++i) {
+        word_values.push_back(quantize(word_log[i]));
+        backoff_values.push_back(quantize(backoff_log[i]));
+    }
+    append(word_values);
+    append(backoff_values);
+    return Journal::write_file(path, data);
+}
+
+size_t Builder::get_word_count() const {
+    return counts.size() - 1;
+}
+
+size_t Builder::get_pair_count() const {
+    return pairs.size();
+}
+
+uint64_t Builder::get_token_count() const {
+    return token_count;
+}
+
+Model::~Model() {
+    close();
+}
+
+bool Model::open(const std::string &path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(Header)) {
+        ::close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(info.st_size);
+    void *mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);  // The mapping keeps the file
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+    mapping = mapped;
+    mapping_size = size;
+
+    Header header;
+    std::memcpy(&header, mapped, sizeof(header));
+    bool valid = std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 && header.word_count > 0 &&
+                 header.slot_count >= 2 * header.word_count &&
+                 (header.slot_count & (header.slot_count - 1)) == 0 && file_size(header) == size;
+    if (valid == false) {
+        close();
+        return false;
+    }
+    const char *cursor = static_cast<const char *>(mapped) + sizeof(Header);
+    keys = reinterpret_cast<const uint64_t *>(cursor);
+    cursor += header.word_count * sizeof(uint64_t);
+    slots = reinterpret_cast<const uint32_t *>(cursor);
+    cursor += header.slot_count * sizeof(uint32_t);
+    offsets = reinterpret_cast<const uint32_t *>(cursor);
+    cursor += (header.word_count + 1) * sizeof(uint32_t);
+    followers = reinterpret_cast<const uint32_t *>(cursor);
+    cursor += header.pair_count * sizeof(uint32_t);
+    pair_values = reinterpret_cast<const uint8_t *>(cursor);
+    cursor += header.pair_count;
+    word_values = reinterpret_cast<const uint8_t *>(cursor);
+    cursor += header.word_count;
+    backoff_values = reinterpret_cast<const uint8_t *>(cursor);
+
+    word_count = header.word_count;
+    slot_mask = header.slot_count - 1;
+    pair_count = header.pair_count;
+    minimum = header.minimum;
+    step = header.step;
+    unknown = header.unknown;
+
+    // Queries trust these arrays, so a damaged file must not send them out of the mapping or
+    // around the slots forever
+    valid = offsets[word_count] == pair_count;
+    for (uint32_t id = 0; valid && id < word_count; ++id) {
+        valid = offsets[id] <= offsets[id + 1];
+    }
+    for (uint64_t pair = 0; valid && pair < pair_count; ++pair) {
+        valid = followers[pair] < word_count;
+    }
+    uint32_t used = 0;
+    for (uint32_t slot = 0; valid && slot <= slot_mask; ++slot) {
+        valid = slots[slot] <= word_count;
+        used += slots[slot] != 0;
+    }
+    if (valid == false || used > word_count) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void Model::close() {
+    if (mapping != nullptr) {
+        ::munmap(const_cast<void *>(mapping), mapping_size);
+    }
+    mapping = nullptr;
+    mapping_size = 0;
+    word_count = 0;
+    pair_count = 0;
+}
+
+bool Model::is_open() const {
+    return mapping != nullptr;
+}
+
+uint32_t Model::lookup(std::string_view word) const {
+    if (mapping == nullptr || word.empty()) {
+        return UNKNOWN;
+    }
+    uint64_t key = key_of(word);
+    for (uint32_t slot = static_cast<uint32_t>(key) & slot_mask; slots[slot] != 0;
+         slot = (slot + 1) & slot_mask) {
+        if (keys[slots[slot] - 1] == key) return slots[slot] - 1;
+    }
+    return UNKNOWN;
+}
+
+double Model::value(uint8_t quantized) const {
+    return minimum + quantized * step;
+}
+
+double Model::score(uint32_t previous, uint32_t word) const {
+    if (mapping == nullptr || word >= word_count) {
+        return unknown;
+    }
+    if (previous >= word_count) {
+        return value(word_values[word]);
+    }
+    const uint32_t *begin = followers + offsets[previous];
+    const uint32_t *end = followers + offsets[previous + 1];
+    const uint32_t *it = std::lower_bound(begin, end, word);
+    if (it != end && *it == word) {
+        return value(pair_values[it - followers]);
+    }
+    return value(backoff_values[previous]) + value(word_values[word]);
+}
+
+double Model::score(std::string_view previous, std::string_view word) const {
+    uint32_t first = previous.empty() ? BOUNDARY : lookup(previous);
+    uint32_t second = word.empty() ? BOUNDARY : lookup(word);
+    return score(first, second);
+}
+
+std::vector<std::vector<double>> Model::score(
+    const std::vector<std::vector<Candidate>> &sentence) const {
+    // Max-product over the lattice: `forward` is the best score of the sentence up to and
+    // including a candidate, `backward` the best of everything after it. Their sum is the best
+    // reading through the candidate. A position without candidates stands for an unknown word
+    size_t n = sentence.size();
+    std::vector<std::vector<uint32_t>> ids(n);
+    std::vector<std::vector<double>> penalties(n);
+    for (size_t i = 0; i < n; ++i) {
+        for (const Candidate &candidate : sentence[i]) {
+            ids[i].push_back(lookup(candidate.text));
+            penalties[i].push_back(candidate.penalty);
+        }
+        if (ids[i].empty()) {
+            ids[i].push_back(UNKNOWN);
+            penalties[i].push_back(0.0);
+        }
+    }
+
+    std::vector<std::vector<double>> forward(n), backward(n);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t c = 0; c < ids[i].size(); ++c) {
+            double best = (i == 0) ? score(BOUNDARY, ids[i][c]) : -INFINITY;
+            for (size_t p = 0; i > 0 && p < ids[i - 1].size(); ++p) {
+                best = std::max(best, forward[i - 1][p] + score(ids[i - 1][p], ids[i][c]));
+            }
+            forward[i].push_back(best + penalties[i][c]);
+        }
+    }
+    for (size_t i = n; i-- > 0;) {
+        for (size_t c = 0; c < ids[i].size(); ++c) {
+            double best = (i + 1 == n) ? score(ids[i][c], BOUNDARY) : -INFINITY;
+            for (size_t next = 0; i + 1 < n && next < ids[i + 1].size(); ++next) {
+                best = std::max(best, score(ids[i][c], ids[i + 1][next]) +
+                                          penalties[i + 1][next] + backward[i + 1][next]);
+            }
+            backward[i].push_back(best);
+        }
+    }
+
+    std::vector<std::vector<double>> scores(n);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t c = 0; c < sentence[i].size(); ++c) {
+            scores[i].push_back(forward[i][c] + backward[i][c]);
+        }
+    }
+    return scores;
+}
+
+size_t Model::get_word_count() const {
+    return word_count;
+}
+
+size_t Model::get_pair_count() const {
+    return pair_count;
+}
+
+size_t Model::get_file_size() const {
+    return mapping_size;
+}
+
+};  // namespace Language
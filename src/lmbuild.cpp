@@ -0,0 +1,70 @@
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "language_model.hpp"
+#include "utility.hpp"
+
+// Builds the bigram model that ranks corrections from plain text files
+int main(int argc, char *argv[]) {
+    std::vector<std::string> corpus_paths;
+    std::string output_path;
+    uint64_t min_count = 2;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+
+        if (arg.rfind("--corpus=", 0) == 0) {
+            corpus_paths.push_back(arg.substr(9));  // after "--corpus="
+        } else if (arg.rfind("--output=", 0) == 0) {
+            output_path = arg.substr(9);  // after "--output="
+        } else if (arg.rfind("--min-count=", 0) == 0) {
+            min_count = std::strtoull(arg.substr(12).c_str(), nullptr, 10);
+        } else {
+            log(Status::Error, "unknown argument " + arg);
+            corpus_paths.clear();
+            break;
+        }
+    }
+    if (corpus_paths.empty() || output_path.empty()) {
+        log(Status::Info,
+            "usage: dict_lmbuild --corpus=path [--corpus=path ...] --output=path "
+            "[--min-count=number]");
+        return -1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    Language::Builder builder;
+    for (const std::string &path : corpus_paths) {
+        std::ifstream fin(path, std::ios::binary);
+        if (fin.is_open() == false) {
+            log(Status::Error, "cannot open corpus " + path);
+            return -1;
+        }
+        std::stringstream text;
+        text << fin.rdbuf();
+        builder.add(text.str());
+    }
+    if (builder.write(output_path, min_count) == false) {
+        return -1;
+    }
+    double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    Language::Model model;
+    if (model.open(output_path) == false) {
+        log(Status::Error, "cannot read back " + output_path);
+        return -1;
+    }
+    std::cout << "corpus: " << builder.get_token_count() << " tokens, "
+              << builder.get_word_count() << " words, " << builder.get_pair_count()
+              << " pairs\nmodel: " << model.get_word_count() << " words, "
+              << model.get_pair_count() << " pairs kept, " << std::fixed << std::setprecision(1)
+              << model.get_file_size() / 1024.0 << " KB in " << seconds * 1000.0 << " ms\n";
+    return 0;
+}
@@ -0,0 +1,352 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "client.hpp"
+#include "csv.hpp"
+#include "dictionary.hpp"
+#include "utility.hpp"
+#include "workload.hpp"
+
+struct Options {
+    std::string filepath;                        // In-process target
+    std::string socket_path;                     // Server target over a Unix socket
+    int port = 0;                                // Server target over localhost TCP
+    std::string words_path = "../data/all/words.txt";
+    std::string replay_path;
+    Mix mix;
+    size_t requests = 100000;
+    int threads = 1;
+    double rate = 0;  // Total queries per second, 0 means as fast as possible
+    uint64_t seed = 42;
+    bool balanced = true;  // Bulk build the BK-tree of the in-process dictionary
+    std::string journal_path;  // In-process write benchmark against this change log
+    size_t writes = 30000;
+};
+
+static bool parse_options(int argc, char *argv[], Options &options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+
+        if (arg.rfind("--file=", 0) == 0) {
+            options.filepath = arg.substr(7);
+        } else if (arg.rfind("--socket=", 0) == 0) {
+            options.socket_path = arg.substr(9);
+        } else if (arg.rfind("--port=", 0) == 0) {
+            options.port = std::atoi(arg.substr(7).c_str());
+        } else if (arg.rfind("--words=", 0) == 0) {
+            options.words_path = arg.substr(8);
+        } else if (arg.rfind("--replay=", 0) == 0) {
+            options.replay_path = arg.substr(9);
+        } else if (arg.rfind("--mix=", 0) == 0) {
+            if (parse_mix(arg.substr(6), options.mix) == false) return false;
+        } else if (arg.rfind("--requests=", 0) == 0) {
+            options.requests = std::strtoull(arg.substr(11).c_str(), nullptr, 10);
+        } else if (arg.rfind("--threads=", 0) == 0) {
+            options.threads = std::max(1, std::atoi(arg.substr(10).c_str()));
+        } else if (arg.rfind("--rate=", 0) == 0) {
+            options.rate = std::atof(arg.substr(7).c_str());
+        } else if (arg == "--sequential") {
+            options.balanced = false;
+        } else if (arg.rfind("--seed=", 0) == 0) {
+            options.seed = std::strtoull(arg.substr(7).c_str(), nullptr, 10);
+        } else if (arg.rfind("--journal=", 0) == 0) {
+            options.journal_path = arg.substr(10);
+        } else if (arg.rfind("--writes=", 0) == 0) {
+            options.writes = std::strtoull(arg.substr(9).c_str(), nullptr, 10);
+        } else {
+            log(Status::Error, "unknown argument " + arg);
+            return false;
+        }
+    }
+    int targets = !options.filepath.empty() + !options.socket_path.empty() + (options.port > 0);
+    if (targets != 1) {
+        log(Status::Error, "choose exactly one of --file, --socket or --port");
+        return false;
+    }
+    if (options.journal_path.empty() == false && options.filepath.empty()) {
+        log(Status::Error, "--journal only works with --file");
+        return false;
+    }
+    return true;
+}
+
+// Load throughput of the whole dictionary and of the CSV tokenizer alone, on the same file
+static void report_load(const std::string &filepath, double load_seconds) {
+    std::ifstream fin(filepath, std::ios::binary);
+    fin.seekg(0, std::ios::end);
+    std::string buffer(static_cast<size_t>(fin.tellg()), '\0');
+    fin.seekg(0);
+    fin.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    double megabytes = buffer.size() / (1024.0 * 1024.0);
+
+    auto start = std::chrono::steady_clock::now();
+    Csv::Parser parser(buffer);
+    std::vector<std::string_view> fields;
+    size_t records = 0;
+    while (parser.next(fields)) {
+        records += 1;
+    }
+    double scan_seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "load: " << std::fixed << std::setprecision(1) << megabytes << " MB in "
+              << load_seconds * 1000.0 << " ms (" << megabytes / std::max(load_seconds, 1e-9)
+              << " MB/s), csv-scan: " << records << " records in " << scan_seconds * 1000.0
+              << " ms (" << megabytes / std::max(scan_seconds, 1e-9) << " MB/s)\n";
+}
+
+// Membership checks over the generated queries, split by outcome. Absent words are mostly
+// answered by the filter alone
+static void report_contains(const Dictionary &dict, const std::vector<Request> &requests) {
+    std::vector<std::string> found, absent;
+    for (const Request &request : requests) {
+        (dict.contains(request.query) ? found : absent).push_back(request.query);
+    }
+    // Timed per batch, a clock read per call would cost more than a filtered miss
+    auto time = [&](const std::vector<std::string> &queries) {
+        auto start = std::chrono::steady_clock::now();
+        for (const std::string &query : queries) {
+            dict.contains(query);
+        }
+        double seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return seconds * 1e9 / std::max<size_t>(queries.size(), 1);
+    };
+    double found_ns = time(found);
+    double absent_ns = time(absent);
+    const Filter::Xor8 &filter = dict.get_filter();
+    std::cout << "contains: " << found.size() << " found at " << std::fixed << std::setprecision(1)
+              << found_ns << " ns, " << absent.size() << " absent at " << absent_ns
+              << " ns, filter: " << filter.get_memory_usage() / 1024.0 << " KB, "
+              << std::setprecision(2) << filter.get_false_positive_rate() * 100.0
+              << "% false positives\n";
+}
+
+// Times definition fetches of the words found: the first, which usually decompresses a block,
+// and a repeat served from the block cache
+static void report_definitions(const Dictionary &dict, const std::vector<Request> &requests) {
+    std::vector<std::shared_ptr<Word>> found;
+    for (const Request &request : requests) {
+        std::vector<std::shared_ptr<Word>> results = dict.search(request.query);
+        if (results.size() == 1 && results[0]->has_definition()) found.push_back(results[0]);
+    }
+    double cold = 0.0, warm = 0.0;
+    for (const std::shared_ptr<Word> &word : found) {
+        auto start = std::chrono::steady_clock::now();
+        word->get_definition();
+        auto middle = std::chrono::steady_clock::now();
+        word->get_definition();
+        auto end = std::chrono::steady_clock::now();
+        cold += std::chrono::duration<double>(middle - start).count();
+        warm += std::chrono::duration<double>(end - middle).count();
+    }
+    double count = static_cast<double>(std::max<size_t>(found.size(), 1));
+    std::cout << "definitions: " << found.size() << " fetched at " << std::fixed
+              << std::setprecision(1) << cold * 1e6 / count << " us cold, " << warm * 1e6 / count
+              << " us cached, " << dict.get_memory_breakdown().definitions / (1024.0 * 1024.0)
+              << " MB resident\n";
+}
+
+// Times a journal replay on top of a freshly loaded dictionary
+static bool replay_journal(const Options &options, Dictionary &dict) {
+    auto start = std::chrono::steady_clock::now();
+    if (dict.open_journal(options.journal_path, options.filepath, 0) == false) {
+        return false;
+    }
+    double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    size_t count = dict.get_journal()->get_replay_count();
+    std::cout << "journal-replay: " << count << " records, " << dict.get_journal()->get_size()
+              << " bytes in " << std::fixed << std::setprecision(1) << seconds * 1000.0
+              << " ms (" << std::setprecision(0) << count / std::max(seconds, 1e-9)
+              << " records/s)\n";
+    return true;
+}
+
+// Every thread inserts, updates and removes its own random words, so the concurrent writers
+// contend on the log like real callers and the dictionary ends where it started
+static void write_journal(const Options &options, Dictionary &dict) {
+    const Journal::Log *journal = dict.get_journal();
+    size_t records = journal->get_record_count();
+    size_t syncs = journal->get_sync_count();
+
+    std::atomic<size_t> next = 0;
+    std::vector<std::vector<uint64_t>> latencies(options.threads);
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < options.threads; ++t) {
+        threads.emplace_back([&, t]() {
+            Workload workload(options.seed + t);
+            auto timed = [&](auto &&write) {
+                auto begin = std::chrono::steady_clock::now();
+                write();
+                auto end = std::chrono::steady_clock::now();
+                latencies[t].push_back(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count());
+            };
+            while (next.fetch_add(3) + 3 <= options.writes) {
+                std::string text = workload.make_miss();
+                auto word = std::make_shared<Word>(text);
+                word->add_pos(POS::Noun);
+                word->add_definition("written by the load generator");
+                timed([&]() { dict.insert(word); });
+                timed([&]() { dict.update(text, {{POS::Verb, "updated by the load generator"}}); });
+                timed([&]() { dict.remove(text); });
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<uint64_t> all;
+    for (const std::vector<uint64_t> &latency : latencies) {
+        all.insert(all.end(), latency.begin(), latency.end());
+    }
+    records = journal->get_record_count() - records;
+    syncs = journal->get_sync_count() - syncs;
+    std::cout << "journal-write: " << all.size() << " writes in " << std::fixed
+              << std::setprecision(2) << seconds << " s (" << std::setprecision(0)
+              << all.size() / std::max(seconds, 1e-9) << " writes/s), " << syncs << " syncs ("
+              << std::setprecision(1) << static_cast<double>(records) / std::max<size_t>(syncs, 1)
+              << " records per sync), p50 " << percentile(all, 50) / 1000.0 << " us, p99 "
+              << percentile(all, 99) / 1000.0 << " us\n";
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+    if (parse_options(argc, argv, options) == false) {
+        log(Status::Info,
+            "usage: dict_loadgen (--file=path | --socket=path | --port=number) [--words=path] "
+            "[--replay=path] [--mix=exact:40,miss:10,typo1:15,typo2:10,typo3:5,prefix:10,"
+            "pattern:10] [--requests=count] [--threads=count] [--rate=qps] [--seed=number] "
+            "[--sequential] [--journal=path] [--writes=count]");
+        return -1;
+    }
+
+    // Build the request list up front so generation cost stays out of the measurements
+    std::vector<Request> requests;
+    if (options.replay_path.empty() == false) {
+        if (load_log(options.replay_path, requests) == false) {
+            log(Status::Error, "cannot load log " + options.replay_path);
+            return -1;
+        }
+    } else {
+        Workload workload(options.seed);
+        if (workload.load_words(options.words_path) == false) {
+            log(Status::Error, "cannot load words " + options.words_path);
+            return -1;
+        }
+        requests = workload.generate(options.requests, options.mix);
+    }
+    if (requests.empty()) {
+        log(Status::Warning, "no requests to send");
+        return 0;
+    }
+
+    std::unique_ptr<Dictionary> dict;
+    if (options.filepath.empty() == false) {
+        dict = std::make_unique<Dictionary>();
+        auto load_start = std::chrono::steady_clock::now();
+        if (dict->load(options.filepath, options.balanced) == false) {
+            log(Status::Error, "cannot load file " + options.filepath);
+            return -1;
+        }
+        double seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - load_start).count();
+        report_load(options.filepath, seconds);
+        report_contains(*dict, requests);
+        report_definitions(*dict, requests);
+    }
+    if (options.journal_path.empty() == false) {
+        // Checkpoints stay off, the benchmark must not rewrite the loaded file
+        if (replay_journal(options, *dict) == false) {
+            log(Status::Error, "cannot open journal " + options.journal_path);
+            return -1;
+        }
+        write_journal(options, *dict);
+
+        // Replay everything that was just written on top of a fresh copy
+        Dictionary fresh;
+        fresh.load(options.filepath, options.balanced);
+        replay_journal(options, fresh);
+    }
+    log(Status::Info, "sending " + std::to_string(requests.size()) + " requests with " +
+                          std::to_string(options.threads) + " threads");
+
+    std::atomic<size_t> next = 0;
+    std::atomic<bool> failed = false;
+    std::vector<LatencyRecorder> recorders(options.threads);
+    std::vector<std::thread> threads;
+
+    // Open-loop pacing: request i is due at start + i / rate, and latency is measured from that
+    // due time so a stalled target cannot hide queueing delay
+    auto start = std::chrono::steady_clock::now();
+    auto interval = std::chrono::duration<double>(options.rate > 0 ? 1.0 / options.rate : 0.0);
+
+    for (int t = 0; t < options.threads; ++t) {
+        threads.emplace_back([&, t]() {
+            Client client;
+            if (dict == nullptr) {
+                bool connected = options.port > 0 ? client.connect_tcp(options.port)
+                                                  : client.connect_unix(options.socket_path);
+                if (connected == false) {
+                    failed = true;
+                    return;
+                }
+            }
+            std::vector<std::string> words;
+            size_t i;
+            while ((i = next.fetch_add(1)) < requests.size() && failed == false) {
+                auto due = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                       interval * static_cast<double>(i));
+                if (options.rate > 0) {
+                    std::this_thread::sleep_until(due);
+                } else {
+                    due = std::chrono::steady_clock::now();
+                }
+                if (dict != nullptr) {
+                    dict->search(requests[i].query);
+                } else if (client.query(requests[i].query, words) == false) {
+                    failed = true;
+                    return;
+                }
+                auto end = std::chrono::steady_clock::now();
+                auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(end - due);
+                recorders[t].add(requests[i].kind, latency.count());
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    if (failed) {
+        log(Status::Error, "lost connection to the server");
+        return -1;
+    }
+    LatencyRecorder total;
+    for (const LatencyRecorder &recorder : recorders) {
+        total.merge(recorder);
+    }
+    total.report(std::chrono::duration<double>(end - start).count());
+
+    if (dict != nullptr) {
+        std::cout << "bktree-height: " << dict->get_bktree_height()
+                  << ", average nodes visited per fuzzy query: " << std::fixed
+                  << std::setprecision(1) << dict->get_bktree_average_visits() << '\n';
+    }
+    return 0;
+}
@@ -1,27 +1,80 @@
+#include <cstdlib>
 #include <string>
+#include <vector>
 
 #include "app.hpp"
 #include "utility.hpp"
 
 int main(int argc, char *argv[]) {
-    std::string filepath = "../data/dictionary.csv";
+    std::vector<std::string> filepaths;  // Repeated --file flags are queried together
     bool silent = false;
+    int cache_capacity = 0;
+    bool serve = false;
+    std::string socket_path = "/tmp/dictionary.sock";
+    int port = 0;
+    int workers = 0;
+    bool audit = false;
+    std::string journal_path;
+    bool watch = false;
+    std::string model_path;
 
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
 
         if (arg.rfind("--file=", 0) == 0) {
-            filepath = arg.substr(7);  // after "--file="
+            filepaths.push_back(arg.substr(7));  // after "--file="
         } else if (arg == "--silent") {
             silent = true;
+        } else if (arg.rfind("--cache=", 0) == 0) {
+            cache_capacity = std::atoi(arg.substr(8).c_str());  // after "--cache="
+        } else if (arg == "--serve") {
+            serve = true;
+        } else if (arg.rfind("--socket=", 0) == 0) {
+            socket_path = arg.substr(9);  // after "--socket="
+        } else if (arg.rfind("--port=", 0) == 0) {
+            port = std::atoi(arg.substr(7).c_str());  // after "--port="
+        } else if (arg.rfind("--workers=", 0) == 0) {
+            workers = std::atoi(arg.substr(10).c_str());  // after "--workers="
+        } else if (arg == "--audit") {
+            audit = true;
+        } else if (arg.rfind("--journal=", 0) == 0) {
+            journal_path = arg.substr(10);  // after "--journal="
+        } else if (arg == "--watch") {
+            watch = true;
+        } else if (arg.rfind("--model=", 0) == 0) {
+            model_path = arg.substr(8);  // after "--model="
         } else {
             log(Status::Error, "unknown argument " + arg);
-            log(Status::Info, "usage: dictionary.exe [--file=path] [--silent]");
+            log(Status::Info,
+                "usage: dictionary.exe [--file=path] [--silent] [--cache=entries] [--serve] "
+                "[--socket=path] [--port=number] [--workers=count] [--audit] [--journal=path] "
+                "[--watch] [--model=path]");
             return -1;
         }
     }
 
-    App app(filepath, silent);
+    if (filepaths.empty()) {
+        filepaths.push_back("../data/dictionary.csv");
+    }
+    App app(silent);
+    app.load(filepaths);
+    if (cache_capacity > 0) {
+        app.set_cache_capacity(cache_capacity);
+    }
+    app.set_audit(audit);
+    if (model_path.empty() == false && app.set_language_model(model_path) == false) {
+        return -1;
+    }
+    if (journal_path.empty() == false &&
+        app.open_journal(journal_path, filepaths.front()) == false) {
+        return -1;
+    }
+    if (watch && app.watch() == false) {
+        return -1;
+    }
+    if (serve) {
+        return app.serve(socket_path, port, workers) ? 0 : -1;
+    }
     app.run();
 
     return 0;
@@ -0,0 +1,61 @@
+#include "memory.hpp"
+
+#include <cstddef>
+#include <cstdlib>
+#include <string>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+namespace Memory {
+
+// Control block of make_shared: a vtable pointer and the two reference counts
+static constexpr size_t CONTROL_BLOCK = sizeof(void *) + 2 * sizeof(int);
+
+size_t block_size(const void *pointer, size_t size) {
+#if defined(__GLIBC__)
+    // Usable bytes plus the size field in front of them
+    (void)size;
+    return malloc_usable_size(const_cast<void *>(pointer)) + sizeof(size_t);
+#else
+    (void)pointer;
+    return estimate(size);
+#endif
+}
+
+size_t estimate(size_t size) {
+    // The request plus a size field, rounded up to 16 bytes with a minimum of 32. This is
+    // ptmalloc's layout and close enough for most other allocators
+    size_t chunk = (size + sizeof(size_t) + 15) & ~size_t{15};
+    return chunk < 32 ? 32 : chunk;
+}
+
+size_t shared_block(size_t size) {
+    return estimate(CONTROL_BLOCK + size);
+}
+
+size_t of(const std::string &text) {
+    const char *data = text.data();
+    const char *object = reinterpret_cast<const char *>(&text);
+    if (data >= object && data < object + sizeof(std::string)) {
+        return 0;  // Small string, stored inside the object
+    }
+    return block_size(data, text.capacity() + 1);
+}
+
+size_t Usage::total() const {
+    return trie + bktree + words + definitions + lookup + cache;
+}
+
+Usage &Usage::operator+=(const Usage &other) {
+    trie += other.trie;
+    bktree += other.bktree;
+    words += other.words;
+    definitions += other.definitions;
+    lookup += other.lookup;
+    cache += other.cache;
+    return *this;
+}
+
+};  // namespace Memory
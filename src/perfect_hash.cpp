@@ -0,0 +1,101 @@
+#include "perfect_hash.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "memory.hpp"
+
+namespace PerfectHash {
+
+// Average keys per bucket. Larger buckets take less memory but longer pilot searches
+static constexpr size_t BUCKET_SIZE = 4;
+
+static uint64_t finalize(uint64_t key) {
+    // MurmurHash3 finalizer, a bijection
+    key = (key ^ (key >> 33)) * 0xFF51AFD7ED558CCD;
+    key = (key ^ (key >> 33)) * 0xC4CEB9FE1A85EC53;
+    return key ^ (key >> 33);
+}
+
+void Function::build(const std::vector<uint64_t> &keys) {
+    key_count = keys.size();
+    seed = 0x9E3779B97F4A7C15;
+    size_t bucket_count = key_count / BUCKET_SIZE + 1;
+    pilots.assign(bucket_count, 0);
+    if (key_count == 0) {
+        return;
+    }
+
+    // (bucket, mixed key), grouped by bucket
+    std::vector<std::pair<size_t, uint64_t>> entries;
+    entries.reserve(key_count);
+    for (uint64_t key : keys) {
+        uint64_t mixed = mix(key);
+        entries.emplace_back(bucket(mixed), mixed);
+    }
+    std::sort(entries.begin(), entries.end());
+
+    // (start, end) of every bucket in `entries`, largest first
+    std::vector<std::pair<size_t, size_t>> ranges;
+    for (size_t start = 0; start < entries.size();) {
+        size_t end = start;
+        while (end < entries.size() && entries[end].first == entries[start].first) ++end;
+        ranges.emplace_back(start, end);
+        start = end;
+    }
+    std::stable_sort(ranges.begin(), ranges.end(), [](const auto &a, const auto &b) {
+        return a.second - a.first > b.second - b.first;
+    });
+
+    std::vector<bool> taken(key_count, false);
+    std::vector<size_t> positions;
+    for (auto [start, end] : ranges) {
+        // Distinct keys always differ after mixing, so some pilot separates them
+        for (uint32_t pilot = 0;; ++pilot) {
+            positions.clear();
+            bool fits = true;
+            for (size_t i = start; i < end && fits; ++i) {
+                size_t p = position(entries[i].second, pilot);
+                fits = (taken[p] == false &&
+                        std::find(positions.begin(), positions.end(), p) == positions.end());
+                positions.push_back(p);
+            }
+            if (fits) {
+                for (size_t p : positions) taken[p] = true;
+                pilots[entries[start].first] = pilot;
+                break;
+            }
+        }
+    }
+}
+
+size_t Function::lookup(uint64_t key) const {
+    uint64_t mixed = mix(key);
+    return position(mixed, pilots[bucket(mixed)]);
+}
+
+size_t Function::get_key_count() const {
+    return key_count;
+}
+
+size_t Function::get_memory_usage() const {
+    return Memory::of(pilots);
+}
+
+uint64_t Function::mix(uint64_t key) const {
+    return finalize(key + seed);
+}
+
+size_t Function::bucket(uint64_t mixed) const {
+    return (mixed >> 32) % pilots.size();
+}
+
+size_t Function::position(uint64_t mixed, uint32_t pilot) const {
+    // Mixed again after the XOR, or keys equal modulo a power of two table size would stay
+    // together for every pilot
+    return finalize(mixed ^ finalize(pilot + seed)) % key_count;
+}
+
+};  // namespace PerfectHash
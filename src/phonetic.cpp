@@ -0,0 +1,220 @@
+#include "phonetic.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "memory.hpp"
+
+namespace Phonetic {
+
+// Sound codes, 0 terminates a key
+enum Sound : Key { Vowel = 1, B, F, H, J, K, L, M, N, P, R, S, T, W, X, Y, Theta };
+
+static bool is_vowel(char c) {
+    return c == 'a' || c == 'e' || c == 'i' || c == 'o' || c == 'u';
+}
+
+// Lowercase letter at `i`, or 0 outside the word and for anything that is not a letter
+static char letter_at(std::string_view word, size_t i) {
+    if (i >= word.size()) return 0;
+    char c = word[i];
+    if (c >= 'A' && c <= 'Z') return c + ('a' - 'A');
+    if (c >= 'a' && c <= 'z') return c;
+    return 0;
+}
+
+// Simplified Metaphone, reads the word in place and writes sounds straight into the key
+Key encode(std::string_view word) {
+    Key key = 0;
+    int length = 0;
+    auto emit = [&](Sound sound) {
+        if (length < MAX_SOUNDS) {
+            key |= static_cast<Key>(sound) << (5 * length++);
+        }
+    };
+    auto at = [&](size_t i) { return letter_at(word, i); };
+
+    size_t i = 0;
+    // Silent first letters: KNight, GNome, PNeumonia, WRite, AEsthetic
+    char first = at(0), second = at(1);
+    if ((second == 'n' && (first == 'k' || first == 'g' || first == 'p')) ||
+        (first == 'w' && second == 'r') || (first == 'a' && second == 'e')) {
+        i = 1;
+    } else if (first == 'x') {
+        emit(S);  // Xylophone
+        i = 1;
+    } else if (first == 'w' && second == 'h') {
+        emit(W);  // WHite
+        i = 2;
+    }
+
+    for (; i < word.size(); ++i) {
+        char c = at(i);
+        if (c == 0) continue;
+        char prev = i > 0 ? at(i - 1) : 0, next = at(i + 1), after = at(i + 2);
+
+        // Doubled letters sound once, except CC as in aCCept
+        if (c == prev && c != 'c') continue;
+
+        switch (c) {
+            case 'a':
+            case 'e':
+            case 'i':
+            case 'o':
+            case 'u':
+                if (i == 0) emit(Vowel);  // Only a leading vowel is kept
+                break;
+            case 'b':
+                if (!(prev == 'm' && next == 0)) emit(B);  // Silent in dumB
+                break;
+            case 'c':
+                if (next == 'i' && after == 'a') {
+                    emit(X);  // soCIAl
+                } else if (next == 'h') {
+                    emit(prev == 's' ? K : X);  // SCHool, CHurch
+                    ++i;
+                } else if (next == 'i' || next == 'e' || next == 'y') {
+                    if (prev != 's') emit(S);  // CIty, but silent in SCIence
+                } else {
+                    emit(K);
+                }
+                break;
+            case 'd':
+                if (next == 'g' && (after == 'e' || after == 'y' || after == 'i')) {
+                    emit(J);  // eDGE
+                    ++i;
+                } else {
+                    emit(T);
+                }
+                break;
+            case 'g':
+                if (next == 'h' && after != 0 && is_vowel(after) == false) {
+                    break;  // niGHt
+                }
+                if (next == 'n' && (after == 0 || (after == 'e' && at(i + 3) == 'd'))) {
+                    break;  // siGN, siGNed
+                }
+                if (next == 'i' || next == 'e' || next == 'y') {
+                    emit(J);
+                } else {
+                    emit(K);
+                }
+                break;
+            case 'h':
+                // Silent after these consonants and between a vowel and a consonant
+                if (prev == 'c' || prev == 's' || prev == 'p' || prev == 't' || prev == 'g') break;
+                if (is_vowel(prev) && is_vowel(next) == false) break;
+                emit(H);
+                break;
+            case 'k':
+                if (prev != 'c') emit(K);
+                break;
+            case 'p':
+                if (next == 'h') {
+                    emit(F);  // PHone
+                    ++i;
+                } else {
+                    emit(P);
+                }
+                break;
+            case 'q':
+                emit(K);
+                break;
+            case 's':
+                if (next == 'h') {
+                    emit(X);
+                    ++i;
+                } else if (next == 'i' && (after == 'o' || after == 'a')) {
+                    emit(X);  // viSIOn
+                } else {
+                    emit(S);
+                }
+                break;
+            case 't':
+                if (next == 'i' && (after == 'o' || after == 'a')) {
+                    emit(X);  // naTIOn
+                } else if (next == 'h') {
+                    emit(Theta);
+                    ++i;
+                } else if (!(next == 'c' && after == 'h')) {
+                    emit(T);  // Silent in waTCH
+                }
+                break;
+            case 'v':
+                emit(F);
+                break;
+            case 'w':
+            case 'y':
+                if (is_vowel(next)) emit(c == 'w' ? W : Y);
+                break;
+            case 'x':
+                emit(K);
+                emit(S);
+                break;
+            case 'z':
+                emit(S);
+                break;
+            case 'f':
+                emit(F);
+                break;
+            case 'j':
+                emit(J);
+                break;
+            case 'l':
+                emit(L);
+                break;
+            case 'm':
+                emit(M);
+                break;
+            case 'n':
+                emit(N);
+                break;
+            case 'r':
+                emit(R);
+                break;
+        }
+    }
+    return key;
+}
+
+void Index::insert(std::string_view word, uint32_t id) {
+    Key key = encode(word);
+    if (key == 0) return;
+    std::vector<uint32_t> &ids = buckets[key];
+    id_bytes -= Memory::of(ids);
+    ids.push_back(id);
+    id_bytes += Memory::of(ids);
+}
+
+void Index::remove(std::string_view word, uint32_t id) {
+    Key key = encode(word);
+    auto it = key == 0 ? buckets.end() : buckets.find(key);
+    if (it == buckets.end()) return;
+    std::vector<uint32_t> &ids = it->second;
+    auto position = std::find(ids.begin(), ids.end(), id);
+    if (position == ids.end()) return;
+    ids.erase(position);
+    if (ids.empty()) {
+        id_bytes -= Memory::of(ids);
+        buckets.erase(it);
+    }
+}
+
+const std::vector<uint32_t> &Index::lookup(std::string_view word) const {
+    static const std::vector<uint32_t> empty;
+    auto it = buckets.find(encode(word));
+    return it == buckets.end() ? empty : it->second;
+}
+
+size_t Index::get_key_count() const {
+    return buckets.size();
+}
+
+size_t Index::get_memory_usage() const {
+    return Memory::of_hashed(buckets, false) + id_bytes;
+}
+
+};  // namespace Phonetic
@@ -0,0 +1,113 @@
+#include "query_cache.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "memory.hpp"
+
+QueryCache::QueryCache(size_t capacity, size_t shard_count) {
+    shard_count = std::max<size_t>(1, std::min(shard_count, capacity));
+    for (size_t i = 0; i < shard_count; ++i) {
+        auto shard = std::make_unique<Shard>();
+        // Spread the capacity so the shards add up to the requested total
+        shard->capacity = capacity / shard_count + (i < capacity % shard_count ? 1 : 0);
+        shards.push_back(std::move(shard));
+    }
+}
+
+bool QueryCache::get(const std::string &key, Results &results) {
+    Shard &shard = shard_for(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+        misses.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    // Move to the front as most recently used
+    shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+    results = it->second->second;
+    hits.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void QueryCache::put(const std::string &key, const Results &results) {
+    Shard &shard = shard_for(key);
+    if (shard.capacity == 0) return;
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+        it->second->second = results;
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        return;
+    }
+    // Evict the least recently used entry
+    if (shard.entries.size() >= shard.capacity) {
+        shard.index.erase(shard.entries.back().first);
+        shard.entries.pop_back();
+    }
+    shard.entries.emplace_front(key, results);
+    shard.index[key] = shard.entries.begin();
+}
+
+void QueryCache::clear() {
+    for (const auto &shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->entries.clear();
+        shard->index.clear();
+    }
+}
+
+size_t QueryCache::get_capacity() const {
+    size_t capacity = 0;
+    for (const auto &shard : shards) {
+        capacity += shard->capacity;
+    }
+    return capacity;
+}
+
+size_t QueryCache::get_size() const {
+    size_t size = 0;
+    for (const auto &shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        size += shard->entries.size();
+    }
+    return size;
+}
+
+size_t QueryCache::get_memory_usage() const {
+    size_t bytes = Memory::of(shards);
+    for (const auto &shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        // List nodes hold two links and the entry, index nodes a copy of the key
+        bytes += Memory::block_size(shard.get(), sizeof(Shard)) +
+                 Memory::of_hashed(shard->index, true);
+        for (const auto &[key, results] : shard->entries) {
+            bytes += Memory::estimate(2 * sizeof(void *) + sizeof(Entry)) + 2 * Memory::of(key) +
+                     Memory::of(results);
+        }
+    }
+    return bytes;
+}
+
+size_t QueryCache::get_hits() const {
+    return hits.load(std::memory_order_relaxed);
+}
+
+size_t QueryCache::get_misses() const {
+    return misses.load(std::memory_order_relaxed);
+}
+
+double QueryCache::get_hit_ratio() const {
+    size_t total = get_hits() + get_misses();
+    return (total == 0) ? 0.0 : static_cast<double>(get_hits()) / total;
+}
+
+QueryCache::Shard &QueryCache::shard_for(const std::string &key) const {
+    return *shards[std::hash<std::string>{}(key) % shards.size()];
+}
@@ -0,0 +1,156 @@
+#include "reloader.hpp"
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "dictionary.hpp"
+#include "utility.hpp"
+
+// Writers often save in several steps, wait for the file to stay quiet this long before loading
+static constexpr int QUIET_PERIOD_MS = 200;
+
+Reloader::Reloader(std::function<bool(Dictionary &)> prepare) : prepare(std::move(prepare)) {}
+
+Reloader::~Reloader() {
+    stop_watching();
+}
+
+bool Reloader::load(const std::string &filepath) {
+    std::lock_guard<std::mutex> lock(reload_mutex);
+    auto fresh = std::make_shared<Dictionary>();
+    if (fresh->load(filepath) == false) {
+        return false;
+    }
+    if (prepare != nullptr && prepare(*fresh) == false) {
+        return false;
+    }
+    // The journal moves over and writes pause until the swap, so none fall in between
+    std::shared_ptr<Dictionary> old = current.load();
+    if (old != nullptr) {
+        old->hand_over(fresh, [&]() { current.store(fresh); });
+    } else {
+        current.store(fresh);
+    }
+    this->filepath = filepath;
+    if (old != nullptr) {
+        reload_count.fetch_add(1, std::memory_order_relaxed);
+    }
+    // Unless a query still holds it, the old dictionary is freed here rather than on a reader
+    return true;
+}
+
+bool Reloader::reload() {
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(reload_mutex);
+        path = filepath;
+    }
+    return path.empty() == false && load(path);
+}
+
+bool Reloader::watch() {
+    if (watcher.joinable()) {
+        return true;
+    }
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(reload_mutex);
+        path = filepath;
+    }
+    if (path.empty()) {
+        log(Status::Warning, "load a file before watching it");
+        return false;
+    }
+    // Watch the directory, a file replaced through a rename is a new inode
+    size_t slash = path.find_last_of('/');
+    std::string directory = (slash == std::string::npos) ? "." : path.substr(0, slash + 1);
+    std::string name = (slash == std::string::npos) ? path : path.substr(slash + 1);
+
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (inotify_fd == -1 || wake_fd == -1 ||
+        inotify_add_watch(inotify_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) == -1) {
+        log(Status::Error, "cannot watch " + path + ": " + std::strerror(errno));
+        stop_watching();
+        return false;
+    }
+    watcher = std::thread(&Reloader::watch_loop, this, std::move(path), std::move(name));
+    return true;
+}
+
+void Reloader::stop_watching() {
+    if (watcher.joinable()) {
+        uint64_t value = 1;
+        ssize_t written = write(wake_fd, &value, sizeof(value));
+        (void)written;
+        watcher.join();
+    }
+    if (inotify_fd != -1) close(inotify_fd);
+    if (wake_fd != -1) close(wake_fd);
+    inotify_fd = wake_fd = -1;
+}
+
+void Reloader::update(const std::function<void(Dictionary &)> &change) {
+    std::lock_guard<std::mutex> lock(reload_mutex);
+    std::shared_ptr<Dictionary> dict = current.load();
+    if (dict != nullptr) {
+        change(*dict);
+    }
+}
+
+std::shared_ptr<Dictionary> Reloader::get() const {
+    return current.load();
+}
+
+size_t Reloader::get_reload_count() const {
+    return reload_count.load(std::memory_order_relaxed);
+}
+
+void Reloader::watch_loop(std::string path, std::string name) {
+    pollfd fds[2] = {{inotify_fd, POLLIN, 0}, {wake_fd, POLLIN, 0}};
+    bool pending = false;
+    while (true) {
+        int ready = poll(fds, 2, pending ? QUIET_PERIOD_MS : -1);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            log(Status::Error, std::string("poll failed: ") + std::strerror(errno));
+            return;
+        }
+        if (fds[1].revents != 0) {
+            return;  // Stopping
+        }
+        if (ready == 0) {
+            pending = false;
+            std::shared_ptr<Dictionary> dict = get();
+            if (dict != nullptr && dict->is_checkpoint(path)) {
+                continue;  // Renamed in by the dictionary's own checkpoint, nothing new
+            }
+            if (reload() == false) {
+                log(Status::Warning, "cannot reload file, keeping the current dictionary");
+            }
+            continue;
+        }
+        alignas(inotify_event) char buffer[4096];
+        ssize_t length;
+        while ((length = read(inotify_fd, buffer, sizeof(buffer))) > 0) {
+            for (char *next = buffer; next < buffer + length;) {
+                const inotify_event *event = reinterpret_cast<const inotify_event *>(next);
+                if (event->len > 0 && name == event->name) {
+                    pending = true;
+                }
+                next += sizeof(inotify_event) + event->len;
+            }
+        }
+    }
+}
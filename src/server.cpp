@@ -0,0 +1,352 @@
+#include "server.hpp"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "dictionary.hpp"
+#include "thread_pool.hpp"
+#include "utility.hpp"
+
+// Requests longer than this without a newline are treated as garbage and dropped
+static constexpr size_t MAX_LINE_LENGTH = 4096;
+static constexpr int MAX_EVENTS = 64;
+
+static bool set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1;
+}
+
+std::string format_response(const std::vector<std::shared_ptr<Word>> &results) {
+    std::string response = std::to_string(results.size());
+    for (const std::shared_ptr<Word> &word : results) {
+        response += ' ';
+        response += word->get_text();
+    }
+    response += '\n';
+    return response;
+}
+
+Server::Server(const Dictionary &dict, size_t worker_count) : dict(&dict) {
+    start(worker_count);
+}
+
+Server::Server(const Reloader &reloader, size_t worker_count) : reloader(&reloader) {
+    start(worker_count);
+}
+
+void Server::start(size_t worker_count) {
+    if (worker_count == 0) {
+        worker_count = std::thread::hardware_concurrency();
+    }
+    pool = std::make_unique<ThreadPool>(worker_count);
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = 0;  // Id 0 is reserved for the wake-up eventfd
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &event);
+}
+
+std::shared_ptr<const Dictionary> Server::snapshot() const {
+    if (reloader != nullptr) {
+        return reloader->get();
+    }
+    return std::shared_ptr<const Dictionary>(std::shared_ptr<const Dictionary>(), dict);
+}
+
+Server::~Server() {
+    // Finish in-flight queries before tearing down the descriptors they report to
+    pool.reset();
+    for (const auto &[_, connection] : connections) {
+        close(connection.fd);
+    }
+    if (listen_fd != -1) close(listen_fd);
+    if (wake_fd != -1) close(wake_fd);
+    if (epoll_fd != -1) close(epoll_fd);
+    if (socket_path.empty() == false) unlink(socket_path.c_str());
+}
+
+bool Server::listen_unix(const std::string &path) {
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path)) {
+        log(Status::Error, "socket path too long " + path);
+        return false;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) return false;
+
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    unlink(path.c_str());  // Remove a stale socket left by a previous run
+
+    if (bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == -1) {
+        log(Status::Error, "cannot bind " + path + ": " + std::strerror(errno));
+        close(fd);
+        return false;
+    }
+    socket_path = path;
+    return setup(fd);
+}
+
+bool Server::listen_tcp(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) return false;
+
+    int enable = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    // Only serve local clients
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == -1) {
+        log(Status::Error, "cannot bind port " + std::to_string(port) + ": " + std::strerror(errno));
+        close(fd);
+        return false;
+    }
+    return setup(fd);
+}
+
+void Server::run() {
+    if (listen_fd == -1) {
+        log(Status::Warning, "listen on a socket before running the server");
+        return;
+    }
+    running = true;
+    epoll_event events[MAX_EVENTS];
+
+    while (running) {
+        int count = epoll_wait(epoll_fd, events, MAX_EVENTS, -1);
+        if (count == -1) {
+            if (errno == EINTR) continue;
+            log(Status::Error, std::string("epoll_wait failed: ") + std::strerror(errno));
+            break;
+        }
+        for (int i = 0; i < count; ++i) {
+            uint64_t id = events[i].data.u64;
+            uint32_t flags = events[i].events;
+
+            if (id == 0) {
+                uint64_t value;
+                while (read(wake_fd, &value, sizeof(value)) > 0) {
+                }
+                collect_completed();
+            } else if (id == UINT64_MAX) {
+                accept_connections();
+            } else {
+                if (flags & (EPOLLIN | EPOLLHUP | EPOLLERR)) read_connection(id);
+                if (flags & EPOLLOUT) write_connection(id);
+            }
+        }
+    }
+}
+
+void Server::stop() {
+    running = false;
+    uint64_t value = 1;
+    // Only async-signal-safe calls here, stop() may run from a signal handler
+    ssize_t written = write(wake_fd, &value, sizeof(value));
+    (void)written;
+}
+
+size_t Server::get_worker_count() const {
+    return pool->get_worker_count();
+}
+
+bool Server::setup(int fd) {
+    if (set_nonblocking(fd) == false || listen(fd, SOMAXCONN) == -1) {
+        close(fd);
+        return false;
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = UINT64_MAX;  // Listening socket
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1) {
+        close(fd);
+        return false;
+    }
+    listen_fd = fd;
+    return true;
+}
+
+void Server::accept_connections() {
+    while (true) {
+        int fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd == -1) return;  // EAGAIN once the backlog is drained
+
+        int enable = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));  // No-op on Unix
+
+        uint64_t id = next_id++;
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = id;
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1) {
+            close(fd);
+            continue;
+        }
+        connections[id].fd = fd;
+        ids[fd] = id;
+    }
+}
+
+void Server::read_connection(uint64_t id) {
+    auto it = connections.find(id);
+    if (it == connections.end()) return;
+    Connection &connection = it->second;
+
+    // Input is no longer watched after EOF, so this is a hang-up or error: the peer is gone
+    if (connection.closing) {
+        close_connection(id);
+        return;
+    }
+    char buffer[4096];
+    while (true) {
+        ssize_t size = read(connection.fd, buffer, sizeof(buffer));
+        if (size > 0) {
+            connection.input.append(buffer, size);
+            continue;
+        }
+        if (size == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (size == -1 && errno == EINTR) continue;
+
+        // EOF or error: stop reading, answer what was already received
+        connection.closing = true;
+        epoll_event event{};
+        event.events = connection.writing ? static_cast<uint32_t>(EPOLLOUT) : 0;
+        event.data.u64 = id;
+        epoll_ctl(epoll_fd, EPOLL_CTL_MOD, connection.fd, &event);
+        break;
+    }
+    if (connection.input.size() > MAX_LINE_LENGTH &&
+        connection.input.find('\n') == std::string::npos) {
+        close_connection(id);
+        return;
+    }
+    dispatch(id);
+}
+
+void Server::write_connection(uint64_t id) {
+    auto it = connections.find(id);
+    if (it == connections.end()) return;
+    Connection &connection = it->second;
+
+    while (connection.output.empty() == false) {
+        ssize_t size = send(connection.fd, connection.output.data(), connection.output.size(),
+                            MSG_NOSIGNAL);
+        if (size > 0) {
+            connection.output.erase(0, size);
+            continue;
+        }
+        if (size == -1 && errno == EINTR) continue;
+        if (size == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            watch_output(connection, true);
+            return;
+        }
+        close_connection(id);  // Peer is gone
+        return;
+    }
+    watch_output(connection, false);
+
+    bool pending = connection.busy || connection.input.find('\n') != std::string::npos;
+    if (connection.closing && pending == false) {
+        close_connection(id);
+    }
+}
+
+void Server::dispatch(uint64_t id) {
+    auto it = connections.find(id);
+    if (it == connections.end()) return;
+    Connection &connection = it->second;
+
+    // One query per connection at a time keeps responses in request order
+    while (connection.busy == false) {
+        size_t end = connection.input.find('\n');
+        if (end == std::string::npos) break;
+
+        std::string query = connection.input.substr(0, end);
+        connection.input.erase(0, end + 1);
+        if (query.empty() == false && query.back() == '\r') {
+            query.pop_back();
+        }
+        // A reload swapping the dictionary meanwhile leaves this snapshot intact
+        std::shared_ptr<const Dictionary> current = snapshot();
+
+        // Fuzzy and pattern queries go to the pool, cheap ones are answered inline
+        Mode mode = current->recognize(query);
+        if (mode == Mode::Search || mode == Mode::Match) {
+            connection.busy = true;
+            pool->submit([this, id, current = std::move(current), query = std::move(query)]() {
+                std::string response = format_response(current->search(query));
+                {
+                    std::lock_guard<std::mutex> lock(completed_mutex);
+                    completed.emplace_back(id, std::move(response));
+                }
+                uint64_t value = 1;
+                ssize_t written = write(wake_fd, &value, sizeof(value));
+                (void)written;
+            });
+        } else {
+            connection.output += format_response(current->search(query));
+        }
+    }
+    write_connection(id);
+}
+
+void Server::collect_completed() {
+    std::vector<std::pair<uint64_t, std::string>> batch;
+    {
+        std::lock_guard<std::mutex> lock(completed_mutex);
+        batch.swap(completed);
+    }
+    for (auto &[id, response] : batch) {
+        auto it = connections.find(id);
+        if (it == connections.end()) continue;  // Connection closed meanwhile
+
+        it->second.output += response;
+        it->second.busy = false;
+        dispatch(id);
+    }
+}
+
+void Server::close_connection(uint64_t id) {
+    auto it = connections.find(id);
+    if (it == connections.end()) return;
+
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, it->second.fd, nullptr);
+    close(it->second.fd);
+    ids.erase(it->second.fd);
+    connections.erase(it);
+}
+
+void Server::watch_output(Connection &connection, bool enable) {
+    if (connection.writing == enable) return;
+    connection.writing = enable;
+
+    epoll_event event{};
+    uint32_t events = 0;
+    if (connection.closing == false) events |= EPOLLIN;
+    if (enable) events |= EPOLLOUT;
+    event.events = events;
+    event.data.u64 = ids[connection.fd];
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, connection.fd, &event);
+}
@@ -0,0 +1,51 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <utility>
+
+ThreadPool::ThreadPool(size_t worker_count) {
+    worker_count = std::max<size_t>(1, worker_count);
+    for (size_t i = 0; i < worker_count; ++i) {
+        workers.emplace_back(&ThreadPool::work, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    available.notify_all();
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push(std::move(task));
+    }
+    available.notify_one();
+}
+
+size_t ThreadPool::get_worker_count() const {
+    return workers.size();
+}
+
+void ThreadPool::work() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            available.wait(lock, [this]() { return stopping || tasks.empty() == false; });
+            // Drain queued tasks before shutting down
+            if (tasks.empty()) return;
+            task = std::move(tasks.front());
+            tasks.pop();
+        }
+        task();
+    }
+}
@@ -1,10 +1,21 @@
 #include "trie_node.hpp"
 
+#include <algorithm>
+#include <bit>
+#include <cstdint>
 #include <memory>
-#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "memory.hpp"
 
 namespace Trie {
 
+static bool compare_key(const std::pair<char, std::unique_ptr<Node>> &child, char c) {
+    // As unsigned bytes, the order std::string compares in and for UTF-8 code point order
+    return static_cast<unsigned char>(child.first) < static_cast<unsigned char>(c);
+}
+
 bool Node::is_word() const {
     return word.get() != nullptr;
 }
@@ -18,19 +29,150 @@ void Node::set_word(std::shared_ptr<Word> word) {
 }
 
 Node *Node::get_child(char c) const {
-    auto it = children.find(c);
-    return (it != children.end()) ? it->second.get() : nullptr;
+    auto it = std::lower_bound(children.begin(), children.end(), c, compare_key);
+    return (it != children.end() && it->first == c) ? it->second.get() : nullptr;
 }
 
 Node *Node::set_child(char c) {
-    if (children.count(c) == 0) {
-        children[c] = std::make_unique<Node>();
+    auto it = std::lower_bound(children.begin(), children.end(), c, compare_key);
+    if (it == children.end() || it->first != c) {
+        it = children.emplace(it, c, std::make_unique<Node>());
     }
-    return children[c].get();
+    return it->second.get();
 }
 
-const std::unordered_map<char, std::unique_ptr<Node>> &Node::get_children() const {
-    return children;
+bool Node::has_child(char c) const {
+    return get_child(c) != nullptr;
 }
 
+void Node::remove_child(char c) {
+    auto it = std::lower_bound(children.begin(), children.end(), c, compare_key);
+    if (it != children.end() && it->first == c) {
+        children.erase(it);
+    }
+}
+
+size_t Node::child_count() const {
+    return children.size();
+}
+
+char Node::child_key(size_t index) const {
+    return children[index].first;
+}
+
+Node *Node::child_at(size_t index) const {
+    return children[index].second.get();
+}
+
+size_t Node::get_memory_usage() const {
+    size_t bytes = Memory::of(children);
+    for (const auto &[c, child] : children) {
+        bytes += Memory::block_size(child.get(), sizeof(Node));
+    }
+    return bytes;
+}
+
+template <typename Alpha>
+bool AlphaNode<Alpha>::is_word() const {
+    return word.get() != nullptr;
+}
+
+template <typename Alpha>
+std::shared_ptr<Word> AlphaNode<Alpha>::get_word() const {
+    return word;
+}
+
+template <typename Alpha>
+void AlphaNode<Alpha>::set_word(std::shared_ptr<Word> word) {
+    this->word = std::move(word);
+}
+
+template <typename Alpha>
+AlphaNode<Alpha> *AlphaNode<Alpha>::get_child(char c) const {
+    unsigned index = Alpha::index(c);
+    if (index >= Alpha::size) return nullptr;
+    uint32_t bit = uint32_t{1} << index;
+    if ((bitmap & bit) == 0) return nullptr;
+    return &children[std::popcount(bitmap & (bit - 1))];
+}
+
+template <typename Alpha>
+AlphaNode<Alpha> *AlphaNode<Alpha>::set_child(char c) {
+    unsigned index = Alpha::index(c);
+    if (index >= Alpha::size) return nullptr;
+    uint32_t bit = uint32_t{1} << index;
+    size_t slot = std::popcount(bitmap & (bit - 1));
+    if (bitmap & bit) return &children[slot];
+
+    // Grow the packed array by one, nodes rarely get more than a handful of children. Moving a
+    // node only moves its pointers, the subtrees below stay where they are
+    size_t count = std::popcount(bitmap);
+    auto grown = std::make_unique<AlphaNode[]>(count + 1);
+    for (size_t i = 0; i < slot; ++i) {
+        grown[i] = std::move(children[i]);
+    }
+    for (size_t i = slot; i < count; ++i) {
+        grown[i + 1] = std::move(children[i]);
+    }
+    children = std::move(grown);
+    bitmap |= bit;
+    return &children[slot];
+}
+
+template <typename Alpha>
+bool AlphaNode<Alpha>::has_child(char c) const {
+    return get_child(c) != nullptr;
+}
+
+template <typename Alpha>
+void AlphaNode<Alpha>::remove_child(char c) {
+    if (has_child(c) == false) return;
+    uint32_t bit = uint32_t{1} << Alpha::index(c);
+    size_t slot = std::popcount(bitmap & (bit - 1));
+    size_t count = std::popcount(bitmap);
+
+    // Shrink the packed array by one, mirroring set_child
+    std::unique_ptr<AlphaNode[]> shrunk;
+    if (count > 1) {
+        shrunk = std::make_unique<AlphaNode[]>(count - 1);
+    }
+    for (size_t i = 0; i < slot; ++i) {
+        shrunk[i] = std::move(children[i]);
+    }
+    for (size_t i = slot + 1; i < count; ++i) {
+        shrunk[i - 1] = std::move(children[i]);
+    }
+    children = std::move(shrunk);
+    bitmap &= ~bit;
+}
+
+template <typename Alpha>
+size_t AlphaNode<Alpha>::child_count() const {
+    return std::popcount(bitmap);
+}
+
+template <typename Alpha>
+char AlphaNode<Alpha>::child_key(size_t index) const {
+    // Drop the `index` lowest set bits, the next one is the key
+    uint32_t bits = bitmap;
+    for (size_t i = 0; i < index; ++i) {
+        bits &= bits - 1;
+    }
+    return Alpha::key(std::countr_zero(bits));
+}
+
+template <typename Alpha>
+AlphaNode<Alpha> *AlphaNode<Alpha>::child_at(size_t index) const {
+    return &children[index];
+}
+
+template <typename Alpha>
+size_t AlphaNode<Alpha>::get_memory_usage() const {
+    if (children == nullptr) return 0;
+    // new[] of a type with a destructor stores the element count in front of the array
+    return Memory::estimate(sizeof(size_t) + child_count() * sizeof(AlphaNode));
+}
+
+template class AlphaNode<Lowercase>;
+
 };  // namespace Trie
@@ -1,176 +1,348 @@
 #include "trie_tree.hpp"
 
+#include <algorithm>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "generator.hpp"
+#include "memory.hpp"
+#include "utf8.hpp"
 #include "word.hpp"
 
 namespace Trie {
 
-Tree::Tree() {
-    root = std::make_unique<Node>();
-    memory_usage = 0;
-    stable = true;
-    height = 0;
+// Bytes below a child that still belong to its character, 0 for ASCII so the alphabet tries
+// never descend further
+static size_t continuation_bytes(char lead) {
+    return static_cast<unsigned char>(lead) < 0xC0 ? 0 : Utf8::sequence_length(lead) - 1;
 }
 
-void Tree::insert(std::shared_ptr<Word> word) {
-    Node *node = root.get();
-    for (char c : word->get_text()) {
-        Node *child = node->set_child(c);
+template <typename NodeType>
+BasicTree<NodeType>::BasicTree() {
+    root = std::make_unique<NodeType>();
+}
+
+template <typename NodeType>
+bool BasicTree<NodeType>::insert(std::shared_ptr<Word> word) {
+    const std::string &text = word->get_text();
+    if (std::all_of(text.begin(), text.end(), NodeType::accepts) == false) {
+        return false;  // Checked first so a rejected word leaves no dangling path behind
+    }
+    NodeType *node = root.get();
+    for (char c : text) {
+        NodeType *child = node->get_child(c);
+        if (child == nullptr) {
+            size_t bytes = node->get_memory_usage();
+            child = node->set_child(c);
+            node_count += 1;
+            node_bytes += node->get_memory_usage() - bytes;
+        }
         node = child;
     }
+    if (node->is_word() == false) {
+        if (length_counts.size() <= text.size()) {
+            length_counts.resize(text.size() + 1);
+        }
+        length_counts[text.size()] += 1;
+    }
     node->set_word(word);
-    stable = false;
+    return true;
 }
 
-std::shared_ptr<Word> Tree::search(const std::string &word) const {
-    Node *node = root.get();
+template <typename NodeType>
+std::shared_ptr<Word> BasicTree<NodeType>::remove(const std::string &text) {
+    std::vector<NodeType *> path = {root.get()};
+    for (char c : text) {
+        NodeType *child = path.back()->get_child(c);
+        if (child == nullptr) return nullptr;
+        path.push_back(child);
+    }
+    std::shared_ptr<Word> word = path.back()->get_word();
+    if (word == nullptr) return nullptr;
+    path.back()->set_word(nullptr);
+
+    length_counts[text.size()] -= 1;
+    while (length_counts.empty() == false && length_counts.back() == 0) {
+        length_counts.pop_back();
+    }
+    // Walk back up removing nodes that no longer lead to any word
+    for (size_t depth = text.size(); depth > 0; --depth) {
+        NodeType *node = path[depth];
+        if (node->is_word() || node->child_count() > 0) break;
+        NodeType *parent = path[depth - 1];
+        size_t bytes = parent->get_memory_usage() + node->get_memory_usage();
+        parent->remove_child(text[depth - 1]);
+        node_count -= 1;
+        node_bytes -= bytes - parent->get_memory_usage();
+    }
+    return word;
+}
+
+template <typename NodeType>
+std::shared_ptr<Word> BasicTree<NodeType>::search(const std::string &word) const {
+    NodeType *node = root.get();
     for (char c : word) {
-        Node *child = node->get_child(c);
+        NodeType *child = node->get_child(c);
         if (child == nullptr) return nullptr;
         node = child;
     }
     return node->get_word();
 }
 
-std::vector<std::shared_ptr<Word>> Tree::suggest(const std::string &prefix,
-                                                 int max_suggestions) const {
+template <typename NodeType>
+std::vector<std::shared_ptr<Word>> BasicTree<NodeType>::suggest(const std::string &prefix,
+                                                               int max_suggestions,
+                                                               const std::string &after) const {
     std::vector<std::shared_ptr<Word>> suggestions;
-    Node *node = root.get();
+    NodeType *node = root.get();
+
+    // Continue after a previous page: only words strictly greater than `after`
+    bool bounded = after.empty() == false;
+    if (bounded && after.compare(0, prefix.size(), prefix) != 0) {
+        if (after > prefix) {
+            return suggestions;  // Every word with this prefix sorts before `after`
+        }
+        bounded = false;  // Every word with this prefix sorts after `after`
+    }
 
     for (char c : prefix) {
-        Node *child = node->get_child(c);
+        NodeType *child = node->get_child(c);
         if (child == nullptr) {
             return suggestions;
         }
         node = child;
     }
-    suggest_core(node, prefix, suggestions, max_suggestions);
+    suggestions.reserve(max_suggestions);
+    suggest_core(node, prefix.size(), suggestions, max_suggestions, after, bounded);
     return suggestions;
 }
 
-std::vector<std::shared_ptr<Word>> Tree::match(const std::string &pattern, int max_matches) const {
+template <typename NodeType>
+std::vector<std::shared_ptr<Word>> BasicTree<NodeType>::match(const std::string &pattern,
+                                                             int max_matches) const {
     std::vector<std::shared_ptr<Word>> matches;
-    Node *node = root.get();
-    match_core(node, 0, "", pattern, matches, max_matches);
+    matches.reserve(max_matches);
+    match_core(pattern, matches, max_matches);
     return matches;
 }
 
-void Tree::set_stable(bool stable) {
-    this->stable = stable;
-}
+template <typename NodeType>
+Generator<std::shared_ptr<Word>> BasicTree<NodeType>::suggest_stream(std::string prefix) const {
+    const NodeType *node = root.get();
+    for (char c : prefix) {
+        node = node->get_child(c);
+        if (node == nullptr) co_return;
+    }
+    if (node->is_word()) {
+        co_yield node->get_word();
+    }
+    // Explicit stack of (node, next child index) keeps the traversal resumable
+    std::vector<std::pair<const NodeType *, size_t>> stack;
+    stack.emplace_back(node, 0);
 
-size_t Tree::get_memory_usage() {
-    if (stable == false || memory_usage == 0) {
-        memory_usage = calculate_memory_usage(root.get());
-        stable = true;
+    while (stack.empty() == false) {
+        auto &[current, index] = stack.back();
+        if (index == current->child_count()) {
+            stack.pop_back();
+            continue;
+        }
+        const NodeType *child = current->child_at(index++);
+        if (child->is_word()) {
+            co_yield child->get_word();
+        }
+        stack.emplace_back(child, 0);
     }
-    return memory_usage;
 }
 
-int Tree::get_height() {
-    if (stable == false || height == 0) {
-        height = calculate_height(root.get());
-        stable = true;
+template <typename NodeType>
+Generator<std::shared_ptr<Word>> BasicTree<NodeType>::match_stream(std::string pattern) const {
+    // Pending (node, pattern index) states, pushed in reverse to keep the order of match()
+    std::vector<std::pair<const NodeType *, size_t>> stack;
+    stack.emplace_back(root.get(), 0);
+
+    while (stack.empty() == false) {
+        auto [node, pattern_index] = stack.back();
+        stack.pop_back();
+
+        if (pattern_index == pattern.size()) {
+            if (node->is_word()) {
+                co_yield node->get_word();
+            }
+            continue;
+        }
+        push_matches(node, pattern_index, pattern, stack);
     }
-    return height;
 }
 
-void Tree::suggest_core(const Node *node, std::string prefix,
-                        std::vector<std::shared_ptr<Word>> &suggestions,
-                        int max_suggestions) const {
-    // Early exit
-    if (node == nullptr || suggestions.size() >= max_suggestions) return;
+template <typename NodeType>
+size_t BasicTree<NodeType>::get_node_count() const {
+    return node_count;
+}
 
-    if (node->is_word()) {
-        suggestions.push_back(node->get_word());
+template <typename NodeType>
+size_t BasicTree<NodeType>::get_memory_usage() const {
+    return Memory::block_size(root.get(), sizeof(NodeType)) + Memory::of(length_counts) +
+           node_bytes;
+}
+
+template <typename NodeType>
+int BasicTree<NodeType>::get_height() const {
+    // Every node lies on the path of some word, so the longest word sets the height
+    return 1 + static_cast<int>(length_counts.empty() ? 0 : length_counts.size() - 1);
+}
+
+template <typename NodeType>
+bool BasicTree<NodeType>::audit() const {
+    std::vector<std::pair<const NodeType *, size_t>> stack = {{root.get(), 0}};
+    std::vector<size_t> counted;
+    size_t nodes = 0, bytes = 0, max_depth = 0;
 
-        // Hot exit after adding a word
-        if (suggestions.size() >= max_suggestions) return;
+    while (stack.empty() == false) {
+        auto [node, depth] = stack.back();
+        stack.pop_back();
+        nodes += 1;
+        bytes += node->get_memory_usage();
+        max_depth = std::max(max_depth, depth);
+        if (node->is_word()) {
+            if (counted.size() <= depth) counted.resize(depth + 1);
+            counted[depth] += 1;
+        }
+        for (size_t i = 0; i < node->child_count(); ++i) {
+            stack.emplace_back(node->child_at(i), depth + 1);
+        }
     }
-    for (const auto &[c, child] : node->get_children()) {
-        suggest_core(child.get(), prefix + c, suggestions, max_suggestions);
+    return nodes == node_count && bytes == node_bytes && counted == length_counts &&
+           static_cast<int>(max_depth) + 1 == get_height();
+}
+
+template <typename NodeType>
+void BasicTree<NodeType>::suggest_core(const NodeType *start, size_t depth,
+                                       std::vector<std::shared_ptr<Word>> &suggestions,
+                                       int max_suggestions, const std::string &after,
+                                       bool bounded) const {
+    // Pending (node, depth, bounded) entries in pre-order, the stack keeps its capacity
+    // between queries so a warm thread allocates nothing here
+    struct Frame {
+        const NodeType *node;
+        size_t depth;
+        bool bounded;
+    };
+    thread_local std::vector<Frame> stack;
+    stack.clear();
+    stack.push_back({start, depth, bounded});
 
-        // After visiting a child
-        if (suggestions.size() >= max_suggestions) return;
+    while (stack.empty() == false && suggestions.size() < static_cast<size_t>(max_suggestions)) {
+        Frame frame = stack.back();
+        stack.pop_back();
+
+        // While bounded, the current path is a prefix of `after`, so this word is not past it
+        if (frame.node->is_word() && frame.bounded == false) {
+            suggestions.push_back(frame.node->get_word());
+        }
+        // Children pushed last to first so the smallest key is expanded next
+        for (size_t i = frame.node->child_count(); i-- > 0;) {
+            unsigned char c = static_cast<unsigned char>(frame.node->child_key(i));
+            bool limited = frame.bounded && frame.depth < after.size();
+            unsigned char bound = limited ? static_cast<unsigned char>(after[frame.depth]) : 0;
+            if (limited && c < bound) break;  // This and all smaller keys
+
+            bool child_bounded = limited && c == bound;
+            stack.push_back({frame.node->child_at(i), frame.depth + 1, child_bounded});
+        }
     }
 }
 
-void Tree::match_core(const Node *node, size_t pattern_index, const std::string &current,
-                      const std::string &pattern, std::vector<std::shared_ptr<Word>> &matches,
-                      int max_matches) const {
-    // End of finding path
-    if (node == nullptr || matches.size() >= max_matches) return;
+template <typename NodeType>
+void BasicTree<NodeType>::match_core(const std::string &pattern,
+                                     std::vector<std::shared_ptr<Word>> &matches,
+                                     int max_matches) const {
+    thread_local std::vector<std::pair<const NodeType *, size_t>> stack;
+    stack.clear();
+    stack.emplace_back(root.get(), 0);
 
-    // End of pattern, collect word if it is valid
-    if (pattern_index == pattern.size()) {
-        if (node->is_word()) {
-            matches.push_back(node->get_word());
+    while (stack.empty() == false && matches.size() < static_cast<size_t>(max_matches)) {
+        auto [node, pattern_index] = stack.back();
+        stack.pop_back();
+
+        // End of pattern, collect word if it is valid
+        if (pattern_index == pattern.size()) {
+            if (node->is_word()) {
+                matches.push_back(node->get_word());
+            }
+            continue;
         }
-        return;
+        push_matches(node, pattern_index, pattern, stack);
     }
+}
 
+template <typename NodeType>
+void BasicTree<NodeType>::push_matches(
+    const NodeType *node, size_t pattern_index, const std::string &pattern,
+    std::vector<std::pair<const NodeType *, size_t>> &stack) const {
+    // States are pushed in reverse so they pop in the order a depth-first search visits them
+    size_t count = node->child_count();
     char pattern_char = pattern[pattern_index];
 
-    // '+': Match zero or more characters
+    // '*': Match zero characters first, then one more character and stay on '*'
     if (pattern_char == '*') {
-        // Case 1: Match zero characters and advance pattern index
-        match_core(node, pattern_index + 1, current, pattern, matches, max_matches);
-
-        // Case 2. Match one or more characters (recurse into each child and stay on '*')
-        for (const auto &[c, child] : node->get_children()) {
-            match_core(child.get(), pattern_index, current + c, pattern, matches, max_matches);
+        for (size_t i = count; i-- > 0;) {
+            push_character(node, i, pattern_index, stack);
         }
+        stack.emplace_back(node, pattern_index + 1);
     }
-    // '+': Must match at least one or more characters
+    // '+': Consume one character, then either stay on '+' or move past it
     else if (pattern_char == '+') {
-        // NOTE: Must consume at least one character before staying on '+'
-        for (const auto &[c, child] : node->get_children()) {
-            // First, must advance into children (consume one char), stay on '+'
-            match_core(child.get(), pattern_index, current + c, pattern, matches, max_matches);
-
-            // After consuming one or more, now move to next pattern index
-            match_core(child.get(), pattern_index + 1, current + c, pattern, matches, max_matches);
+        for (size_t i = count; i-- > 0;) {
+            push_character(node, i, pattern_index + 1, stack);
+            push_character(node, i, pattern_index, stack);
         }
     }
     // '?': Match exactly one character
     else if (pattern_char == '?') {
-        for (const auto &[c, child] : node->get_children()) {
-            match_core(child.get(), pattern_index + 1, current + c, pattern, matches, max_matches);
+        for (size_t i = count; i-- > 0;) {
+            push_character(node, i, pattern_index + 1, stack);
         }
     }
     // Normal match
     else {
-        auto it = node->get_children().find(pattern_char);
-        if (it != node->get_children().end()) {
-            const Node *child = it->second.get();
-            match_core(child, pattern_index + 1, current + pattern_char, pattern, matches,
-                       max_matches);
+        const NodeType *child = node->get_child(pattern_char);
+        if (child != nullptr) {
+            stack.emplace_back(child, pattern_index + 1);
         }
     }
 }
 
-size_t Tree::calculate_memory_usage(const Node *node) const {
-    if (node == nullptr) return 0;
-
-    size_t size = sizeof(Node);
-
-    for (const auto &[_, child] : node->get_children()) {
-        size += calculate_memory_usage(child.get());
+template <typename NodeType>
+void BasicTree<NodeType>::push_character(
+    const NodeType *node, size_t index, size_t pattern_index,
+    std::vector<std::pair<const NodeType *, size_t>> &stack) const {
+    // A wildcard consumes a whole character, for UTF-8 the nodes its last byte leads to
+    const NodeType *child = node->child_at(index);
+    size_t remaining = continuation_bytes(node->child_key(index));
+    if (remaining == 0) {
+        stack.emplace_back(child, pattern_index);
+        return;
     }
-    return size;
-}
-
-int Tree::calculate_height(const Node *node) const {
-    if (node == nullptr) return 0;
-
-    int max_depth = 0;
-    for (const auto &[_, child] : node->get_children()) {
-        max_depth = std::max(max_depth, calculate_height(child.get()));
+    thread_local std::vector<std::pair<const NodeType *, size_t>> pending;
+    pending.clear();
+    pending.emplace_back(child, remaining);
+    while (pending.empty() == false) {
+        auto [current, left] = pending.back();
+        pending.pop_back();
+        if (left == 0) {
+            stack.emplace_back(current, pattern_index);
+            continue;
+        }
+        // Largest popped first, so the stack receives them in the reverse order of the siblings
+        for (size_t i = 0; i < current->child_count(); ++i) {
+            pending.emplace_back(current->child_at(i), left - 1);
+        }
     }
-    return 1 + max_depth;
 }
 
+template class BasicTree<Node>;
+template class BasicTree<AlphaNode<Lowercase>>;
+
 };  // namespace Trie
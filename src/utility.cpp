@@ -7,7 +7,14 @@
 #include <iterator>
 #include <limits>
 
+#include "utf8.hpp"
+
 std::string lower(const std::string &str) {
+    if (Utf8::is_ascii(str) == false) {
+        // Case folded like dictionary keys, malformed text is kept as it is
+        std::string folded = Utf8::normalize(str);
+        return folded.empty() ? str : folded;
+    }
     std::string result;
     std::transform(str.begin(), str.end(), std::back_inserter(result), ::tolower);
     return result;
@@ -5,7 +5,10 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <utility>
 
+#include "definition_store.hpp"
+#include "memory.hpp"
 #include "utility.hpp"
 
 Word::Word(const std::string &text) : text(text) {}
@@ -14,7 +17,10 @@ const std::string &Word::get_text() const {
     return text;
 }
 
-const std::vector<std::string> &Word::get_definition() const {
+std::vector<std::string> Word::get_definition() const {
+    if (store != nullptr) {
+        return store->get(entry);
+    }
     return definition;
 }
 
@@ -22,11 +28,19 @@ const std::vector<POS> &Word::get_pos() const {
     return pos;
 }
 
+bool Word::has_definition() const {
+    return store != nullptr || definition.empty() == false;
+}
+
 void Word::set_text(const std::string &text) {
     this->text = text;
 }
 
 void Word::add_definition(const std::string &definition) {
+    if (store != nullptr) {
+        this->definition = store->get(entry);  // Back in the word, where it can grow
+        store.reset();
+    }
     this->definition.push_back(definition);
 }
 
@@ -34,6 +48,31 @@ void Word::add_pos(POS pos) {
     this->pos.push_back(pos);
 }
 
+void Word::clear_definition() {
+    definition.clear();
+    pos.clear();
+    store.reset();
+}
+
+void Word::set_store(std::shared_ptr<const DefinitionStore> store, uint32_t entry) {
+    this->store = std::move(store);
+    this->entry = entry;
+    definition.clear();
+    definition.shrink_to_fit();
+}
+
+const DefinitionStore *Word::get_store() const {
+    return store.get();
+}
+
+size_t Word::get_definition_memory() const {
+    size_t bytes = Memory::of(pos) + Memory::of(definition);
+    for (const std::string &text : definition) {
+        bytes += Memory::of(text);
+    }
+    return bytes;
+}
+
 std::string parse_pos(POS pos) {
     switch (pos) {
         case POS::Noun:
@@ -79,10 +118,12 @@ void print(std::shared_ptr<Word> word, bool show_definition) {
         return;
     }
     std::string text = word->get_text();
-    const std::vector<std::string> &definition = word->get_definition();
     const std::vector<POS> &pos = word->get_pos();
 
-    if (show_definition && definition.empty() == false) {
+    if (show_definition && word->has_definition()) {
+        // Only decompressed here, listing words never touches the definitions
+        std::vector<std::string> definition = word->get_definition();
+
         // Header
         std::cout << "\t== " << BOLD << text << RESET << " ==" << '\n';
 
@@ -0,0 +1,279 @@
+#include "workload.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+Workload::Workload(uint64_t seed) : rng(seed) {}
+
+bool Workload::load_words(const std::string &filepath) {
+    std::ifstream fin(filepath);
+    if (fin.is_open() == false) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(fin, line)) {
+        // Accept both plain word lists and dictionary CSV files (first column)
+        line = line.substr(0, line.find(','));
+        if (line.empty() == false && line.back() == '\r') line.pop_back();
+        if (line.empty() == false && line != "text") add_word(line);
+    }
+    return words.empty() == false;
+}
+
+void Workload::add_word(const std::string &word) {
+    words.push_back(word);
+}
+
+size_t Workload::get_word_count() const {
+    return words.size();
+}
+
+std::vector<Request> Workload::generate(size_t count, const Mix &mix) {
+    std::vector<Request> requests;
+    if (words.empty()) return requests;
+
+    std::discrete_distribution<int> pick({static_cast<double>(mix.exact),
+                                          static_cast<double>(mix.miss),
+                                          static_cast<double>(mix.typo1),
+                                          static_cast<double>(mix.typo2),
+                                          static_cast<double>(mix.typo3),
+                                          static_cast<double>(mix.prefix),
+                                          static_cast<double>(mix.pattern)});
+    requests.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        QueryKind kind = static_cast<QueryKind>(pick(rng));
+        switch (kind) {
+            case QueryKind::Exact:
+                requests.push_back({kind, random_word()});
+                break;
+            case QueryKind::Miss:
+                requests.push_back({kind, make_miss()});
+                break;
+            case QueryKind::Typo1:
+                requests.push_back({kind, make_typo(random_word(), 1)});
+                break;
+            case QueryKind::Typo2:
+                requests.push_back({kind, make_typo(random_word(), 2)});
+                break;
+            case QueryKind::Typo3:
+                requests.push_back({kind, make_typo(random_word(), 3)});
+                break;
+            case QueryKind::Prefix:
+                requests.push_back({kind, make_prefix(random_word())});
+                break;
+            case QueryKind::Pattern:
+                requests.push_back({kind, make_pattern(random_word())});
+                break;
+            default:
+                break;
+        }
+    }
+    return requests;
+}
+
+std::string Workload::make_typo(const std::string &word, int edits) {
+    // Each edit changes the edit distance by at most one
+    std::string typo = word;
+    for (int i = 0; i < edits; ++i) {
+        int operation = std::uniform_int_distribution<int>(0, 3)(rng);
+        if (typo.size() < 2) operation = 1;  // Only insert into tiny words
+        // An insertion may also append, so empty words get one too
+        size_t last = (operation == 1) ? typo.size() : typo.size() - 1;
+        size_t at = std::uniform_int_distribution<size_t>(0, last)(rng);
+
+        if (operation == 0) {
+            typo[at] = random_letter();  // Substitution
+        } else if (operation == 1) {
+            typo.insert(typo.begin() + at, random_letter());  // Insertion
+        } else if (operation == 2) {
+            typo.erase(typo.begin() + at);  // Deletion
+        } else if (at + 1 < typo.size()) {
+            std::swap(typo[at], typo[at + 1]);  // Adjacent transposition
+        } else {
+            typo[at] = random_letter();
+        }
+    }
+    return typo;
+}
+
+std::string Workload::make_miss() {
+    // Random letters are almost never a dictionary word
+    size_t length = std::uniform_int_distribution<size_t>(6, 12)(rng);
+    std::string miss;
+    for (size_t i = 0; i < length; ++i) {
+        miss += random_letter();
+    }
+    return miss;
+}
+
+std::string Workload::make_prefix(const std::string &word) {
+    size_t length = std::uniform_int_distribution<size_t>(1, std::min<size_t>(word.size(), 6))(rng);
+    return word.substr(0, length) + '_';
+}
+
+std::string Workload::make_pattern(const std::string &word) {
+    int shape = std::uniform_int_distribution<int>(0, 2)(rng);
+    std::string pattern = word;
+
+    if (shape == 0) {
+        // Blank out one or two characters
+        pattern[std::uniform_int_distribution<size_t>(0, pattern.size() - 1)(rng)] = '?';
+        pattern[std::uniform_int_distribution<size_t>(0, pattern.size() - 1)(rng)] = '?';
+    } else if (shape == 1) {
+        // Keep the ending: "*tion"
+        size_t keep = std::uniform_int_distribution<size_t>(1, std::min<size_t>(word.size(), 4))(rng);
+        pattern = '*' + word.substr(word.size() - keep);
+    } else {
+        // Keep both ends: "ca+t"
+        if (word.size() < 3) return word + '*';
+        pattern = word.substr(0, 2) + '+' + word.back();
+    }
+    return pattern;
+}
+
+const std::string &Workload::random_word() {
+    return words[std::uniform_int_distribution<size_t>(0, words.size() - 1)(rng)];
+}
+
+char Workload::random_letter() {
+    return static_cast<char>('a' + std::uniform_int_distribution<int>(0, 25)(rng));
+}
+
+bool load_log(const std::string &filepath, std::vector<Request> &requests) {
+    std::ifstream fin(filepath);
+    if (fin.is_open() == false) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(fin, line)) {
+        if (line.empty() == false && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+
+        QueryKind kind = QueryKind::Replay;
+        if (line.back() == '_') {
+            kind = QueryKind::Prefix;
+        } else if (line.find_first_of("*+?") != std::string::npos) {
+            kind = QueryKind::Pattern;
+        }
+        requests.push_back({kind, line});
+    }
+    return true;
+}
+
+std::string parse_kind(QueryKind kind) {
+    switch (kind) {
+        case QueryKind::Exact:
+            return "exact";
+        case QueryKind::Miss:
+            return "miss";
+        case QueryKind::Typo1:
+            return "typo-1";
+        case QueryKind::Typo2:
+            return "typo-2";
+        case QueryKind::Typo3:
+            return "typo-3";
+        case QueryKind::Prefix:
+            return "prefix";
+        case QueryKind::Pattern:
+            return "pattern";
+        case QueryKind::Replay:
+            return "replay";
+        default:
+            return "all";
+    }
+}
+
+bool parse_mix(const std::string &str, Mix &mix) {
+    // "exact:40,miss:10,typo1:15,...", kinds left out are not generated. Weights must be
+    // non-negative integers and not all zero
+    mix = Mix{0, 0, 0, 0, 0, 0, 0};
+    long total = 0;
+    std::istringstream ss(str);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        size_t colon = item.find(':');
+        if (colon == std::string::npos) return false;
+        std::string name = item.substr(0, colon);
+        std::string_view value = std::string_view(item).substr(colon + 1);
+        int weight = 0;
+        auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), weight);
+        if (error != std::errc() || end != value.data() + value.size() || weight < 0) {
+            return false;
+        }
+        total += weight;
+
+        if (name == "exact") mix.exact = weight;
+        else if (name == "miss") mix.miss = weight;
+        else if (name == "typo1") mix.typo1 = weight;
+        else if (name == "typo2") mix.typo2 = weight;
+        else if (name == "typo3") mix.typo3 = weight;
+        else if (name == "prefix") mix.prefix = weight;
+        else if (name == "pattern") mix.pattern = weight;
+        else return false;
+    }
+    return total > 0;
+}
+
+LatencyRecorder::LatencyRecorder() : samples(static_cast<size_t>(QueryKind::Count)) {}
+
+void LatencyRecorder::add(QueryKind kind, uint64_t nanoseconds) {
+    samples[static_cast<size_t>(kind)].push_back(nanoseconds);
+}
+
+void LatencyRecorder::merge(const LatencyRecorder &other) {
+    for (size_t i = 0; i < samples.size(); ++i) {
+        samples[i].insert(samples[i].end(), other.samples[i].begin(), other.samples[i].end());
+    }
+}
+
+void LatencyRecorder::report(double elapsed_seconds) const {
+    std::cout << std::left << std::setw(10) << "kind" << std::right << std::setw(10) << "count"
+              << std::setw(12) << "qps" << std::setw(10) << "p50(us)" << std::setw(10) << "p90"
+              << std::setw(10) << "p99" << std::setw(10) << "p99.9" << std::setw(10) << "max"
+              << '\n';
+
+    std::vector<uint64_t> all;
+    auto print_row = [elapsed_seconds](const std::string &name, std::vector<uint64_t> row) {
+        if (row.empty()) return;
+        std::cout << std::left << std::setw(10) << name << std::right << std::setw(10)
+                  << row.size() << std::setw(12) << std::fixed << std::setprecision(0)
+                  << row.size() / elapsed_seconds << std::setprecision(1);
+        for (double p : {50.0, 90.0, 99.0, 99.9, 100.0}) {
+            std::cout << std::setw(10) << percentile(row, p) / 1000.0;
+        }
+        std::cout << '\n';
+    };
+    for (size_t i = 0; i < samples.size(); ++i) {
+        print_row(parse_kind(static_cast<QueryKind>(i)), samples[i]);
+        all.insert(all.end(), samples[i].begin(), samples[i].end());
+    }
+    print_row("all", all);
+    std::cout << std::flush;
+}
+
+size_t LatencyRecorder::get_count(QueryKind kind) const {
+    return samples[static_cast<size_t>(kind)].size();
+}
+
+uint64_t LatencyRecorder::get_percentile(QueryKind kind, double p) const {
+    std::vector<uint64_t> copy = samples[static_cast<size_t>(kind)];
+    return percentile(copy, p);
+}
+
+uint64_t percentile(std::vector<uint64_t> &samples, double p) {
+    if (samples.empty()) return 0;
+    // Nearest-rank percentile
+    size_t rank = static_cast<size_t>(p / 100.0 * samples.size() + 0.999999);
+    rank = std::clamp<size_t>(rank, 1, samples.size());
+    std::nth_element(samples.begin(), samples.begin() + (rank - 1), samples.end());
+    return samples[rank - 1];
+}
@@ -0,0 +1,139 @@
+#include "xor_filter.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "memory.hpp"
+
+namespace Filter {
+
+// Probes behind the measured false positive rate, a few per key within these bounds so small
+// rebuilds stay cheap
+static constexpr size_t MIN_PROBES = 1 << 10;
+static constexpr size_t MAX_PROBES = 1 << 14;
+
+// SplitMix64 step, the source of seeds and probe keys
+static uint64_t next_random(uint64_t &state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+    return z ^ (z >> 31);
+}
+
+static uint8_t fingerprint(uint64_t mixed) {
+    return static_cast<uint8_t>(mixed ^ (mixed >> 32));
+}
+
+uint64_t hash(std::string_view text) {
+    return std::hash<std::string_view>{}(text);
+}
+
+void Xor8::build(std::vector<uint64_t> keys) {
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    key_count = keys.size();
+
+    size_t capacity = 32 + static_cast<size_t>(1.23 * static_cast<double>(key_count));
+    segment_length = static_cast<uint32_t>((capacity + 2) / 3);
+    size_t size = 3 * static_cast<size_t>(segment_length);
+
+    // Every slot keeps the XOR and the number of keys hashing to it. A slot with one key
+    // left identifies that key, so it can be peeled off and its other slots updated
+    std::vector<uint64_t> xors(size);
+    std::vector<uint32_t> counts(size);
+    std::vector<uint32_t> queue;
+    std::vector<std::pair<uint64_t, uint32_t>> stack;  // (mixed key, slot it owns)
+    uint64_t state = 0x5EED;
+    while (true) {
+        seed = next_random(state);
+        std::fill(xors.begin(), xors.end(), 0);
+        std::fill(counts.begin(), counts.end(), 0);
+        for (uint64_t key : keys) {
+            uint64_t mixed = mix(key);
+            for (int segment = 0; segment < 3; ++segment) {
+                uint32_t i = slot(mixed, segment);
+                xors[i] ^= mixed;
+                counts[i] += 1;
+            }
+        }
+
+        queue.clear();
+        stack.clear();
+        for (uint32_t i = 0; i < size; ++i) {
+            if (counts[i] == 1) queue.push_back(i);
+        }
+        while (queue.empty() == false) {
+            uint32_t i = queue.back();
+            queue.pop_back();
+            if (counts[i] != 1) continue;  // Emptied since it was queued
+            uint64_t mixed = xors[i];
+            stack.emplace_back(mixed, i);
+            for (int segment = 0; segment < 3; ++segment) {
+                uint32_t j = slot(mixed, segment);
+                xors[j] ^= mixed;
+                counts[j] -= 1;
+                if (counts[j] == 1) queue.push_back(j);
+            }
+        }
+        if (stack.size() == key_count) break;  // Otherwise a cycle is left, try another seed
+    }
+
+    // In reverse peeling order each key owns a slot none of the keys assigned later touch, so
+    // its fingerprint can be made the XOR of its three slots
+    fingerprints.assign(size, 0);
+    for (auto it = stack.rbegin(); it != stack.rend(); ++it) {
+        auto [mixed, i] = *it;
+        fingerprints[i] = fingerprint(mixed) ^ fingerprints[slot(mixed, 0)] ^
+                          fingerprints[slot(mixed, 1)] ^ fingerprints[slot(mixed, 2)];
+    }
+
+    size_t probes = std::clamp(4 * key_count, MIN_PROBES, MAX_PROBES);
+    size_t positives = 0;
+    for (size_t i = 0; i < probes; ++i) {
+        positives += contains(next_random(state));
+    }
+    false_positive_rate = static_cast<double>(positives) / static_cast<double>(probes);
+}
+
+bool Xor8::contains(uint64_t key) const {
+    if (fingerprints.empty()) {
+        return false;  // Never built
+    }
+    uint64_t mixed = mix(key);
+    return fingerprint(mixed) == (fingerprints[slot(mixed, 0)] ^ fingerprints[slot(mixed, 1)] ^
+                                  fingerprints[slot(mixed, 2)]);
+}
+
+size_t Xor8::get_key_count() const {
+    return key_count;
+}
+
+size_t Xor8::get_memory_usage() const {
+    return Memory::of(fingerprints);
+}
+
+double Xor8::get_false_positive_rate() const {
+    return false_positive_rate;
+}
+
+uint64_t Xor8::mix(uint64_t key) const {
+    // MurmurHash3 finalizer, a bijection so distinct keys stay distinct for every seed
+    key += seed;
+    key = (key ^ (key >> 33)) * 0xFF51AFD7ED558CCD;
+    key = (key ^ (key >> 33)) * 0xC4CEB9FE1A85EC53;
+    return key ^ (key >> 33);
+}
+
+uint32_t Xor8::slot(uint64_t mixed, int segment) const {
+    // Maps 32 bits of a rotation onto the segment without a division
+    uint32_t bits = static_cast<uint32_t>(std::rotl(mixed, 21 * segment));
+    return static_cast<uint32_t>((static_cast<uint64_t>(bits) * segment_length) >> 32) +
+           segment * segment_length;
+}
+
+};  // namespace Filter
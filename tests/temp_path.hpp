@@ -0,0 +1,15 @@
+#ifndef TEMP_PATH_HPP
+#define TEMP_PATH_HPP
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <string>
+
+// A per-process path under the test temp directory, `name` plus the PID
+inline std::string temp_path(const std::string &name) {
+    return ::testing::TempDir() + name + "_" + std::to_string(getpid());
+}
+
+#endif
@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "bk_tree.hpp"
+#include "trie_tree.hpp"
+#include "word.hpp"
+
+// Counting replacement of the global allocator, per thread so other tests cannot interfere
+static thread_local size_t allocations = 0;
+
+void *operator new(size_t size) {
+    allocations += 1;
+    if (void *pointer = std::malloc(size == 0 ? 1 : size)) return pointer;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept {
+    std::free(pointer);
+}
+
+// Allocations made while running `query`
+template <typename Function>
+static size_t count_allocations(Function query) {
+    size_t before = allocations;
+    query();
+    return allocations - before;
+}
+
+static std::vector<std::shared_ptr<Word>> make_words() {
+    std::vector<std::shared_ptr<Word>> words;
+    for (char a = 'a'; a <= 'z'; ++a) {
+        for (char b = 'a'; b <= 'z'; b += 3) {
+            for (const char *suffix : {"", "e", "ed", "ing", "ter", "tion"}) {
+                words.push_back(std::make_shared<Word>(std::string{a, b} + suffix));
+            }
+        }
+    }
+    return words;
+}
+
+template <typename Tree>
+static void expect_trie_queries_do_not_allocate() {
+    Tree tree;
+    for (const auto &word : make_words()) {
+        tree.insert(word);
+    }
+    std::string word = "ad", prefix = "a", after = "ade", pattern = "*e?", plus = "a+g";
+
+    // Warm up the per-thread traversal stacks first, later queries reuse their capacity
+    tree.suggest(prefix, 1000);
+    tree.match("*", 1000);
+
+    EXPECT_EQ(count_allocations([&] { tree.search(word); }), 0);
+    // The result vector is the only allocation left, whatever the size of the subtree walked
+    EXPECT_EQ(count_allocations([&] { tree.suggest(prefix, 5); }), 1);
+    EXPECT_EQ(count_allocations([&] { tree.suggest(prefix, 5, after); }), 1);
+    EXPECT_EQ(count_allocations([&] { tree.match(pattern, 5); }), 1);
+    EXPECT_EQ(count_allocations([&] { tree.match(plus, 5); }), 1);
+}
+
+TEST(AllocationTest, TrieQueries) {
+    expect_trie_queries_do_not_allocate<Trie::Tree>();
+    expect_trie_queries_do_not_allocate<Trie::LowercaseTree>();
+}
+
+TEST(AllocationTest, BKTreeQueries) {
+    BK::Tree tree;
+    tree.build(make_words());
+    std::string query = "adting", miss = "zzzzzzzz";
+
+    tree.search(query, 3, 1000);  // Warm up the per-thread scratch space
+
+    EXPECT_EQ(count_allocations([&] { tree.search(query, 2, 5); }), 1);
+    EXPECT_LE(count_allocations([&] { tree.search(miss, 2, 5); }), 1);
+}
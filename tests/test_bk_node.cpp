@@ -7,17 +7,29 @@ TEST(BKNodeTest, Initialization) {
     BK::Node node(word);
 
     EXPECT_EQ(node.get_word()->get_text(), "cat");
-    EXPECT_TRUE(node.get_children().empty());
+    EXPECT_EQ(node.get_distance(), 0);
+    EXPECT_TRUE(node.is_leaf());
+    EXPECT_EQ(node.get_next_sibling(), BK::Node::NONE);
 }
 
-TEST(BKNodeTest, SetAndGetChild) {
-    auto parent_word = std::make_shared<Word>("cat");
-    BK::Node node(parent_word);
+TEST(BKNodeTest, SetAndGetLinks) {
+    BK::Node node(std::make_shared<Word>("mouse"), 2);
+    node.set_first_child(4);
+    node.set_next_sibling(7);
 
-    auto child_word = std::make_shared<Word>("mouse");
-    BK::Node* child = node.set_child(2, child_word);
+    EXPECT_EQ(node.get_distance(), 2);
+    EXPECT_FALSE(node.is_leaf());
+    EXPECT_EQ(node.get_first_child(), 4);
+    EXPECT_EQ(node.get_next_sibling(), 7);
+}
+
+TEST(BKNodeTest, SubtreeLengthRange) {
+    BK::Node node(std::make_shared<Word>("house"));
+    EXPECT_EQ(node.get_min_length(), 5);
+    EXPECT_EQ(node.get_max_length(), 5);
 
-    EXPECT_TRUE(node.has_child(2));
-    EXPECT_EQ(node.get_child(2)->get_word()->get_text(), "mouse");
-    EXPECT_EQ(child, node.get_child(2));
+    node.extend_length(2, 3);
+    node.extend_length(9, 9);
+    EXPECT_EQ(node.get_min_length(), 2);
+    EXPECT_EQ(node.get_max_length(), 9);
 }
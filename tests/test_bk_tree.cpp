@@ -1,10 +1,28 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "bk_tree.hpp"
+#include "distance.hpp"
 #include "word.hpp"
 
+// Plain full-matrix reference distance
+static int levenshtein(const std::string& a, const std::string& b) {
+    std::vector<std::vector<int>> dp(a.size() + 1, std::vector<int>(b.size() + 1));
+    for (size_t i = 0; i <= a.size(); ++i) dp[i][0] = i;
+    for (size_t j = 0; j <= b.size(); ++j) dp[0][j] = j;
+    for (size_t i = 1; i <= a.size(); ++i) {
+        for (size_t j = 1; j <= b.size(); ++j) {
+            int cost = (a[i - 1] == b[j - 1]) ? 0 : 1;
+            dp[i][j] = std::min({dp[i - 1][j] + 1, dp[i][j - 1] + 1, dp[i - 1][j - 1] + cost});
+        }
+    }
+    return dp[a.size()][b.size()];
+}
+
 TEST(BKTreeTest, InsertAndSearchWords) {
     BK::Tree tree;
 
@@ -36,3 +54,241 @@ TEST(BKTreeTest, MemoryUsageAndHeight) {
     EXPECT_GT(tree.get_memory_usage(), 0);
     EXPECT_GE(tree.get_height(), 1);
 }
+
+TEST(BKTreeTest, SearchStreamStopsEarly) {
+    BK::Tree tree;
+    for (const char* text : {"book", "back", "boon", "cook", "look", "nook"}) {
+        tree.insert(std::make_shared<Word>(text));
+    }
+
+    auto stream = tree.search_stream("book", 1);
+    auto page = stream.take(2);
+    ASSERT_EQ(page.size(), 2);
+    EXPECT_EQ(page[0]->get_text(), "book");
+
+    size_t rest = 0;
+    for (const auto& word : stream) {
+        EXPECT_NE(word->get_text(), "back");
+        rest += 1;
+    }
+    EXPECT_EQ(page.size() + rest, 5);
+}
+
+TEST(BKTreeTest, BuildMatchesSequentialInsert) {
+    std::vector<std::shared_ptr<Word>> words;
+    for (const char* text : {"back", "bake", "ball", "band", "bank", "book", "boon", "brook",
+                             "cook", "cool", "look", "loom", "nook", "rook", "took", "tool"}) {
+        words.push_back(std::make_shared<Word>(text));
+    }
+    BK::Tree sequential;
+    for (const auto& word : words) {
+        sequential.insert(word);
+    }
+    BK::Tree balanced;
+    balanced.build(words);
+
+    EXPECT_LE(balanced.get_height(), sequential.get_height());
+
+    for (const char* query : {"book", "bool", "tok", "bnak", "zzzz"}) {
+        auto expected = sequential.search(query, 2, 100);
+        auto found = balanced.search(query, 2, 100);
+        std::vector<std::string> expected_texts, found_texts;
+        for (const auto& word : expected) expected_texts.push_back(word->get_text());
+        for (const auto& word : found) found_texts.push_back(word->get_text());
+        std::sort(expected_texts.begin(), expected_texts.end());
+        std::sort(found_texts.begin(), found_texts.end());
+        EXPECT_EQ(found_texts, expected_texts) << "query: " << query;
+    }
+    EXPECT_GT(balanced.get_average_visits(), 0.0);
+    balanced.reset_visits();
+    EXPECT_EQ(balanced.get_average_visits(), 0.0);
+}
+
+TEST(BKTreeTest, FiltersKeepAllMatches) {
+    std::vector<std::string> texts = {"a",      "an",      "ant",      "anta",      "antler",
+                                      "banana", "bandana", "cabana",   "nab",       "tan",
+                                      "stand",  "strand",  "standard", "tandem",    "abandon",
+                                      "and",    "sand",    "nadas",    "dana",      "bananas"};
+    BK::Tree sequential, balanced;
+    std::vector<std::shared_ptr<Word>> words;
+    for (const auto& text : texts) {
+        words.push_back(std::make_shared<Word>(text));
+        sequential.insert(words.back());
+    }
+    balanced.build(words);
+
+    for (const char* query : {"ant", "banan", "sandard", "nda", "xyz", "abandoned"}) {
+        for (int max_distance = 0; max_distance <= 3; ++max_distance) {
+            std::vector<std::string> expected;
+            for (const auto& word : words) {
+                if (levenshtein(query, word->get_text()) <= max_distance) {
+                    expected.push_back(word->get_text());
+                }
+            }
+            std::sort(expected.begin(), expected.end());
+
+            for (BK::Tree* tree : {&sequential, &balanced}) {
+                std::vector<std::string> found;
+                for (const auto& word : tree->search(query, max_distance, 100)) {
+                    found.push_back(word->get_text());
+                }
+                std::sort(found.begin(), found.end());
+                EXPECT_EQ(found, expected) << "query: " << query << ", k: " << max_distance;
+            }
+        }
+    }
+}
+
+TEST(BKTreeTest, SearchReturnsNearestFirst) {
+    BK::Tree tree;
+    tree.insert(std::make_shared<Word>("coat"));  // Root, 2 away from "cut"
+    tree.insert(std::make_shared<Word>("cats"));  // 2 away
+    tree.insert(std::make_shared<Word>("cot"));   // 1 away
+    tree.insert(std::make_shared<Word>("cup"));   // 1 away
+
+    auto results = tree.search("cut", 2, 1);
+    ASSERT_EQ(results.size(), 1);
+    EXPECT_EQ(levenshtein("cut", results[0]->get_text()), 1);  // Not the root at distance 2
+
+    results = tree.search("cut", 2, 3);
+    ASSERT_EQ(results.size(), 3);
+    EXPECT_EQ(results[0]->get_text(), "cot");
+    EXPECT_EQ(results[1]->get_text(), "cup");
+    EXPECT_EQ(levenshtein("cut", results[2]->get_text()), 2);
+}
+
+TEST(BKTreeTest, TopKMatchesBruteForce) {
+    std::vector<std::shared_ptr<Word>> words;
+    for (const char* text : {"stone", "store", "story", "stare", "start", "smart", "spare",
+                             "share", "shore", "score", "scare", "stoke", "stole", "stove",
+                             "tone", "tore", "store", "storm", "sport", "short"}) {
+        words.push_back(std::make_shared<Word>(text));
+    }
+    BK::Tree tree;
+    tree.build(words);
+
+    for (const char* query : {"stor", "shart", "stoe", "sxore"}) {
+        for (int k = 1; k <= 6; ++k) {
+            std::vector<std::pair<int, std::string>> ranked;
+            for (const auto& word : words) {
+                int distance = levenshtein(query, word->get_text());
+                if (distance <= 2) ranked.emplace_back(distance, word->get_text());
+            }
+            std::sort(ranked.begin(), ranked.end());
+            ranked.resize(std::min<size_t>(ranked.size(), k));
+
+            auto results = tree.search(query, 2, k);
+            ASSERT_EQ(results.size(), ranked.size()) << "query: " << query << ", k: " << k;
+            for (size_t i = 0; i < results.size(); ++i) {
+                // Same distances as the reference, ties at the cut-off may pick other words
+                EXPECT_EQ(levenshtein(query, results[i]->get_text()), ranked[i].first)
+                    << "query: " << query << ", k: " << k;
+            }
+        }
+    }
+}
+
+// Every metric policy must return exactly what a scan of all words with the same distance finds
+template <typename Metric>
+static void expect_scan_results(const std::vector<std::string>& texts) {
+    BK::BasicTree<Metric> tree;
+    std::vector<std::shared_ptr<Word>> words;
+    for (const auto& text : texts) {
+        words.push_back(std::make_shared<Word>(text));
+    }
+    tree.build(words);
+
+    Metric metric;
+    for (const char* query : {"teh", "recieve", "cst", "form", "xyz"}) {
+        for (int max_distance = 0; max_distance <= 2; ++max_distance) {
+            std::vector<std::string> expected;
+            for (const auto& text : texts) {
+                if (metric(query, text) <= max_distance * Metric::unit) expected.push_back(text);
+            }
+            std::sort(expected.begin(), expected.end());
+
+            std::vector<std::string> found;
+            for (const auto& word : tree.search(query, max_distance, 100)) {
+                found.push_back(word->get_text());
+            }
+            std::sort(found.begin(), found.end());
+            EXPECT_EQ(found, expected) << "query: " << query << ", k: " << max_distance;
+
+            std::vector<std::string> streamed;
+            for (const auto& word : tree.search_stream(query, max_distance)) {
+                streamed.push_back(word->get_text());
+            }
+            std::sort(streamed.begin(), streamed.end());
+            EXPECT_EQ(streamed, expected) << "query: " << query << ", k: " << max_distance;
+        }
+    }
+}
+
+TEST(BKTreeTest, MetricPoliciesMatchScan) {
+    std::vector<std::string> texts = {"the",  "then",    "they",   "tea",   "ten",  "receive",
+                                      "relieve", "deceive", "cat",  "cut",   "cast", "from",
+                                      "form",  "farm",    "foam",   "storm", "xy",   "xyzzy"};
+    expect_scan_results<Distance::Levenshtein>(texts);
+    expect_scan_results<Distance::Damerau>(texts);
+    expect_scan_results<Distance::Keyboard>(texts);
+}
+
+TEST(BKTreeTest, DamerauFindsTranspositions) {
+    BK::BasicTree<Distance::Damerau> tree;
+    for (const char* text : {"the", "then", "there", "other", "hte"}) {
+        tree.insert(std::make_shared<Word>(text));
+    }
+    auto results = tree.search("teh", 1, 10);
+    ASSERT_EQ(results.size(), 1);
+    EXPECT_EQ(results[0]->get_text(), "the");
+}
+
+TEST(BKTreeTest, IncrementalHeightMatchesAudit) {
+    std::vector<std::shared_ptr<Word>> words;
+    for (const char* text : {"book", "back", "boon", "cook", "look", "nook", "books", "bo"}) {
+        words.push_back(std::make_shared<Word>(text));
+    }
+    BK::Tree sequential, balanced;
+    EXPECT_EQ(sequential.get_height(), 0);
+    EXPECT_TRUE(sequential.audit());
+    for (const auto& word : words) {
+        sequential.insert(word);
+        EXPECT_TRUE(sequential.audit());
+    }
+    balanced.build(words);
+    EXPECT_TRUE(balanced.audit());
+
+    balanced.insert(std::make_shared<Word>("boot"));  // Extending a built tree
+    EXPECT_TRUE(balanced.audit());
+    size_t count = balanced.get_node_count();
+    // What the nodes need plus the allocator's rounding and headers
+    EXPECT_GE(balanced.get_memory_usage(), count * sizeof(BK::Node) + (count + 7) / 8);
+}
+
+TEST(BKTreeTest, RemoveLeavesTombstones) {
+    BK::Tree tree;
+    for (const char* text : {"book", "back", "boon", "cook", "look", "books"}) {
+        tree.insert(std::make_shared<Word>(text));
+    }
+    EXPECT_EQ(tree.remove("book"), 1);  // The root, its children stay reachable
+    EXPECT_EQ(tree.remove("book"), 0);
+    EXPECT_EQ(tree.remove("nook"), 0);
+    EXPECT_EQ(tree.get_node_count(), 6);
+    EXPECT_EQ(tree.get_tombstone_count(), 1);
+    EXPECT_TRUE(tree.audit());
+
+    auto results = tree.search("book", 1, 10);
+    std::vector<std::string> texts;
+    for (const auto& word : results) texts.push_back(word->get_text());
+    std::sort(texts.begin(), texts.end());
+    EXPECT_EQ(texts, (std::vector<std::string>{"books", "boon", "cook", "look"}));
+    for (const auto& word : tree.search_stream("book", 0)) {
+        ADD_FAILURE() << "tombstoned " << word->get_text() << " was reported";
+    }
+
+    tree.insert(std::make_shared<Word>("book"));  // Revives the node
+    EXPECT_EQ(tree.get_node_count(), 6);
+    EXPECT_EQ(tree.get_tombstone_count(), 0);
+    EXPECT_EQ(tree.search("book", 0, 10).size(), 1);
+    EXPECT_TRUE(tree.audit());
+}
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "compression.hpp"
+
+static std::string sample_text(int seed, size_t size) {
+    static const std::vector<std::string> parts = {
+        "a small domestic animal",  "of the family",       "that is kept as a pet",
+        "relating to or denoting",  "the quality of being", "in a manner that shows",
+        "a person who practises",   "the act or process of", "having the form of",
+        "any of a large group of",  "used to express",       "a piece of equipment for"};
+    std::mt19937 rng(seed);
+    std::string text;
+    while (text.size() < size) text += parts[rng() % parts.size()] + ". ";
+    return text;
+}
+
+TEST(CompressionTest, RoundTrip) {
+    Compression::Codec codec;
+    std::mt19937 rng(1);
+    std::string noise(3000, '\0');
+    for (char &c : noise) c = static_cast<char>(rng());
+    std::vector<std::string> inputs = {"", "abc", std::string(1000, 'x'), sample_text(2, 20000),
+                                       noise};
+    for (const std::string &input : inputs) {
+        std::string compressed, output;
+        codec.compress(input, compressed);
+        ASSERT_TRUE(codec.decompress(compressed, input.size(), output));
+        EXPECT_EQ(output, input);
+    }
+    std::string compressed;
+    codec.compress(std::string(1000, 'x'), compressed);
+    EXPECT_LT(compressed.size(), 20);  // One long overlapping match
+}
+
+TEST(CompressionTest, DictionaryShrinksSmallBlocks) {
+    std::string training = sample_text(3, 200000);
+    std::string dictionary = Compression::train({training}, 4096);
+    EXPECT_LE(dictionary.size(), 4096);
+    EXPECT_GE(dictionary.size(), 4000);
+
+    Compression::Codec plain, trained(dictionary);
+    std::string input = sample_text(4, 300);
+    std::string with, without, output;
+    plain.compress(input, without);
+    trained.compress(input, with);
+    EXPECT_LT(with.size(), without.size() / 2);
+    ASSERT_TRUE(trained.decompress(with, input.size(), output));
+    EXPECT_EQ(output, input);
+
+    // Less than the requested size of samples is kept whole
+    EXPECT_EQ(Compression::train({"short", " text"}, 4096), "short text");
+}
+
+TEST(CompressionTest, RejectsCorruptInput) {
+    Compression::Codec codec(sample_text(5, 2000));
+    std::string input = sample_text(6, 5000);
+    std::string compressed, output;
+    codec.compress(input, compressed);
+
+    EXPECT_FALSE(codec.decompress(compressed, input.size() - 1, output));
+    EXPECT_FALSE(codec.decompress(compressed, input.size() + 1, output));
+    EXPECT_FALSE(codec.decompress(std::string_view(compressed).substr(0, compressed.size() / 2),
+                                  input.size(), output));
+    // Offsets reaching before the dictionary
+    EXPECT_FALSE(codec.decompress(std::string("\x00\xFF\xFF", 3), 4, output));
+}
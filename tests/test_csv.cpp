@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "csv.hpp"
+
+using Records = std::vector<std::vector<std::string>>;
+
+static Records parse(std::string buffer) {
+    Records records;
+    Csv::Parser parser(buffer);
+    std::vector<std::string_view> fields;
+    while (parser.next(fields)) {
+        records.emplace_back(fields.begin(), fields.end());
+    }
+    return records;
+}
+
+// Byte by byte RFC 4180 state machine to check the block parser against
+static Records reference(const std::string &buffer) {
+    Records records;
+    if (buffer.empty()) return records;
+    std::vector<std::string> fields(1);
+    bool quoted = false;
+    bool ended = false;  // The last byte closed a record
+    for (size_t i = 0; i < buffer.size(); ++i) {
+        char c = buffer[i];
+        ended = false;
+        if (quoted) {
+            if (c != '"') {
+                fields.back() += c;
+            } else if (i + 1 < buffer.size() && buffer[i + 1] == '"') {
+                fields.back() += '"';
+                ++i;
+            } else {
+                quoted = false;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            fields.emplace_back();
+        } else if (c == '\n') {
+            records.push_back(fields);
+            fields.assign(1, "");
+            ended = true;
+        } else {
+            fields.back() += c;
+        }
+    }
+    if (ended == false) records.push_back(fields);  // Unterminated, or inside open quotes
+    return records;
+}
+
+TEST(CsvTest, SplitsFieldsAndRecords) {
+    EXPECT_EQ(parse("a,b,c\nd,,f\n"), (Records{{"a", "b", "c"}, {"d", "", "f"}}));
+    EXPECT_EQ(parse("a,b\r\nc,d"), (Records{{"a", "b"}, {"c", "d"}}));  // CRLF, no final newline
+    EXPECT_EQ(parse(""), Records{});
+    EXPECT_EQ(parse("\n"), Records{{""}});
+}
+
+TEST(CsvTest, QuotedFields) {
+    EXPECT_EQ(parse("cat,noun,\"A small, \"\"domestic\"\" animal.\"\n"),
+              (Records{{"cat", "noun", "A small, \"domestic\" animal."}}));
+    EXPECT_EQ(parse("\"two\nlines\",x\n"), (Records{{"two\nlines", "x"}}));
+    EXPECT_EQ(parse("\"\",\"\"\"\"\n"), (Records{{"", "\""}}));
+}
+
+TEST(CsvTest, QuotesSpanningBlocks) {
+    // A quoted field much longer than a block, with separators and escapes on both sides of
+    // every block boundary
+    std::string definition;
+    for (int i = 0; i < 40; ++i) {
+        definition += "part " + std::to_string(i) + ", \"\"quoted\"\"\n";
+    }
+    std::string buffer = "word,noun,\"" + definition + "\"\nnext,verb,plain\n";
+    Records records = parse(buffer);
+    ASSERT_EQ(records.size(), 2);
+    EXPECT_EQ(records, reference(buffer));
+    EXPECT_EQ(records[1], (std::vector<std::string>{"next", "verb", "plain"}));
+}
+
+TEST(CsvTest, AgreesWithReference) {
+    std::mt19937 rng(7);
+    const std::string alphabet = "ab,\"\n";
+    for (int round = 0; round < 500; ++round) {
+        std::string buffer;
+        size_t length = rng() % 300;
+        for (size_t i = 0; i < length; ++i) {
+            buffer += alphabet[rng() % alphabet.size()];
+        }
+        EXPECT_EQ(parse(buffer), reference(buffer)) << buffer;
+    }
+}
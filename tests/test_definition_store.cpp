@@ -0,0 +1,39 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "definition_store.hpp"
+
+TEST(DefinitionStoreTest, RoundTripAcrossBlocks) {
+    DefinitionStore store;
+    std::vector<std::vector<std::string>> entries;
+    for (int i = 0; i < 5000; ++i) {
+        std::vector<std::string> definitions;
+        for (int k = 0; k < i % 4; ++k) {
+            definitions.push_back("Definition " + std::to_string(k) + " of word number " +
+                                  std::to_string(i) + ", as found in the dictionary.");
+        }
+        EXPECT_EQ(store.add(definitions), i);
+        entries.push_back(definitions);
+    }
+    store.seal();
+
+    EXPECT_EQ(store.get_entry_count(), 5000);
+    EXPECT_GT(store.get_raw_size(), 16 * 1024 * 10);  // Spans many blocks
+    EXPECT_LT(store.get_compressed_size(), store.get_raw_size() / 2);
+    for (int i : {0, 1, 3, 2500, 4999, 1, 4998}) {
+        EXPECT_EQ(store.get(i), entries[i]);
+    }
+    for (size_t i = 0; i < entries.size(); ++i) {
+        ASSERT_EQ(store.get(static_cast<uint32_t>(i)), entries[i]);
+    }
+    EXPECT_TRUE(store.get(5000).empty());
+}
+
+TEST(DefinitionStoreTest, EmptyStore) {
+    DefinitionStore store;
+    store.seal();
+    EXPECT_EQ(store.get_entry_count(), 0);
+    EXPECT_TRUE(store.get(0).empty());
+}
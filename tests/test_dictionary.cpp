@@ -89,3 +89,297 @@ TEST(DictionaryTest, InvalidQueries) {
         EXPECT_TRUE(result.empty()) << "Expected empty for query: " << query;
     }
 }
+
+TEST(DictionaryTest, StreamResults) {
+    Dictionary dict;
+    for (const char *text : {"app", "apple", "application", "apply", "banana"}) {
+        dict.insert(std::make_shared<Word>(text));
+    }
+
+    auto stream = dict.stream("app_");
+    auto page = stream.take(2);
+    ASSERT_EQ(page.size(), 2);
+    EXPECT_EQ(page[0]->get_text(), "app");
+    EXPECT_EQ(page[1]->get_text(), "apple");
+    EXPECT_EQ(stream.take(10).size(), 2);
+
+    auto exact = dict.stream("banana").take(10);
+    ASSERT_EQ(exact.size(), 1);
+    EXPECT_EQ(exact[0]->get_text(), "banana");
+
+    EXPECT_FALSE(dict.stream("ca@t").next().has_value());
+}
+
+TEST(DictionaryTest, StreamOutlivesWideCompaction) {
+    Dictionary dict;
+    for (char c = 'a'; c <= 'z'; c++) {
+        dict.insert(std::make_shared<Word>(std::string("café") + c));
+    }
+    auto stream = dict.stream("cafézz");
+    ASSERT_TRUE(stream.next().has_value());
+
+    // Enough tombstones to rebuild the tree the stream is walking
+    for (char c = 'a'; c <= 'p'; c++) {
+        EXPECT_TRUE(dict.remove(std::string("café") + c));
+    }
+    for (const auto &word : stream.take(100)) {
+        EXPECT_EQ(word->get_text().compare(0, 5, "café"), 0);
+    }
+    EXPECT_TRUE(dict.audit());
+}
+
+TEST(DictionaryTest, CacheInvalidatedOnInsert) {
+    Dictionary dict;
+    dict.set_cache_capacity(16);
+    dict.insert(std::make_shared<Word>("cart"));
+
+    EXPECT_EQ(dict.search("car_").size(), 1);
+    EXPECT_EQ(dict.search("car_").size(), 1);
+    EXPECT_EQ(dict.get_cache()->get_hits(), 1);
+
+    dict.insert(std::make_shared<Word>("card"));
+    EXPECT_EQ(dict.search("car_").size(), 2);
+
+    dict.set_config(Config{2, 1, 5});  // Different limits use a different key
+    EXPECT_EQ(dict.search("car_").size(), 1);
+    EXPECT_EQ(dict.get_cache()->get_hits(), 1);
+}
+
+TEST(DictionaryTest, PhoneticFallback) {
+    Dictionary dict;
+    dict.insert(std::make_shared<Word>("phonetic"));
+    dict.insert(std::make_shared<Word>("photo"));
+    dict.insert(std::make_shared<Word>("tonic"));
+
+    // Five edits away from "phonetic", only the phonetic index can find it
+    auto results = dict.search("fonetik");
+    ASSERT_EQ(results.size(), 1);
+    EXPECT_EQ(results[0]->get_text(), "phonetic");
+
+    // Edit distance matches stay ahead of sound-alikes
+    dict.insert(std::make_shared<Word>("fonetic"));
+    results = dict.search("fonetik");
+    ASSERT_EQ(results.size(), 2);
+    EXPECT_EQ(results[0]->get_text(), "fonetic");
+    EXPECT_EQ(results[1]->get_text(), "phonetic");
+}
+
+TEST(DictionaryTest, StatisticsAndAudit) {
+    Dictionary dict;
+    for (const char *text : {"apple", "apply", "ape", "banana"}) {
+        EXPECT_TRUE(dict.insert(std::make_shared<Word>(text)));
+    }
+    EXPECT_FALSE(dict.insert(std::make_shared<Word>("apple2")));  // Not a letter
+
+    EXPECT_EQ(dict.get_word_count(), 4);
+    EXPECT_EQ(dict.get_trie_height(), 7);
+    EXPECT_GE(dict.get_bktree_height(), 2);
+    EXPECT_GT(dict.get_memory_usage(), 0);
+    EXPECT_TRUE(dict.audit());
+}
+
+TEST(DictionaryTest, RemoveAndUpdate) {
+    Dictionary dict;
+    dict.set_cache_capacity(16);
+    auto cart = std::make_shared<Word>("cart");
+    cart->add_pos(POS::Noun);
+    cart->add_definition("a small wagon");
+    dict.insert(cart);
+    dict.insert(std::make_shared<Word>("card"));
+    EXPECT_EQ(dict.search("car_").size(), 2);
+
+    EXPECT_TRUE(dict.update("cart", {{POS::Verb, "to carry"}, {POS::Noun, "a wagon"}}));
+    EXPECT_FALSE(dict.update("cat", {}));
+    auto results = dict.search("cart");
+    ASSERT_EQ(results.size(), 1);
+    EXPECT_EQ(results[0]->get_definition(), (std::vector<std::string>{"to carry", "a wagon"}));
+    EXPECT_EQ(results[0]->get_pos(), (std::vector<POS>{POS::Verb, POS::Noun}));
+
+    EXPECT_TRUE(dict.remove("cart"));
+    EXPECT_FALSE(dict.remove("cart"));
+    EXPECT_EQ(dict.search("car_").size(), 1);  // Not served from the cache
+    EXPECT_EQ(dict.search("cart").size(), 1);  // Fuzzy search finds "card" only
+    EXPECT_EQ(dict.search("cart")[0]->get_text(), "card");
+    EXPECT_EQ(dict.get_word_count(), 1);
+    EXPECT_TRUE(dict.audit());
+
+    EXPECT_TRUE(dict.insert(std::make_shared<Word>("cart")));  // Back again
+    EXPECT_EQ(dict.search("car_").size(), 2);
+    EXPECT_TRUE(dict.audit());
+}
+
+TEST(DictionaryTest, CompactionRebuildsTree) {
+    Dictionary dict;
+    std::vector<std::string> texts;
+    for (char a = 'a'; a <= 'z'; a++) {
+        for (char b = 'a'; b <= 'z'; b++) {
+            texts.push_back(std::string("qu") + a + b);
+            dict.insert(std::make_shared<Word>(texts.back()));
+        }
+    }
+    // Removing half of the words crosses the threshold at least once
+    for (size_t i = 0; i < texts.size(); i += 2) {
+        EXPECT_TRUE(dict.remove(texts[i]));
+        EXPECT_FALSE(dict.search(texts[i + 1]).empty());
+    }
+    dict.finish_compaction();
+    EXPECT_LT(dict.get_bktree_tombstone_count(), texts.size() / 2);  // Some were compacted away
+    EXPECT_EQ(dict.get_word_count(), static_cast<int>(texts.size() / 2));
+    EXPECT_TRUE(dict.audit());
+    for (size_t i = 0; i < texts.size(); i++) {
+        auto results = dict.search(texts[i]);
+        bool found = !results.empty() && results[0]->get_text() == texts[i];
+        EXPECT_EQ(found, i % 2 == 1) << texts[i];
+    }
+}
+
+TEST(DictionaryTest, ContainsThroughFilter) {
+    Dictionary dict;
+    for (int i = 0; i < 600; ++i) {
+        std::string text;
+        for (int n = i; n > 0 || text.empty(); n /= 26) text += static_cast<char>('a' + n % 26);
+        dict.insert(std::make_shared<Word>(text + "word"));
+    }
+    // The inserts went past the rebuild threshold, so most words are in the filter itself
+    EXPECT_GT(dict.get_filter().get_key_count(), 256);
+    EXPECT_TRUE(dict.contains("aword"));
+    EXPECT_TRUE(dict.contains("zword"));
+    EXPECT_FALSE(dict.contains("word"));
+    EXPECT_TRUE(dict.contains("Aword"));  // Queries are case folded
+
+    dict.insert(std::make_shared<Word>("fresh"));  // Not in the filter until the next rebuild
+    EXPECT_TRUE(dict.contains("fresh"));
+    EXPECT_EQ(dict.search("fresh").size(), 1);
+    dict.remove("aword");
+    EXPECT_FALSE(dict.contains("aword"));
+    EXPECT_TRUE(dict.audit());
+}
+
+TEST(DictionaryTest, ExactLookupAfterReinsert) {
+    Dictionary dict;
+    for (const char *text : {"apple", "banana", "cherry"}) {
+        dict.insert(std::make_shared<Word>(text));
+    }
+    for (int i = 0; i < 300; ++i) {
+        dict.insert(std::make_shared<Word>("filler" + std::string(1, 'a' + i % 26) +
+                                           std::string(1, 'a' + i / 26)));
+    }
+    // Rebuilt by now, so "banana" is found through the perfect hash
+    auto replacement = std::make_shared<Word>("banana");
+    replacement->add_definition("A long yellow fruit.");
+    dict.insert(replacement);
+    EXPECT_EQ(dict.search("banana").at(0), replacement);
+
+    dict.remove("cherry");
+    EXPECT_FALSE(dict.contains("cherry"));
+    auto again = std::make_shared<Word>("cherry");
+    dict.insert(again);
+    EXPECT_EQ(dict.search("cherry").at(0), again);
+    EXPECT_TRUE(dict.audit());
+}
+
+TEST(DictionaryTest, InsertSameTextTwice) {
+    Dictionary dict;
+    dict.insert(std::make_shared<Word>("apple"));
+    dict.insert(std::make_shared<Word>("café"));
+    auto apple = std::make_shared<Word>("apple");
+    apple->add_definition("A round fruit.");
+    auto cafe = std::make_shared<Word>("café");
+    EXPECT_TRUE(dict.insert(apple));
+    EXPECT_TRUE(dict.insert(cafe));
+    EXPECT_EQ(dict.get_word_count(), 2);
+
+    // One BK-tree node each, the replaced ones are tombstones
+    auto results = dict.search("appel");
+    ASSERT_EQ(results.size(), 1);
+    EXPECT_EQ(results[0], apple);
+    results = dict.search("cafe");
+    ASSERT_EQ(results.size(), 1);
+    EXPECT_EQ(results[0], cafe);
+    EXPECT_TRUE(dict.audit());
+
+    EXPECT_TRUE(dict.remove("apple"));
+    EXPECT_FALSE(dict.contains("apple"));
+    EXPECT_EQ(dict.get_word_count(), 1);
+    EXPECT_TRUE(dict.audit());
+}
+
+TEST(DictionaryTest, AccentedWords) {
+    Dictionary dict;
+    for (const char *text : {"cafe", "Café", "caffè", "naïve", "über", "cabin"}) {
+        EXPECT_TRUE(dict.insert(std::make_shared<Word>(text)));
+    }
+    EXPECT_FALSE(dict.insert(std::make_shared<Word>("caf\xC3")));  // Malformed UTF-8
+    EXPECT_FALSE(dict.insert(std::make_shared<Word>("café!")));
+
+    // Stored case folded and composed, so every spelling of a key finds it
+    EXPECT_TRUE(dict.contains("café"));
+    EXPECT_TRUE(dict.contains("CAFÉ"));
+    EXPECT_TRUE(dict.contains("cafe\xCC\x81"));  // "e" followed by a combining acute accent
+    EXPECT_TRUE(dict.contains("ÜBER"));
+    EXPECT_FALSE(dict.contains("uber"));
+
+    // One accent is one edit, whichever side is ASCII
+    auto results = dict.search("naive");
+    ASSERT_EQ(results.size(), 1);
+    EXPECT_EQ(results[0]->get_text(), "naïve");
+    results = dict.search("cabín");
+    ASSERT_FALSE(results.empty());
+    EXPECT_EQ(results[0]->get_text(), "cabin");
+
+    results = dict.search("caf_");
+    ASSERT_EQ(results.size(), 3);
+    EXPECT_EQ(results[0]->get_text(), "cafe");
+    EXPECT_EQ(results[1]->get_text(), "caffè");
+    EXPECT_EQ(results[2]->get_text(), "café");
+
+    // '?' stands for one letter, however many bytes it takes
+    results = dict.search("caf?");
+    ASSERT_EQ(results.size(), 2);
+    EXPECT_EQ(results[0]->get_text(), "cafe");
+    EXPECT_EQ(results[1]->get_text(), "café");
+
+    EXPECT_TRUE(dict.remove("CAFÉ"));
+    EXPECT_FALSE(dict.contains("café"));
+    EXPECT_TRUE(dict.audit());
+}
+
+TEST(DictionaryTest, CompressedDefinitions) {
+    Dictionary dict;
+    for (const std::string text : {"cat", "dog", "owl"}) {
+        auto word = std::make_shared<Word>(text);
+        word->add_pos(POS::Noun);
+        word->add_definition("A " + text + ", an animal.");
+        dict.insert(word);
+    }
+    dict.insert(std::make_shared<Word>("emu"));  // No definition, nothing to store
+    size_t before = dict.get_memory_breakdown().definitions;
+    dict.compress_definitions();
+
+    std::shared_ptr<Word> cat = dict.search("cat")[0];
+    ASSERT_NE(cat->get_store(), nullptr);
+    EXPECT_EQ(cat->get_store(), dict.search("owl")[0]->get_store());
+    EXPECT_EQ(dict.search("emu")[0]->get_store(), nullptr);
+    EXPECT_EQ(cat->get_definition(), std::vector<std::string>{"A cat, an animal."});
+    EXPECT_TRUE(cat->has_definition());
+    EXPECT_NE(dict.get_memory_breakdown().definitions, before);
+
+    // Changed words leave the store
+    cat->add_pos(POS::Verb);
+    cat->add_definition("To vomit.");
+    EXPECT_EQ(cat->get_store(), nullptr);
+    EXPECT_EQ(cat->get_definition(),
+              (std::vector<std::string>{"A cat, an animal.", "To vomit."}));
+    // Changed behind the dictionary's back, so its running memory figure is off until the next
+    // breakdown recounts it
+    EXPECT_FALSE(dict.audit());
+    size_t total = dict.get_memory_breakdown().total();
+    EXPECT_EQ(dict.get_memory_usage(), total);
+    EXPECT_TRUE(dict.audit());
+    ASSERT_TRUE(dict.update("dog", {{POS::Verb, "To follow."}}));
+    EXPECT_EQ(dict.search("dog")[0]->get_store(), nullptr);
+    EXPECT_EQ(dict.search("dog")[0]->get_definition(), std::vector<std::string>{"To follow."});
+    EXPECT_EQ(dict.search("owl")[0]->get_definition(),
+              std::vector<std::string>{"A owl, an animal."});
+    EXPECT_TRUE(dict.audit());
+}
@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "dictionary.hpp"
+#include "dictionary_set.hpp"
+#include "interner.hpp"
+#include "temp_path.hpp"
+
+class DictionarySetTest : public ::testing::Test {
+   protected:
+    std::string prefix = temp_path("dictionary_set_test");
+    std::vector<std::string> paths;
+
+    // Every row is (text, definition)
+    std::string write(const std::vector<std::pair<std::string, std::string>> &rows) {
+        std::string path = prefix + "_" + std::to_string(paths.size()) + ".csv";
+        std::ofstream file(path, std::ios::trunc);
+        file << "text,pos,definition\n";
+        for (const auto &[text, definition] : rows) {
+            file << text << ",noun,\"" << definition << "\"\n";
+        }
+        paths.push_back(path);
+        return path;
+    }
+
+    static std::vector<std::string> texts(const std::vector<std::shared_ptr<Word>> &words) {
+        std::vector<std::string> result;
+        for (const auto &word : words) {
+            result.push_back(word->get_text());
+        }
+        return result;
+    }
+
+    void TearDown() override {
+        for (const std::string &path : paths) {
+            unlink(path.c_str());
+        }
+    }
+};
+
+TEST_F(DictionarySetTest, ExactHitFromEarliestDictionary) {
+    std::string first = write({{"cat", "A pet."}, {"dog", "A pet."}});
+    std::string second = write({{"cat", "A lion, loosely."}, {"owl", "A bird."}});
+    DictionarySet set;
+    ASSERT_TRUE(set.load({first, second}));
+    EXPECT_EQ(set.get_dictionary_count(), 2);
+
+    auto results = set.search("cat");
+    ASSERT_EQ(results.size(), 1);
+    EXPECT_EQ(results[0]->get_definition().at(0), "A pet.");
+
+    // Found only in the second dictionary
+    results = set.search("owl");
+    ASSERT_EQ(results.size(), 1);
+    EXPECT_EQ(results[0]->get_text(), "owl");
+}
+
+TEST_F(DictionarySetTest, MergesRankedWithoutDuplicates) {
+    std::string first = write({{"bat", "x"}, {"cart", "x"}, {"apple", "x"}, {"apply", "x"}});
+    std::string second = write({{"cot", "x"}, {"bat", "y"}, {"applet", "x"}, {"apple", "y"}});
+    DictionarySet set;
+    set.set_config(Config{2, 3, 5});
+    ASSERT_TRUE(set.load({first, second}, false));
+
+    // Distance one before distance two, alphabetical within a distance, across dictionaries
+    EXPECT_EQ(texts(set.search("cat")), (std::vector<std::string>{"bat", "cart", "cot"}));
+
+    // Suggestions merge in alphabetical order, "apple" appears once
+    EXPECT_EQ(texts(set.search("appl_")),
+              (std::vector<std::string>{"apple", "applet", "apply"}));
+    EXPECT_EQ(texts(set.search("appl_", "apple")),
+              (std::vector<std::string>{"applet", "apply"}));
+
+    EXPECT_EQ(texts(set.search("?at")), (std::vector<std::string>{"bat"}));
+    EXPECT_TRUE(set.search("c_*").empty());
+}
+
+TEST_F(DictionarySetTest, SharesIdenticalWords) {
+    std::string first = write({{"cat", "A pet."}, {"dog", "A pet."}});
+    std::string second = write({{"cat", "A pet."}, {"dog", "A wolf, tamed."}, {"owl", "A bird."}});
+    DictionarySet set;
+    ASSERT_TRUE(set.load({first, second}));
+
+    // "cat" is stored once, the two "dog" entries differ and stay apart
+    EXPECT_EQ(set.get_interner().get_shared_count(), 1);
+    EXPECT_EQ(set.get_word_count(), 3);
+    EXPECT_EQ(set.get_dictionary(0).search("cat")[0], set.get_dictionary(1).search("cat")[0]);
+    EXPECT_NE(set.get_dictionary(0).search("dog")[0], set.get_dictionary(1).search("dog")[0]);
+    EXPECT_TRUE(set.audit());
+
+    // The shared "cat" is measured once
+    size_t words = set.get_dictionary(0).get_memory_breakdown().words +
+                   set.get_dictionary(1).get_memory_breakdown().words;
+    EXPECT_LT(set.get_memory_breakdown().words - set.get_interner().get_memory_usage(), words);
+}
+
+TEST_F(DictionarySetTest, KeepsLoadableFiles) {
+    std::string first = write({{"cat", "A pet."}});
+    DictionarySet set;
+    EXPECT_FALSE(set.load({prefix + "_missing.csv", first}));
+    ASSERT_EQ(set.get_dictionary_count(), 1);
+    EXPECT_EQ(set.get_filepath(0), first);
+    EXPECT_EQ(set.search("cat").size(), 1);
+}
+
+TEST_F(DictionarySetTest, CountsOnlyStoredWords) {
+    std::string first = write({{"cat", "A pet."},
+                               {"according to", "As stated by."},
+                               {"film-maker", "One who makes films."}});
+    std::string second = write({{"decision-making", "Making decisions."}, {"owl", "A bird."}});
+    DictionarySet set;
+    ASSERT_TRUE(set.load({first, second}));
+    EXPECT_EQ(set.get_word_count(), 2);
+}
+
+TEST(InternerTest, PoolsFirstWordPerText) {
+    Interner interner(4);
+    auto cat = std::make_shared<Word>("cat");
+    cat->add_definition("A pet.");
+    auto twin = std::make_shared<Word>("cat");
+    twin->add_definition("A pet.");
+    auto other = std::make_shared<Word>("cat");
+    other->add_definition("A lion, loosely.");
+
+    EXPECT_EQ(interner.intern(cat), cat);
+    EXPECT_EQ(interner.intern(twin), cat);
+    EXPECT_EQ(interner.intern(other), other);
+    EXPECT_EQ(interner.get_word_count(), 1);
+    EXPECT_EQ(interner.get_shared_count(), 1);
+}
+
+TEST(DictionaryTest, LoadsPlainWordList) {
+    std::string path = temp_path("dictionary_words") + ".txt";
+    {
+        std::ofstream file(path, std::ios::trunc);
+        file << "text\napple\nbanana\n";
+    }
+    Dictionary dict;
+    ASSERT_TRUE(dict.load(path));
+    unlink(path.c_str());
+    EXPECT_EQ(dict.get_word_count(), 3);  // Single column, so "text" is a word too
+    EXPECT_EQ(dict.search("banana").size(), 1);
+}
@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "distance.hpp"
+
+// Plain full-matrix reference distance
+static int reference(const std::string& a, const std::string& b) {
+    std::vector<std::vector<int>> dp(a.size() + 1, std::vector<int>(b.size() + 1));
+    for (size_t i = 0; i <= a.size(); ++i) dp[i][0] = i;
+    for (size_t j = 0; j <= b.size(); ++j) dp[0][j] = j;
+    for (size_t i = 1; i <= a.size(); ++i) {
+        for (size_t j = 1; j <= b.size(); ++j) {
+            int cost = (a[i - 1] == b[j - 1]) ? 0 : 1;
+            dp[i][j] = std::min({dp[i - 1][j] + 1, dp[i][j - 1] + 1, dp[i - 1][j - 1] + cost});
+        }
+    }
+    return dp[a.size()][b.size()];
+}
+
+TEST(DistanceTest, LevenshteinKnownValues) {
+    EXPECT_EQ(Distance::levenshtein("kitten", "sitting"), 3);
+    EXPECT_EQ(Distance::levenshtein("", "abc"), 3);
+    EXPECT_EQ(Distance::levenshtein("abc", ""), 3);
+    EXPECT_EQ(Distance::levenshtein("same", "same"), 0);
+    EXPECT_EQ(Distance::levenshtein("teh", "the"), 2);
+}
+
+TEST(DistanceTest, LevenshteinMatchesReference) {
+    // Short and long words cover both the bit-parallel and the row by row paths
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> letter('a', 'd');
+    for (int length : {1, 5, 63, 64, 65, 100}) {
+        for (int round = 0; round < 20; ++round) {
+            std::string a, b;
+            for (int i = 0; i < length; ++i) a += static_cast<char>(letter(rng));
+            for (int i = 0; i < length + round % 7 - 3; ++i) b += static_cast<char>(letter(rng));
+            EXPECT_EQ(Distance::levenshtein(a, b), reference(a, b)) << a << " / " << b;
+        }
+    }
+}
+
+TEST(DistanceTest, DamerauCountsTranspositions) {
+    EXPECT_EQ(Distance::damerau("teh", "the"), 1);
+    EXPECT_EQ(Distance::damerau("recieve", "receive"), 1);
+    EXPECT_EQ(Distance::damerau("kitten", "sitting"), 3);
+    // Optimal string alignment edits no substring twice, hence not a metric
+    EXPECT_EQ(Distance::damerau("ca", "abc"), 3);
+    EXPECT_FALSE(Distance::Damerau::is_metric);
+}
+
+TEST(DistanceTest, KeyboardPrefersNeighbours) {
+    EXPECT_TRUE(Distance::is_adjacent('a', 's'));
+    EXPECT_TRUE(Distance::is_adjacent('f', 'v'));
+    EXPECT_FALSE(Distance::is_adjacent('a', 'p'));
+
+    EXPECT_EQ(Distance::keyboard("cat", "cat"), 0);
+    EXPECT_EQ(Distance::keyboard("cat", "cst"), 1);  // 's' is next to 'a'
+    EXPECT_EQ(Distance::keyboard("cat", "cpt"), 2);
+    EXPECT_EQ(Distance::keyboard("cat", "cart"), Distance::Keyboard::unit);
+    EXPECT_EQ(Distance::keyboard("cart", "cat"), Distance::keyboard("cat", "cart"));
+}
+
+TEST(DistanceTest, UnicodeCountsCodePoints) {
+    EXPECT_EQ(Distance::unicode("café", "cafe"), 1);
+    EXPECT_EQ(Distance::levenshtein("café", "cafe"), 2);  // Two bytes against one
+    EXPECT_EQ(Distance::unicode("naïve", "naïve"), 0);
+    EXPECT_EQ(Distance::unicode("über", "uber"), 1);
+    EXPECT_EQ(Distance::unicode("кошка", "мошка"), 1);
+    EXPECT_EQ(Distance::unicode("kitten", "sitting"), 3);  // ASCII takes the byte path
+}
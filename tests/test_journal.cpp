@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "dictionary.hpp"
+#include "journal.hpp"
+#include "temp_path.hpp"
+
+class JournalTest : public ::testing::Test {
+   protected:
+    std::string prefix = temp_path("journal_test");
+    std::string log_path = prefix + ".journal";
+    std::string base_path = prefix + ".csv";
+
+    void SetUp() override {
+        std::ofstream(log_path, std::ios::trunc).close();
+        std::ofstream base(base_path, std::ios::trunc);
+        base << "text,pos,definition\n";
+        base << "cat,noun,\"A small \"\"domestic\"\" animal.\"\n";
+        base << "dog,noun,\"A loyal animal.\"\n";
+    }
+
+    void TearDown() override {
+        unlink(log_path.c_str());
+        unlink(base_path.c_str());
+    }
+
+    std::vector<Journal::Record> replay() {
+        std::vector<Journal::Record> records;
+        Journal::Log log;
+        EXPECT_TRUE(log.open(log_path));
+        log.replay([&](const Journal::Record &record) { records.push_back(record); });
+        return records;
+    }
+};
+
+TEST(JournalFormatTest, Crc32) {
+    EXPECT_EQ(Journal::crc32(""), 0u);
+    EXPECT_EQ(Journal::crc32("123456789"), 0xCBF43926u);
+}
+
+TEST(JournalFormatTest, EncodeRoundTrip) {
+    Journal::Record record{Journal::Op::Update, "cat", {{POS::Noun, "pet"}, {POS::Verb, ""}}};
+    std::string data;
+    Journal::encode(record, data);
+
+    Journal::Record decoded;
+    ASSERT_TRUE(Journal::decode(std::string_view(data).substr(8), decoded));
+    EXPECT_EQ(decoded.op, Journal::Op::Update);
+    EXPECT_EQ(decoded.text, "cat");
+    EXPECT_EQ(decoded.definitions, record.definitions);
+
+    // Truncated payloads and unknown ops are rejected
+    EXPECT_FALSE(Journal::decode(std::string_view(data).substr(8, data.size() - 9), decoded));
+    data[8] = 9;
+    EXPECT_FALSE(Journal::decode(std::string_view(data).substr(8), decoded));
+}
+
+TEST_F(JournalTest, ReplayStopsAtTornRecord) {
+    {
+        Journal::Log log;
+        ASSERT_TRUE(log.open(log_path));
+        EXPECT_TRUE(log.append({Journal::Op::Insert, "cow", {{POS::Noun, "moo"}}}));
+        EXPECT_TRUE(log.append({Journal::Op::Remove, "dog", {}}));
+    }
+    std::string torn("\x20\x00\x00\x00\x00\x00\x00\x00garbage", 15);  // Shorter than it says
+    std::ofstream(log_path, std::ios::app | std::ios::binary) << torn;
+
+    std::vector<Journal::Record> records = replay();
+    ASSERT_EQ(records.size(), 2);
+    EXPECT_EQ(records[0].text, "cow");
+    EXPECT_EQ(records[1].op, Journal::Op::Remove);
+
+    // The tail was cut off, so records appended now are found by the next replay
+    {
+        Journal::Log log;
+        ASSERT_TRUE(log.open(log_path));
+        EXPECT_TRUE(log.append({Journal::Op::Remove, "cow", {}}));
+    }
+    EXPECT_EQ(replay().size(), 3);
+
+    // A flipped bit fails the checksum, nothing from there on is trusted
+    std::fstream file(log_path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(9);
+    file.put('X');
+    file.close();
+    EXPECT_TRUE(replay().empty());
+}
+
+TEST_F(JournalTest, GroupCommit) {
+    Journal::Log log;
+    ASSERT_TRUE(log.open(log_path));
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < 50; ++i) {
+                std::string text = std::string(1, 'a' + t) + std::to_string(i);
+                EXPECT_TRUE(log.append({Journal::Op::Remove, text, {}}));
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(log.get_record_count(), 400);
+    EXPECT_LE(log.get_sync_count(), 400);
+    EXPECT_EQ(replay().size(), 400);
+}
+
+TEST_F(JournalTest, DictionaryReplaysChanges) {
+    {
+        Dictionary dict(base_path);
+        ASSERT_TRUE(dict.open_journal(log_path, base_path));
+        auto cow = std::make_shared<Word>("cow");
+        cow->add_pos(POS::Noun);
+        cow->add_definition("Says moo.");
+        EXPECT_TRUE(dict.insert(cow));
+        EXPECT_TRUE(dict.update("cat", {{POS::Verb, "To vomit."}}));
+        EXPECT_TRUE(dict.remove("dog"));
+    }
+    // A restart loads the untouched base file and replays the log over it
+    Dictionary dict(base_path);
+    ASSERT_TRUE(dict.open_journal(log_path, base_path));
+    EXPECT_EQ(dict.get_journal()->get_replay_count(), 3);
+    EXPECT_EQ(dict.get_word_count(), 2);
+    EXPECT_EQ(dict.search("cow")[0]->get_definition(), std::vector<std::string>{"Says moo."});
+    EXPECT_EQ(dict.search("cat")[0]->get_pos(), std::vector<POS>{POS::Verb});
+    for (const auto &word : dict.search("dog")) {
+        EXPECT_NE(word->get_text(), "dog");
+    }
+    EXPECT_TRUE(dict.audit());
+}
+
+TEST_F(JournalTest, CheckpointFoldsLogIntoBase) {
+    {
+        Dictionary dict(base_path);
+        ASSERT_TRUE(dict.open_journal(log_path, base_path, 1));  // Every write checkpoints
+        EXPECT_TRUE(dict.insert(std::make_shared<Word>("cow")));  // No definitions at all
+        EXPECT_TRUE(dict.remove("dog"));
+        EXPECT_EQ(dict.get_journal()->get_size(), 0);
+    }
+    Dictionary dict(base_path);
+    EXPECT_EQ(dict.get_word_count(), 2);
+    EXPECT_TRUE(dict.search("cow")[0]->get_definition().empty());
+    EXPECT_EQ(dict.search("cat")[0]->get_definition(),
+              std::vector<std::string>{"A small \"domestic\" animal."});
+
+    // Replaying a log the checkpoint already holds changes nothing
+    {
+        Journal::Log log;
+        ASSERT_TRUE(log.open(log_path));
+        EXPECT_TRUE(log.append({Journal::Op::Insert, "cow", {}}));
+        EXPECT_TRUE(log.append({Journal::Op::Remove, "dog", {}}));
+    }
+    ASSERT_TRUE(dict.open_journal(log_path, base_path));
+    EXPECT_EQ(dict.get_word_count(), 2);
+    EXPECT_TRUE(dict.audit());
+}
@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "dictionary.hpp"
+#include "language_model.hpp"
+#include "temp_path.hpp"
+
+class LanguageModelTest : public ::testing::Test {
+   protected:
+    std::string path = temp_path("language_model_test") + ".lm";
+
+    void SetUp() override {
+        Language::Builder builder;
+        for (int i = 0; i < 20; ++i) {
+            builder.add("I came from home. She ran from the house. A letter from a friend.\n");
+            builder.add("Fill in the form. The form was long! What form does it take?\n");
+        }
+        builder.add("A single odd sentence.");
+        ASSERT_TRUE(builder.write(path));
+    }
+
+    void TearDown() override { unlink(path.c_str()); }
+};
+
+TEST(LanguageTest, SplitsSentences) {
+    auto sentences = Language::split("Hello, World! Don't\n\nstop CAFÉ now.");
+    ASSERT_EQ(sentences.size(), 3);
+    EXPECT_EQ(sentences[0], (std::vector<std::string>{"hello", "world"}));
+    EXPECT_EQ(sentences[1], (std::vector<std::string>{"don", "t"}));
+    EXPECT_EQ(sentences[2], (std::vector<std::string>{"stop", "café", "now"}));
+    EXPECT_TRUE(Language::split(" ... \n").empty());
+}
+
+TEST_F(LanguageModelTest, ScoresPairsAboveTheirWords) {
+    Language::Model model;
+    ASSERT_TRUE(model.open(path));
+    EXPECT_EQ(model.lookup("odd"), Language::Model::UNKNOWN);  // Seen once, pruned
+    EXPECT_EQ(model.lookup("nothing"), Language::Model::UNKNOWN);
+    ASSERT_NE(model.lookup("from"), Language::Model::UNKNOWN);
+
+    // Seen pairs beat the same word after another context, unknown words come last
+    EXPECT_GT(model.score("came", "from"), model.score("came", "form"));
+    EXPECT_GT(model.score("the", "form"), model.score("the", "from"));
+    EXPECT_GT(model.score("", "fill"), model.score("", "form"));
+    EXPECT_GT(model.score("came", "form"), model.score("came", "nothing"));
+    EXPECT_LT(model.score("came", "from"), 0.0);
+}
+
+TEST_F(LanguageModelTest, RanksCandidatesBySentence) {
+    Language::Model model;
+    ASSERT_TRUE(model.open(path));
+    std::vector<std::vector<Language::Candidate>> sentence = {
+        {{"i", 0.0}}, {{"came", 0.0}}, {{"form", 0.0}, {"from", 0.0}}, {{"home", 0.0}}};
+    auto scores = model.score(sentence);
+    ASSERT_EQ(scores.size(), 4);
+    ASSERT_EQ(scores[2].size(), 2);
+    EXPECT_GT(scores[2][1], scores[2][0]);
+    EXPECT_DOUBLE_EQ(scores[0][0], scores[2][1]);  // Both on the best reading
+
+    // A large enough penalty overrides the context
+    sentence[2][1].penalty = -10.0;
+    scores = model.score(sentence);
+    EXPECT_GT(scores[2][0], scores[2][1]);
+}
+
+TEST_F(LanguageModelTest, RejectsOtherFiles) {
+    Language::Model model;
+    EXPECT_FALSE(model.open(path + ".missing"));
+    {
+        std::ifstream fin(path, std::ios::binary);
+        std::string data((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+        std::ofstream fout(path, std::ios::binary | std::ios::trunc);
+        fout << data.substr(0, data.size() - 1);  // Truncated
+    }
+    EXPECT_FALSE(model.open(path));
+    EXPECT_FALSE(model.is_open());
+    EXPECT_EQ(model.lookup("from"), Language::Model::UNKNOWN);
+}
+
+TEST_F(LanguageModelTest, RejectsDamagedFiles) {
+    std::string data;
+    {
+        std::ifstream fin(path, std::ios::binary);
+        data.assign(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+    }
+    // Header of 40 bytes with the word and slot counts at 8 and 12, see language_model.cpp
+    uint32_t word_count = 0, slot_count = 0;
+    std::memcpy(&word_count, data.data() + 8, sizeof(word_count));
+    std::memcpy(&slot_count, data.data() + 12, sizeof(slot_count));
+    size_t offsets = 40 + word_count * sizeof(uint64_t) + slot_count * sizeof(uint32_t);
+    size_t followers = offsets + (word_count + 1) * sizeof(uint32_t);
+    auto open_with = [&](size_t position, uint32_t value) {
+        std::string damaged = data;
+        std::memcpy(damaged.data() + position, &value, sizeof(value));
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << damaged;
+        Language::Model model;
+        return model.open(path);
+    };
+    EXPECT_TRUE(open_with(followers, 0));
+    EXPECT_FALSE(open_with(followers, word_count));  // Follower outside the vocabulary
+    EXPECT_FALSE(open_with(offsets + sizeof(uint32_t), UINT32_MAX));  // Offsets going back
+}
+
+TEST_F(LanguageModelTest, DictionaryCorrectsInContext) {
+    Dictionary dict;
+    for (const std::string text : {"i", "came", "form", "from", "home", "the", "fill"}) {
+        dict.insert(std::make_shared<Word>(text));
+    }
+    // "frm" is one edit from both, alphabetical order puts "form" first without context
+    auto corrections = dict.correct({"i", "came", "frm", "home"});
+    ASSERT_EQ(corrections.size(), 4);
+    ASSERT_GE(corrections[2].size(), 2);
+    EXPECT_EQ(corrections[2][0]->get_text(), "form");
+    EXPECT_EQ(corrections[1][0]->get_text(), "came");
+
+    auto model = std::make_shared<Language::Model>();
+    ASSERT_TRUE(model->open(path));
+    dict.set_language_model(model);
+    corrections = dict.correct({"i", "came", "frm", "home"});
+    EXPECT_EQ(corrections[2][0]->get_text(), "from");
+    corrections = dict.correct({"fill", "the", "frm", "?"});
+    EXPECT_EQ(corrections[2][0]->get_text(), "form");
+    EXPECT_TRUE(corrections[3].empty());  // Not a word
+}
@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "dictionary.hpp"
+#include "memory.hpp"
+#include "word.hpp"
+
+TEST(MemoryTest, BlocksCoverTheRequest) {
+    for (size_t size : {1, 24, 100, 4096}) {
+        auto block = std::make_unique<char[]>(size);
+        EXPECT_GE(Memory::block_size(block.get(), size), size);
+        EXPECT_GE(Memory::estimate(size), size);
+    }
+    EXPECT_EQ(Memory::estimate(24), 32);
+    EXPECT_EQ(Memory::estimate(25), 48);
+}
+
+TEST(MemoryTest, StringsAndVectors) {
+    EXPECT_EQ(Memory::of(std::string("short")), 0);  // Inline buffer
+    std::string text(100, 'x');
+    EXPECT_GE(Memory::of(text), 101);
+
+    std::vector<int> numbers;
+    EXPECT_EQ(Memory::of(numbers), 0);
+    numbers.reserve(50);
+    EXPECT_GE(Memory::of(numbers), 50 * sizeof(int));
+
+    std::unordered_set<int> set = {1, 2, 3};
+    EXPECT_GE(Memory::of_hashed(set, false), 3 * (sizeof(void *) + sizeof(int)));
+}
+
+TEST(MemoryTest, DictionaryBreakdown) {
+    Dictionary dict;
+    auto word = std::make_shared<Word>("apple");
+    dict.insert(word);
+    Memory::Usage before = dict.get_memory_breakdown();
+    EXPECT_GT(before.trie, 0);
+    EXPECT_GT(before.bktree, 0);
+    EXPECT_GT(before.words, 0);
+    EXPECT_EQ(before.cache, 0);
+    EXPECT_EQ(before.total(), dict.get_memory_usage());
+
+    dict.update("apple", {{POS::Noun, std::string(200, 'd')}});
+    Memory::Usage after = dict.get_memory_breakdown();
+    EXPECT_GE(after.definitions, before.definitions + 200);
+    EXPECT_EQ(after.trie, before.trie);
+
+    // Words already counted elsewhere are left out
+    std::unordered_set<const Word *> counted = {word.get()};
+    EXPECT_LT(dict.get_memory_breakdown(&counted).words, after.words);
+}
+
+TEST(MemoryTest, MaintainedUsageMatchesBreakdown) {
+    Dictionary dict;
+    auto same = [&dict] { return dict.get_memory_usage() == dict.get_memory_breakdown().total(); };
+    for (const std::string text : {"apple", "apply", "ample", "café", "naïve"}) {
+        auto word = std::make_shared<Word>(text);
+        word->add_definition("A definition of " + text + " long enough to leave the buffer.");
+        dict.insert(word);
+    }
+    EXPECT_TRUE(same());
+    dict.insert(std::make_shared<Word>("apple"));  // Replaces the first one
+    EXPECT_TRUE(same());
+    dict.update("apply", {{POS::Verb, std::string(300, 'd')}});
+    EXPECT_TRUE(same());
+    dict.remove("ample");
+    dict.remove("café");
+    EXPECT_TRUE(same());
+    dict.compress_definitions();
+    EXPECT_TRUE(same());
+    EXPECT_TRUE(dict.audit());
+}
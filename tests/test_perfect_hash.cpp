@@ -0,0 +1,41 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "perfect_hash.hpp"
+
+TEST(PerfectHashTest, MapsKeysOntoDistinctSlots) {
+    for (size_t count : {1, 2, 3, 64, 1000, 50000}) {
+        std::mt19937_64 rng(count);
+        std::vector<uint64_t> keys(count);
+        for (uint64_t &key : keys) key = rng();
+
+        PerfectHash::Function function;
+        function.build(keys);
+        ASSERT_EQ(function.get_key_count(), count);
+        std::vector<bool> seen(count, false);
+        for (uint64_t key : keys) {
+            size_t slot = function.lookup(key);
+            ASSERT_LT(slot, count);
+            ASSERT_FALSE(seen[slot]) << count << " keys";
+            seen[slot] = true;
+        }
+    }
+}
+
+TEST(PerfectHashTest, KeysSharingLowBits) {
+    // Equal modulo every power of two table size below 2^20
+    std::vector<uint64_t> keys;
+    for (uint64_t i = 0; i < 1024; ++i) keys.push_back(i << 20);
+    PerfectHash::Function function;
+    function.build(keys);
+    std::vector<bool> seen(keys.size(), false);
+    for (uint64_t key : keys) {
+        size_t slot = function.lookup(key);
+        ASSERT_FALSE(seen[slot]);
+        seen[slot] = true;
+    }
+    EXPECT_LE(function.get_memory_usage(), keys.size() * 2);  // About a byte per key
+}
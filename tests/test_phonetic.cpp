@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "phonetic.hpp"
+
+TEST(PhoneticTest, SoundAlikesShareKeys) {
+    EXPECT_EQ(Phonetic::encode("fonetik"), Phonetic::encode("phonetic"));
+    EXPECT_EQ(Phonetic::encode("knight"), Phonetic::encode("nite"));
+    EXPECT_EQ(Phonetic::encode("Smith"), Phonetic::encode("smyth"));
+    EXPECT_EQ(Phonetic::encode("kat"), Phonetic::encode("cat"));
+    EXPECT_EQ(Phonetic::encode("sity"), Phonetic::encode("city"));
+}
+
+TEST(PhoneticTest, DifferentSoundsDiffer) {
+    EXPECT_NE(Phonetic::encode("cat"), Phonetic::encode("bat"));
+    EXPECT_NE(Phonetic::encode("ship"), Phonetic::encode("sip"));
+    EXPECT_NE(Phonetic::encode("apple"), Phonetic::encode("pple"));  // Leading vowel kept
+    EXPECT_EQ(Phonetic::encode(""), 0);
+}
+
+TEST(PhoneticTest, LongWordsAreTruncated) {
+    EXPECT_EQ(Phonetic::encode("bbbbbbbbbbbbbbbbbbbbbbbb"), Phonetic::encode("b"));
+    EXPECT_EQ(Phonetic::encode("pneumonoultramicroscopic"),
+              Phonetic::encode("pneumonoultramicroscopicsilicovolcanoconiosis"));
+}
+
+TEST(PhoneticTest, IndexLookup) {
+    Phonetic::Index index;
+    index.insert("phonetic", 0);
+    index.insert("photo", 1);
+    index.insert("fonetic", 2);
+    index.insert("Ωμέγα", 3);  // No sound, not indexed
+
+    EXPECT_EQ(index.lookup("fonetik"), (std::vector<uint32_t>{0, 2}));
+    EXPECT_TRUE(index.lookup("zebra").empty());
+    EXPECT_TRUE(index.lookup("Ωμέγα").empty());
+    EXPECT_EQ(index.get_key_count(), 2);
+    EXPECT_GT(index.get_memory_usage(), 0);
+}
+
+TEST(PhoneticTest, IndexRemove) {
+    Phonetic::Index index;
+    index.insert("phonetic", 0);
+    index.insert("fonetic", 1);
+
+    index.remove("phonetic", 0);
+    EXPECT_EQ(index.lookup("fonetik"), (std::vector<uint32_t>{1}));
+    index.remove("fonetic", 1);
+    EXPECT_TRUE(index.lookup("fonetik").empty());
+    EXPECT_EQ(index.get_key_count(), 0);
+}
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "query_cache.hpp"
+#include "word.hpp"
+
+TEST(QueryCacheTest, HitAndMiss) {
+    QueryCache cache(4, 1);
+    std::vector<std::shared_ptr<Word>> results;
+
+    EXPECT_FALSE(cache.get("cat", results));
+    cache.put("cat", {std::make_shared<Word>("cat")});
+
+    ASSERT_TRUE(cache.get("cat", results));
+    ASSERT_EQ(results.size(), 1);
+    EXPECT_EQ(results[0]->get_text(), "cat");
+
+    EXPECT_EQ(cache.get_hits(), 1);
+    EXPECT_EQ(cache.get_misses(), 1);
+    EXPECT_DOUBLE_EQ(cache.get_hit_ratio(), 0.5);
+}
+
+TEST(QueryCacheTest, EvictsLeastRecentlyUsed) {
+    QueryCache cache(2, 1);
+    std::vector<std::shared_ptr<Word>> results;
+
+    cache.put("a", {});
+    cache.put("b", {});
+    EXPECT_TRUE(cache.get("a", results));  // "b" is now the oldest
+    cache.put("c", {});
+
+    EXPECT_EQ(cache.get_size(), 2);
+    EXPECT_TRUE(cache.get("a", results));
+    EXPECT_FALSE(cache.get("b", results));
+    EXPECT_TRUE(cache.get("c", results));
+
+    cache.clear();
+    EXPECT_EQ(cache.get_size(), 0);
+}
+
+TEST(QueryCacheTest, ConcurrentAccess) {
+    QueryCache cache(64);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&cache, t]() {
+            std::vector<std::shared_ptr<Word>> results;
+            for (int i = 0; i < 1000; ++i) {
+                std::string key = std::to_string((i * 7 + t) % 100);
+                if (cache.get(key, results) == false) {
+                    cache.put(key, {std::make_shared<Word>(key)});
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(cache.get_hits() + cache.get_misses(), 4000);
+    EXPECT_LE(cache.get_size(), cache.get_capacity());
+}
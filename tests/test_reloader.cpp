@@ -0,0 +1,220 @@
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "dictionary.hpp"
+#include "reloader.hpp"
+#include "temp_path.hpp"
+
+class ReloaderTest : public ::testing::Test {
+   protected:
+    std::string path = temp_path("reloader_test") + ".csv";
+
+    void write(const std::vector<std::string> &texts, const std::string &target) {
+        std::ofstream file(target, std::ios::trunc);
+        file << "text,pos,definition\n";
+        for (const std::string &text : texts) {
+            file << text << ",noun,\"A word.\"\n";
+        }
+    }
+
+    void TearDown() override {
+        unlink(path.c_str());
+    }
+};
+
+TEST_F(ReloaderTest, ReloadSwapsSnapshot) {
+    write({"cat", "dog"}, path);
+    Reloader reloader([](Dictionary &dict) {
+        dict.set_cache_capacity(16);
+        return true;
+    });
+    ASSERT_TRUE(reloader.load(path));
+    std::shared_ptr<Dictionary> old = reloader.get();
+    ASSERT_NE(old->get_cache(), nullptr);
+
+    write({"cat", "cow", "owl"}, path);
+    ASSERT_TRUE(reloader.reload());
+    EXPECT_EQ(reloader.get_reload_count(), 1);
+    EXPECT_NE(reloader.get()->get_cache(), nullptr);
+    EXPECT_EQ(reloader.get()->get_word_count(), 3);
+
+    // The old snapshot is untouched and lives exactly as long as its last reader
+    EXPECT_EQ(old->get_word_count(), 2);
+    EXPECT_EQ(old->search("dog")[0]->get_text(), "dog");
+    std::weak_ptr<Dictionary> weak = old;
+    old.reset();
+    EXPECT_TRUE(weak.expired());
+}
+
+TEST_F(ReloaderTest, FailedReloadKeepsCurrent) {
+    write({"cat"}, path);
+    Reloader reloader([](Dictionary &) { return true; });
+    ASSERT_TRUE(reloader.load(path));
+    std::shared_ptr<Dictionary> current = reloader.get();
+
+    EXPECT_FALSE(reloader.load(path + ".missing"));
+    EXPECT_EQ(reloader.get(), current);
+
+    Reloader refusing([](Dictionary &) { return false; });
+    EXPECT_FALSE(refusing.load(path));
+    EXPECT_EQ(refusing.get(), nullptr);
+}
+
+TEST_F(ReloaderTest, QueriesRunThroughReloads) {
+    write({"cat", "dog"}, path);
+    Reloader reloader;
+    ASSERT_TRUE(reloader.load(path));
+
+    std::atomic<bool> stop = false;
+    std::atomic<size_t> misses = 0;
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&]() {
+            while (stop == false) {
+                std::shared_ptr<Dictionary> dict = reloader.get();
+                auto results = dict->search("cat");
+                if (results.empty() || results[0]->get_text() != "cat") misses += 1;
+            }
+        });
+    }
+    for (int i = 0; i < 20; ++i) {
+        write(i % 2 ? std::vector<std::string>{"cat", "dog"}
+                    : std::vector<std::string>{"cat", "cow", "owl"},
+              path);
+        ASSERT_TRUE(reloader.reload());
+    }
+    stop = true;
+    for (std::thread &reader : readers) {
+        reader.join();
+    }
+    EXPECT_EQ(misses, 0);
+    EXPECT_EQ(reloader.get_reload_count(), 20);
+}
+
+TEST_F(ReloaderTest, WatchReloadsReplacedFile) {
+    write({"cat"}, path);
+    Reloader reloader;
+    ASSERT_TRUE(reloader.load(path));
+    ASSERT_TRUE(reloader.watch());
+
+    // Saved the way editors do: a new file renamed over the old one
+    write({"cat", "cow"}, path + ".new");
+    ASSERT_EQ(std::rename((path + ".new").c_str(), path.c_str()), 0);
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (reloader.get_reload_count() == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(reloader.get_reload_count(), 1);
+    EXPECT_EQ(reloader.get()->get_word_count(), 2);
+    reloader.stop_watching();
+}
+
+TEST_F(ReloaderTest, JournalMovesToReloadedDictionary) {
+    write({"cat"}, path);
+    std::string log_path = temp_path("reloader_test") + ".journal";
+    unlink(log_path.c_str());
+    Reloader reloader;
+    ASSERT_TRUE(reloader.load(path));
+    ASSERT_TRUE(reloader.get()->open_journal(log_path, path, 0));
+
+    // Writers insert through whichever snapshot they hold while the file is reloaded
+    auto make_text = [](int writer, int i) {
+        return std::string(1, static_cast<char>('a' + writer)) +
+               static_cast<char>('a' + i / 26) + static_cast<char>('a' + i % 26) + "zz";
+    };
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 4; ++t) {
+        writers.emplace_back([&, t]() {
+            for (int i = 0; i < 200; ++i) {
+                EXPECT_TRUE(reloader.get()->insert(std::make_shared<Word>(make_text(t, i))));
+            }
+        });
+    }
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_TRUE(reloader.reload());
+    }
+    for (std::thread &writer : writers) {
+        writer.join();
+    }
+    std::shared_ptr<Dictionary> dict = reloader.get();
+    EXPECT_EQ(dict->get_word_count(), 1 + 4 * 200);
+    for (int t = 0; t < 4; ++t) {
+        for (int i = 0; i < 200; ++i) {
+            EXPECT_TRUE(dict->contains(make_text(t, i)));
+        }
+    }
+
+    // One log, now owned by the current dictionary, which checkpoints it
+    EXPECT_NE(dict->get_journal(), nullptr);
+    ASSERT_TRUE(dict->checkpoint());
+    ASSERT_TRUE(reloader.reload());
+    EXPECT_EQ(reloader.get()->get_word_count(), 1 + 4 * 200);
+    unlink(log_path.c_str());
+}
+
+TEST_F(ReloaderTest, WatchSkipsOwnCheckpoint) {
+    write({"cat"}, path);
+    std::string log_path = temp_path("reloader_test") + ".journal";
+    unlink(log_path.c_str());
+    Reloader reloader;
+    ASSERT_TRUE(reloader.load(path));
+    ASSERT_TRUE(reloader.get()->open_journal(log_path, path, 0));
+    ASSERT_TRUE(reloader.watch());
+
+    ASSERT_TRUE(reloader.get()->insert(std::make_shared<Word>("cow")));
+    ASSERT_TRUE(reloader.get()->checkpoint());
+    std::this_thread::sleep_for(std::chrono::milliseconds(600));
+    EXPECT_EQ(reloader.get_reload_count(), 0);
+
+    // Someone else replacing the file still reloads
+    write({"cat", "cow", "owl"}, path + ".new");
+    ASSERT_EQ(std::rename((path + ".new").c_str(), path.c_str()), 0);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (reloader.get_reload_count() == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(reloader.get_reload_count(), 1);
+    EXPECT_EQ(reloader.get()->get_word_count(), 3);
+    reloader.stop_watching();
+    unlink(log_path.c_str());
+}
+
+TEST_F(ReloaderTest, UpdateReachesDictionaryAfterReload) {
+    write({"cat"}, path);
+    std::mutex mutex;
+    size_t capacity = 8;
+    Reloader reloader([&](Dictionary &dict) {
+        std::lock_guard<std::mutex> lock(mutex);
+        dict.set_cache_capacity(capacity);
+        return true;
+    });
+    ASSERT_TRUE(reloader.load(path));
+
+    // Each change lands on whichever dictionary a concurrent reload swapped in
+    std::thread reloads([&]() {
+        for (int i = 0; i < 20; ++i) {
+            EXPECT_TRUE(reloader.reload());
+        }
+    });
+    for (size_t next = 16; next <= 16 * 20; next += 16) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            capacity = next;
+        }
+        reloader.update([next](Dictionary &dict) { dict.set_cache_capacity(next); });
+    }
+    reloads.join();
+    EXPECT_EQ(reloader.get()->get_cache()->get_capacity(), 16 * 20);
+}
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "client.hpp"
+#include "dictionary.hpp"
+#include "server.hpp"
+#include "temp_path.hpp"
+
+class ServerTest : public ::testing::Test {
+   protected:
+    Dictionary dict;
+    std::unique_ptr<Server> server;
+    std::thread thread;
+    std::string path = temp_path("server_test") + ".sock";
+
+    void SetUp() override {
+        for (const char *text : {"cat", "cut", "coat", "cart", "card", "dog"}) {
+            dict.insert(std::make_shared<Word>(text));
+        }
+        server = std::make_unique<Server>(dict, 2);
+        ASSERT_TRUE(server->listen_unix(path));
+        thread = std::thread([this]() { server->run(); });
+    }
+
+    void TearDown() override {
+        server->stop();
+        thread.join();
+        server.reset();
+    }
+};
+
+TEST(ServerFormatTest, FormatResponse) {
+    EXPECT_EQ(format_response({}), "0\n");
+    EXPECT_EQ(format_response({std::make_shared<Word>("cat"), std::make_shared<Word>("cut")}),
+              "2 cat cut\n");
+}
+
+TEST_F(ServerTest, AnswersEveryMode) {
+    Client client;
+    ASSERT_TRUE(client.connect_unix(path));
+    std::vector<std::string> words;
+
+    ASSERT_TRUE(client.query("cat", words));
+    EXPECT_EQ(words, std::vector<std::string>{"cat"});
+
+    ASSERT_TRUE(client.query("car_", words));
+    EXPECT_EQ(words, (std::vector<std::string>{"card", "cart"}));
+
+    ASSERT_TRUE(client.query("c?t", words));
+    EXPECT_EQ(words, (std::vector<std::string>{"cat", "cut"}));
+
+    ASSERT_TRUE(client.query("dgo", words));
+    EXPECT_NE(std::find(words.begin(), words.end(), "dog"), words.end());
+
+    ASSERT_TRUE(client.query("ca@t", words));
+    EXPECT_TRUE(words.empty());
+}
+
+TEST_F(ServerTest, PipelinedQueriesKeepOrder) {
+    std::vector<std::string> queries = {"coat", "c?t", "dog", "cxt", "car_", "cart"};
+    std::vector<std::unique_ptr<Client>> clients;
+    for (int i = 0; i < 3; ++i) {
+        clients.push_back(std::make_unique<Client>());
+        ASSERT_TRUE(clients.back()->connect_unix(path));
+        for (const std::string &query : queries) {
+            ASSERT_TRUE(clients.back()->send_query(query));
+        }
+    }
+    for (auto &client : clients) {
+        std::vector<std::string> words;
+        for (const std::string &query : queries) {
+            ASSERT_TRUE(client->receive(words));
+            std::vector<std::string> expected;
+            for (const auto &word : dict.search(query)) {
+                expected.push_back(word->get_text());
+            }
+            EXPECT_EQ(words, expected) << "query: " << query;
+        }
+    }
+}
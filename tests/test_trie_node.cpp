@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 
+#include <string>
+
 #include "trie_node.hpp"
 #include "word.hpp"
 
@@ -10,7 +12,42 @@ TEST(TrieNodeTest, SetAndGetChild) {
     EXPECT_NE(child, nullptr);
     EXPECT_EQ(node.get_child('c'), child);
 
-    EXPECT_TRUE(node.get_children().find('c') != node.get_children().end());
+    EXPECT_TRUE(node.has_child('c'));
+    EXPECT_FALSE(node.has_child('d'));
+}
+
+TEST(TrieNodeTest, ChildrenSorted) {
+    Trie::Node node;
+    node.set_child('m');
+    node.set_child('a');
+    node.set_child('z');
+    node.set_child('a');
+
+    ASSERT_EQ(node.child_count(), 3);
+    EXPECT_EQ(node.child_key(0), 'a');
+    EXPECT_EQ(node.child_key(1), 'm');
+    EXPECT_EQ(node.child_key(2), 'z');
+    EXPECT_EQ(node.child_at(1), node.get_child('m'));
+}
+
+TEST(TrieNodeTest, AlphaNodeChildren) {
+    Trie::AlphaNode<Trie::Lowercase> node;
+    for (char c : {'m', 'a', 'z', 'a', 'q'}) {
+        EXPECT_NE(node.set_child(c), nullptr);
+    }
+    ASSERT_EQ(node.child_count(), 4);
+    std::string keys;
+    for (size_t i = 0; i < node.child_count(); ++i) {
+        keys += node.child_key(i);
+        EXPECT_EQ(node.child_at(i), node.get_child(node.child_key(i)));
+    }
+    EXPECT_EQ(keys, "amqz");
+
+    // Outside the alphabet, on either side of the range
+    EXPECT_EQ(node.set_child('A'), nullptr);
+    EXPECT_EQ(node.set_child('{'), nullptr);
+    EXPECT_FALSE(node.has_child('-'));
+    EXPECT_EQ(node.child_count(), 4);
 }
 
 TEST(TrieNodeTest, SetAndGetWord) {
@@ -133,3 +133,127 @@ TEST(TrieTreeTest, MatchMultiplePatterns) {
 
     EXPECT_GE(tree.get_memory_usage(), 0);
 }
+
+TEST(TrieTreeTest, SuggestLexicographicOrder) {
+    Trie::Tree tree;
+    tree.insert(std::make_shared<Word>("bat"));
+    tree.insert(std::make_shared<Word>("ball"));
+    tree.insert(std::make_shared<Word>("b"));
+    tree.insert(std::make_shared<Word>("bake"));
+    tree.insert(std::make_shared<Word>("bay"));
+
+    auto words = to_words(tree.suggest("b", 10));
+
+    std::vector<std::string> expected = {"b", "bake", "ball", "bat", "bay"};
+    EXPECT_EQ(words, expected);
+}
+
+TEST(TrieTreeTest, SuggestPagination) {
+    Trie::Tree tree;
+    for (const char* text : {"car", "card", "care", "cart", "cat", "cab", "dog"}) {
+        tree.insert(std::make_shared<Word>(text));
+    }
+
+    auto first = to_words(tree.suggest("ca", 3));
+    std::vector<std::string> expected_first = {"cab", "car", "card"};
+    EXPECT_EQ(first, expected_first);
+
+    auto second = to_words(tree.suggest("ca", 3, first.back()));
+    std::vector<std::string> expected_second = {"care", "cart", "cat"};
+    EXPECT_EQ(second, expected_second);
+
+    EXPECT_TRUE(tree.suggest("ca", 3, second.back()).empty());
+    EXPECT_TRUE(tree.suggest("ca", 3, "cz").empty());
+    EXPECT_EQ(to_words(tree.suggest("ca", 1, "c")), std::vector<std::string>{"cab"});
+}
+
+TEST(TrieTreeTest, SuggestStreamPages) {
+    Trie::Tree tree;
+    for (const char* text : {"car", "card", "care", "cart", "cat", "cab", "dog"}) {
+        tree.insert(std::make_shared<Word>(text));
+    }
+
+    auto stream = tree.suggest_stream("ca");
+    EXPECT_EQ(to_words(stream.take(2)), (std::vector<std::string>{"cab", "car"}));
+    EXPECT_EQ(to_words(stream.take(2)), (std::vector<std::string>{"card", "care"}));
+    EXPECT_EQ(to_words(stream.take(5)), (std::vector<std::string>{"cart", "cat"}));
+    EXPECT_FALSE(stream.next().has_value());
+
+    EXPECT_FALSE(tree.suggest_stream("x").next().has_value());
+}
+
+TEST(TrieTreeTest, MatchStreamAgreesWithMatch) {
+    Trie::Tree tree;
+    for (const char* text : {"tv", "to", "cute", "t", "cat", "text", "caught", "cart"}) {
+        tree.insert(std::make_shared<Word>(text));
+    }
+
+    for (const char* pattern : {"*t?", "ca+t", "c?t", "*", "c*"}) {
+        std::vector<std::string> streamed;
+        for (const auto& word : tree.match_stream(pattern)) {
+            streamed.push_back(word->get_text());
+        }
+        EXPECT_EQ(streamed, to_words(tree.match(pattern, 100))) << "pattern: " << pattern;
+    }
+}
+
+TEST(TrieTreeTest, LowercaseTreeAgreesWithGeneric) {
+    Trie::Tree generic;
+    Trie::LowercaseTree lowercase;
+    for (const char* text : {"tv", "to", "cute", "t", "cat", "text", "caught", "cart", "zebra"}) {
+        generic.insert(std::make_shared<Word>(text));
+        EXPECT_TRUE(lowercase.insert(std::make_shared<Word>(text)));
+    }
+    EXPECT_FALSE(lowercase.insert(std::make_shared<Word>("Cat")));
+    EXPECT_FALSE(lowercase.insert(std::make_shared<Word>("t-shirt")));
+    EXPECT_EQ(lowercase.search("t-shirt"), nullptr);
+    EXPECT_EQ(lowercase.search("t")->get_text(), "t");
+
+    for (const char* pattern : {"*t?", "ca+t", "c?t", "*", "c*", "Ca*"}) {
+        EXPECT_EQ(to_words(lowercase.match(pattern, 100)), to_words(generic.match(pattern, 100)))
+            << "pattern: " << pattern;
+    }
+    for (const char* prefix : {"", "c", "ca", "x"}) {
+        EXPECT_EQ(to_words(lowercase.suggest(prefix, 100)), to_words(generic.suggest(prefix, 100)))
+            << "prefix: " << prefix;
+    }
+}
+
+TEST(TrieTreeTest, IncrementalStatistics) {
+    Trie::LowercaseTree tree;
+    EXPECT_EQ(tree.get_node_count(), 1);
+    EXPECT_EQ(tree.get_height(), 1);
+
+    tree.insert(std::make_shared<Word>("car"));
+    EXPECT_EQ(tree.get_node_count(), 4);
+    EXPECT_EQ(tree.get_height(), 4);
+
+    tree.insert(std::make_shared<Word>("cart"));  // One new node
+    tree.insert(std::make_shared<Word>("car"));   // Nothing new
+    tree.insert(std::make_shared<Word>("do"));
+    EXPECT_EQ(tree.get_node_count(), 7);
+    EXPECT_EQ(tree.get_height(), 5);
+    EXPECT_GE(tree.get_memory_usage(), 7 * sizeof(Trie::AlphaNode<Trie::Lowercase>));
+    EXPECT_TRUE(tree.audit());
+}
+
+TEST(TrieTreeTest, RemovePrunesEmptyBranches) {
+    Trie::LowercaseTree tree;
+    for (const char* text : {"car", "cart", "do"}) {
+        tree.insert(std::make_shared<Word>(text));
+    }
+    EXPECT_EQ(tree.remove("ca"), nullptr);  // Only a prefix
+    EXPECT_EQ(tree.remove("cat"), nullptr);
+
+    ASSERT_NE(tree.remove("cart"), nullptr);
+    EXPECT_EQ(tree.search("cart"), nullptr);
+    EXPECT_NE(tree.search("car"), nullptr);
+    EXPECT_EQ(tree.get_node_count(), 6);
+    EXPECT_EQ(tree.get_height(), 4);
+
+    ASSERT_NE(tree.remove("car"), nullptr);  // The whole branch goes
+    EXPECT_EQ(tree.get_node_count(), 3);
+    EXPECT_EQ(tree.get_height(), 3);
+    EXPECT_TRUE(tree.suggest("c", 10).empty());
+    EXPECT_TRUE(tree.audit());
+}
@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "utf8.hpp"
+
+TEST(Utf8Test, AsciiChecks) {
+    EXPECT_TRUE(Utf8::is_ascii("a longer plain ascii text"));
+    EXPECT_FALSE(Utf8::is_ascii("a longer text ending in é"));
+    EXPECT_TRUE(Utf8::is_key_ascii("apple"));
+    EXPECT_FALSE(Utf8::is_key_ascii("Apple"));
+    EXPECT_FALSE(Utf8::is_key_ascii("café"));
+}
+
+TEST(Utf8Test, DecodeAndEncode) {
+    std::u32string code_points;
+    ASSERT_TRUE(Utf8::decode("aé€😀", code_points));
+    EXPECT_EQ(code_points, U"aé€😀");
+    std::string text;
+    for (char32_t code_point : code_points) Utf8::encode(code_point, text);
+    EXPECT_EQ(text, "aé€😀");
+    EXPECT_EQ(Utf8::length("aé€😀"), 4);
+}
+
+TEST(Utf8Test, DecodeRejectsMalformed) {
+    std::u32string code_points;
+    EXPECT_FALSE(Utf8::decode("\x80", code_points));          // Stray continuation byte
+    EXPECT_FALSE(Utf8::decode("caf\xC3", code_points));       // Truncated sequence
+    EXPECT_FALSE(Utf8::decode("\xC0\xAF", code_points));      // Overlong '/'
+    EXPECT_FALSE(Utf8::decode("\xED\xA0\x80", code_points));  // Surrogate
+    EXPECT_FALSE(Utf8::decode("\xF4\x90\x80\x80", code_points));  // Past U+10FFFF
+    EXPECT_EQ(Utf8::normalize("caf\xC3"), "");
+}
+
+TEST(Utf8Test, NormalizeFoldsAndComposes) {
+    EXPECT_EQ(Utf8::normalize("Apple"), "apple");
+    EXPECT_EQ(Utf8::normalize("CAFÉ"), "café");
+    EXPECT_EQ(Utf8::normalize("cafe\xCC\x81"), "café");  // Combining acute accent
+    EXPECT_EQ(Utf8::normalize("ΣΟΦΙΑ"), "σοφια");
+    EXPECT_EQ(Utf8::normalize("Ёлка"), "ёлка");
+    EXPECT_EQ(Utf8::normalize("straße"), "straße");  // No one to one fold
+    EXPECT_EQ(Utf8::normalize("x\xCC\x81"), "x\xCC\x81");  // Nothing to compose with
+}
+
+TEST(Utf8Test, Letters) {
+    EXPECT_TRUE(Utf8::is_letter(U'é'));
+    EXPECT_TRUE(Utf8::is_letter(U'ж'));
+    EXPECT_TRUE(Utf8::is_letter(0x0301));  // Combining acute accent
+    EXPECT_FALSE(Utf8::is_letter(U'€'));
+    EXPECT_FALSE(Utf8::is_letter(U'1'));
+    EXPECT_TRUE(Utf8::is_letters("naïve"));
+    EXPECT_FALSE(Utf8::is_letters("naïve!"));
+    EXPECT_FALSE(Utf8::is_letters("caf\xC3"));
+}
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "dictionary.hpp"
+#include "workload.hpp"
+
+TEST(WorkloadTest, GeneratedQueriesAreValid) {
+    Workload workload(7);
+    for (const char *text : {"a", "cat", "banana", "dictionary", "station"}) {
+        workload.add_word(text);
+    }
+    Mix mix;
+    auto requests = workload.generate(2000, mix);
+    ASSERT_EQ(requests.size(), 2000);
+
+    Dictionary dict;
+    for (const Request &request : requests) {
+        Mode mode = dict.recognize(request.query);
+        EXPECT_NE(mode, Mode::None) << "query: " << request.query;
+        if (request.kind == QueryKind::Prefix) {
+            EXPECT_EQ(mode, Mode::Suggest);
+        }
+        if (request.kind == QueryKind::Pattern) {
+            EXPECT_EQ(mode, Mode::Match);
+        }
+    }
+}
+
+TEST(WorkloadTest, TypoStaysWithinDistance) {
+    Workload workload(11);
+    Dictionary dict;
+    auto word = std::make_shared<Word>("typewriter");
+    dict.insert(word);
+
+    for (int i = 0; i < 100; ++i) {
+        std::string typo = workload.make_typo("typewriter", 1);
+        auto results = dict.search(typo);  // Default max-distance is 2
+        ASSERT_EQ(results.size(), 1) << "typo: " << typo;
+        EXPECT_EQ(results[0], word);
+    }
+    EXPECT_EQ(workload.make_typo("", 1).size(), 1);  // Only an insertion fits
+}
+
+TEST(WorkloadTest, ParseMix) {
+    Mix mix;
+    EXPECT_TRUE(parse_mix("exact:1,typo3:2,pattern:0", mix));
+    EXPECT_EQ(mix.exact, 1);
+    EXPECT_EQ(mix.typo3, 2);
+    EXPECT_EQ(mix.pattern, 0);
+    EXPECT_EQ(mix.miss, 0);
+    EXPECT_FALSE(parse_mix("fuzzy:3", mix));
+    EXPECT_FALSE(parse_mix("exact:-1,miss:2", mix));
+    EXPECT_FALSE(parse_mix("exact:lots", mix));
+    EXPECT_FALSE(parse_mix("exact:0,miss:0", mix));  // Nothing to generate
+    EXPECT_FALSE(parse_mix("", mix));
+}
+
+TEST(WorkloadTest, Percentiles) {
+    LatencyRecorder recorder;
+    for (uint64_t i = 1; i <= 1000; ++i) {
+        recorder.add(QueryKind::Exact, i);
+    }
+    EXPECT_EQ(recorder.get_count(QueryKind::Exact), 1000);
+    EXPECT_EQ(recorder.get_percentile(QueryKind::Exact, 50), 500);
+    EXPECT_EQ(recorder.get_percentile(QueryKind::Exact, 99), 990);
+    EXPECT_EQ(recorder.get_percentile(QueryKind::Exact, 100), 1000);
+    EXPECT_EQ(recorder.get_percentile(QueryKind::Miss, 50), 0);
+}
@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "xor_filter.hpp"
+
+TEST(XorFilterTest, NoFalseNegatives) {
+    std::mt19937_64 rng(1);
+    std::vector<uint64_t> keys(50000);
+    for (uint64_t &key : keys) key = rng();
+    keys.push_back(keys.front());  // Duplicates are dropped
+
+    Filter::Xor8 filter;
+    filter.build(keys);
+    EXPECT_EQ(filter.get_key_count(), 50000);
+    for (uint64_t key : keys) {
+        ASSERT_TRUE(filter.contains(key));
+    }
+    // About 1.23 bytes per key
+    EXPECT_LT(filter.get_memory_usage(), 50000 * 13 / 10);
+}
+
+TEST(XorFilterTest, FalsePositiveRate) {
+    std::vector<uint64_t> keys;
+    for (int i = 0; i < 20000; ++i) keys.push_back(Filter::hash("word" + std::to_string(i)));
+    Filter::Xor8 filter;
+    filter.build(keys);
+
+    size_t positives = 0;
+    for (int i = 0; i < 100000; ++i) {
+        positives += filter.contains(Filter::hash("miss" + std::to_string(i)));
+    }
+    double rate = positives / 100000.0;
+    EXPECT_LT(rate, 0.01);  // 1/256 expected
+    EXPECT_NEAR(filter.get_false_positive_rate(), rate, 0.005);
+}
+
+TEST(XorFilterTest, EmptyFilter) {
+    Filter::Xor8 filter;
+    EXPECT_FALSE(filter.contains(42));
+    filter.build({});
+    EXPECT_EQ(filter.get_key_count(), 0);
+    filter.build({7});
+    EXPECT_TRUE(filter.contains(7));
+}